@@ -1,34 +1,101 @@
+#include <algorithm>
+#include <condition_variable>
 #include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
 #include "json.h"
+#include "json_hash.h"
 #include "json_val.h"
+#include "json_walk.h"
 #include "parse.h"
+#include "json_simd.h"
 
 namespace zzjson {  // ------------------- namespace zzjson
 
+namespace {
+
+template <class String>
+void AppendNumber(String& res, double val) {
+    char buf[32];
+    // enough to convert a double to a string
+    int len = snprintf(buf, sizeof(buf), "%.17g", val);
+    res.append(buf, len);
+}
+
+}  // namespace
+
 /**
  * 构造函数
  */
-Json::Json(std::nullptr_t) : _jsonVal(std::make_unique<JsonValue>(nullptr)) {}
+Json::Json(std::nullptr_t, const allocator_type& alloc)
+    : _jsonVal(NewIn<JsonValue>(alloc.resource(), nullptr, alloc)) {}
+
+Json::Json(bool val, const allocator_type& alloc)
+    : _jsonVal(NewIn<JsonValue>(alloc.resource(), val, alloc)) {}
 
-Json::Json(bool val) : _jsonVal(std::make_unique<JsonValue>(val)) {}
+Json::Json(double val, const allocator_type& alloc)
+    : _jsonVal(NewIn<JsonValue>(alloc.resource(), val, alloc)) {}
 
-Json::Json(double val) : _jsonVal(std::make_unique<JsonValue>(val)) {}
+Json::Json(std::string_view val, const allocator_type& alloc)
+    : _jsonVal(NewIn<JsonValue>(alloc.resource(), val, alloc)) {}
 
-Json::Json(const std::string& val)
-    : _jsonVal(std::make_unique<JsonValue>(val)) {}
+Json::Json(const _string& val, const allocator_type& alloc)
+    : _jsonVal(NewIn<JsonValue>(alloc.resource(), std::string_view(val), alloc)) {}
 
-Json::Json(std::string&& val)
-    : _jsonVal(std::make_unique<JsonValue>(std::move(val))) {}
+/**
+ * resource 相同时接管 val 的缓冲区，否则拷贝到 alloc 中
+ */
+Json::Json(_string&& val, const allocator_type& alloc)
+    : _jsonVal(NewIn<JsonValue>(alloc.resource(), std::move(val), alloc)) {}
 
-Json::Json(const _array& val) : _jsonVal(std::make_unique<JsonValue>(val)) {}
+Json::Json(const _array& val, const allocator_type& alloc)
+    : _jsonVal(NewIn<JsonValue>(alloc.resource(), val, alloc)) {}
 
-Json::Json(_array&& val)
-    : _jsonVal(std::make_unique<JsonValue>(std::move(val))) {}
+Json::Json(_array&& val, const allocator_type& alloc)
+    : _jsonVal(NewIn<JsonValue>(alloc.resource(), std::move(val), alloc)) {}
 
-Json::Json(const _obj& val) : _jsonVal(std::make_unique<JsonValue>(val)) {}
+Json::Json(const _obj& val, const allocator_type& alloc)
+    : _jsonVal(NewIn<JsonValue>(alloc.resource(), val, alloc)) {}
 
-Json::Json(_obj&& val)
-    : _jsonVal(std::make_unique<JsonValue>(std::move(val))) {}
+Json::Json(_obj&& val, const allocator_type& alloc)
+    : _jsonVal(NewIn<JsonValue>(alloc.resource(), std::move(val), alloc)) {}
+
+Json Json::packNumbers(const std::vector<double>& numbers,
+                       const allocator_type& alloc) {
+    return PackNumbers(std::pmr::vector<double>(numbers.begin(), numbers.end(),
+                                                alloc.resource()));
+}
+
+Json Json::packBools(const std::vector<uint8_t>& bools, const allocator_type& alloc) {
+    return PackBools(std::pmr::vector<uint8_t>(bools.begin(), bools.end(),
+                                               alloc.resource()));
+}
+
+Json Json::PackNumbers(std::pmr::vector<double>&& numbers) {
+    auto resource = numbers.get_allocator().resource();
+    Json res{allocator_type(resource)};
+    res._jsonVal.reset(NewIn<JsonValue>(
+        resource, PackedPtr(NewIn<PackedArray>(resource, std::move(numbers)))));
+    return res;
+}
+
+Json Json::PackBools(std::pmr::vector<uint8_t>&& bools) {
+    auto resource = bools.get_allocator().resource();
+    Json res{allocator_type(resource)};
+    res._jsonVal.reset(NewIn<JsonValue>(
+        resource, PackedPtr(NewIn<PackedArray>(resource, std::move(bools)))));
+    return res;
+}
+
+Json Json::LazyNumber(std::string_view text, const allocator_type& alloc) {
+    Json res{alloc};
+    res._jsonVal.reset(NewIn<JsonValue>(alloc.resource(), std::in_place_type<RawNumber>,
+                                        text, alloc));
+    return res;
+}
 
 /**
  * 析构函数
@@ -36,44 +103,222 @@ Json::Json(_obj&& val)
 Json::~Json() = default;
 
 /**
- * 拷贝构造
+ * 含有子节点的数组 / 对象先把子节点的 JsonValue 摘下放入工作表，
+ * 再释放自己：此时子节点都已是空的 Json，不再向下递归.
+ * 工作表放不下 (bad_alloc) 的子树退回到原来的递归释放.
+ * 共享的子树在最后一个引用释放时以同样的方式释放.
  */
-Json::Json(const Json& rhs) {
-    switch (rhs.getType()) {
-        case JsonType::m_nullptr: {
-            _jsonVal = std::make_unique<JsonValue>(nullptr);
-            break;
+void Json::ValueDeleter::operator()(JsonValue* val) const noexcept {
+    if (!val) return;
+    std::vector<JsonValue*> work;
+    auto detach = [&](JsonValue& node) {
+        auto take = [&](Json& child) {
+            JsonValue* sub = child._jsonVal.get();
+            if (!sub) return;
+            auto arr = sub->ownedArray();
+            auto obj = sub->ownedObj();
+            if ((arr && !arr->empty()) || (obj && !obj->empty())) {
+                try {
+                    work.push_back(sub);
+                    child._jsonVal.release();
+                } catch (const std::bad_alloc&) {
+                }
+            }
+        };
+        if (auto arr = node.ownedArray()) {
+            for (auto& child : *arr) take(child);
+        } else if (auto obj = node.ownedObj()) {
+            for (auto& p : *obj) take(p.second);
         }
-        case JsonType::m_bool: {
-            _jsonVal = std::make_unique<JsonValue>(rhs.toBool());
-            break;
+    };
+    detach(*val);
+    DeleteIn(val->resource(), val);
+    while (!work.empty()) {
+        JsonValue* node = work.back();
+        work.pop_back();
+        detach(*node);
+        DeleteIn(node->resource(), node);
+    }
+}
+
+/**
+ * 后台释放的线程：第一次使用时启动.
+ * 有意不析构：在它之前构造的静态对象 (例如命名空间作用域的 SharedJson) 在它之后析构，
+ * 仍然会调用 releaseAsync().  进程退出时由 atexit 停止线程并释放完队列中剩余的文档，
+ * 之后的 push() 返回 false，由调用者直接释放.
+ */
+class Json::Reaper {
+public:
+    static Reaper& instance() {
+        static Reaper* reaper = new Reaper;
+        return *reaper;
+    }
+
+    bool push(JsonValue* val) {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_stop) return false;
+            _queue.push_back(val);
         }
-        case JsonType::m_number: {
-            _jsonVal = std::make_unique<JsonValue>(rhs.toDouble());
-            break;
+        _cond.notify_one();
+        return true;
+    }
+
+private:
+    Reaper() : _thread([this] { run(); }) {
+        // 在 instance() 的初始化中注册，早于之后构造的静态对象的析构函数执行
+        std::atexit([] { instance().stop(); });
+    }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
         }
-        case JsonType::m_string: {
-            _jsonVal = std::make_unique<JsonValue>(rhs.toString());
-            break;
+        _cond.notify_one();
+        _thread.join();
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(_mutex);
+        while (true) {
+            _cond.wait(lock, [this] { return _stop || !_queue.empty(); });
+            if (_queue.empty()) return;
+            std::deque<JsonValue*> batch;
+            batch.swap(_queue);
+            lock.unlock();
+            for (JsonValue* val : batch) ValueDeleter()(val);
+            lock.lock();
         }
-        case JsonType::m_array: {
-            _jsonVal = std::make_unique<JsonValue>(rhs.toArray());
-            break;
+    }
+
+private:
+    std::mutex _mutex;
+    std::condition_variable _cond;
+    std::deque<JsonValue*> _queue;
+    bool _stop = false;
+    std::thread _thread;
+};
+
+/**
+ * 线程或队列创建失败、或者进程正在退出时直接释放
+ */
+void Json::releaseAsync(Json&& json) noexcept {
+    if (!json._jsonVal) return;
+    if (json._jsonVal->resource() != std::pmr::new_delete_resource()) {
+        json._jsonVal.reset();
+        return;
+    }
+    bool queued = false;
+    try {
+        queued = Reaper::instance().push(json._jsonVal.get());
+    } catch (...) {
+    }
+    if (queued)
+        json._jsonVal.release();
+    else
+        json._jsonVal.reset();
+}
+
+/**
+ * 拷贝构造
+ */
+Json::Json(const Json& rhs) : Json(rhs, allocator_type()) {}
+
+/**
+ * 不递归：先序遍历 rhs，每个节点先在父容器中构造为 null，再原地改为对应的值；
+ * 数组预先 reserve，已构造的元素的地址不变.  遍历用的栈也分配在 alloc 中
+ */
+Json::Json(const Json& rhs, const allocator_type& alloc)
+    : _jsonVal(NewIn<JsonValue>(alloc.resource(), nullptr, alloc)) {
+    std::pmr::vector<Json*> parents(alloc.resource());
+    JsonCursor cur(rhs, alloc.resource());
+    while (cur.next()) {
+        if (cur.kind() == WalkKind::kLeave) {
+            parents.pop_back();
+            continue;
         }
-        case JsonType::m_obj: {
-            _jsonVal = std::make_unique<JsonValue>(rhs.toObj());
-            break;
+        Json* dst = this;
+        if (!parents.empty()) {
+            JsonValue& parent = *parents.back()->_jsonVal;
+            dst = cur.key() ? &parent.reuseObj().try_emplace(*cur.key(), nullptr).first->second
+                            : &parent.reuseArray().emplace_back(nullptr);
+        }
+        if (cur.kind() != WalkKind::kEnter) {
+            dst->AssignShallow(cur.value());
+        } else if (dst->AssignShallow(cur.value())) {
+            parents.push_back(dst);
+        } else {
+            cur.skip();
         }
-        default: { break; }
     }
 }
 
+/**
+ * 拷贝 src 的顶层：标量、共享的子树 (resource 相同时只拷贝引用) 和紧凑数组完整拷贝，
+ * 返回 false；数组 / 对象只建立空的容器，返回 true，子节点由调用者逐个加入
+ */
+bool Json::AssignShallow(const Json& src) {
+    auto resource = _jsonVal->resource();
+    if (SharedPtr node = src._jsonVal->sharedPtr();
+        node && src._jsonVal->resource() == resource) {
+        _jsonVal->share(std::move(node));
+        return false;
+    }
+    return src._jsonVal->visit(Overloaded{
+        [&](std::nullptr_t) { return false; },
+        [&](bool val) {
+            _jsonVal->assign(val);
+            return false;
+        },
+        [&](double val) {
+            _jsonVal->assign(val);
+            return false;
+        },
+        [&](const RawNumber& raw) {
+            _jsonVal->assignRaw(raw.text());
+            return false;
+        },
+        [&](const _string& val) {
+            _jsonVal->reuseString() = val;
+            return false;
+        },
+        [&](const PackedArray& packed) {
+            _jsonVal.reset(NewIn<JsonValue>(
+                resource, PackedPtr(NewIn<PackedArray>(resource, packed, resource))));
+            return false;
+        },
+        [&](const _array& arr) {
+            _jsonVal->reuseArray().reserve(arr.size());
+            return true;
+        },
+        [&](const _obj& obj) {
+            _jsonVal->reuseObj().reserve(obj.size());
+            return true;
+        },
+    });
+}
+
+/**
+ * resource 相同时直接接管节点，否则拷贝
+ */
+Json::Json(Json&& rhs, const allocator_type& alloc) {
+    if (rhs._jsonVal && rhs._jsonVal->resource() == alloc.resource())
+        _jsonVal = std::move(rhs._jsonVal);
+    else if (rhs._jsonVal)
+        Json(rhs, alloc).swap(*this);
+}
+
+Json::allocator_type Json::get_allocator() const noexcept {
+    return _jsonVal ? _jsonVal->resource() : std::pmr::get_default_resource();
+}
+
 /**
  * 拷贝赋值
  */
 Json& Json::operator=(const Json& rhs) noexcept {
     // copy && swap
-    Json temp(rhs);
+    Json temp(rhs, get_allocator());
     swap(temp);
     return *this;
 }
@@ -90,38 +335,78 @@ Json& Json::operator=(Json&& rhs) noexcept = default;
  * serialize()  -> 序列化接口
  * errMsg       -> 存储异常消息
  */
-Json Json::parse(const std::string& content, std::string& errMsg) noexcept {
+Json Json::parse(const std::string& content, std::string& errMsg,
+                 const ParseOptions& opts, const allocator_type& alloc) noexcept {
+    StatsScope<ParseStats> stats(opts.stats);
+    if (stats) stats->bytes = content.size();
     try {
-        Parser p(content);
-        return p.parse();
+        Parser p(content, opts, alloc.resource());
+        Json json = p.parse();
+        if (stats) stats->ok = true;
+        stats.finish(&ParseStats::parseTime);
+        return json;
     } catch (JsonExcept& e) {
         errMsg = e.what();
-        return Json(nullptr);
+        stats.finish(&ParseStats::parseTime);
+        return Json(nullptr, alloc);
     }
 }
 
-std::string Json::serialize() const noexcept {
-    switch (_jsonVal->getType()) {
-        case JsonType::m_nullptr:
-            return "null";
-        case JsonType::m_bool:
-            return _jsonVal->toBool() ? "true" : "false";
-        case JsonType::m_number:
-            char buf[32];
-            snprintf(
-                buf, sizeof(buf), "%.17g",
-                _jsonVal
-                    ->toDouble());  // enough to convert a double to a string
-            return std::string(buf);
-        case JsonType::m_string:
-            return SerializeString();
-        case JsonType::m_array:
-            return SerializeArray();
-        default:
-            return SerializeObject();
+bool Json::validate(const char* data, size_t len, std::string& errMsg,
+                    const ParseOptions& opts) noexcept {
+    try {
+        Parser p(data, len, opts);
+        p.validate();
+        return true;
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+        return false;
     }
 }
 
+bool Json::validate(const std::string& content, std::string& errMsg,
+                    const ParseOptions& opts) noexcept {
+    return validate(content.data(), content.size(), errMsg, opts);
+}
+
+std::string Json::serialize(const WriterOptions& opts) const noexcept {
+    StatsScope<SerializeStats> stats(opts.stats);
+    std::string res;
+    SerializeValue(res, opts, 0);
+    if (stats) stats->bytes = res.size();
+    stats.finish(&SerializeStats::serializeTime);
+    return res;
+}
+
+std::pmr::string Json::serialize(const WriterOptions& opts,
+                                 const allocator_type& alloc) const noexcept {
+    StatsScope<SerializeStats> stats(opts.stats);
+    std::pmr::string res(alloc);
+    SerializeValue(res, opts, 0);
+    if (stats) stats->bytes = res.size();
+    stats.finish(&SerializeStats::serializeTime);
+    return res;
+}
+
+void Json::writeString(std::string& res, std::string_view str,
+                       const WriterOptions& opts) noexcept {
+    SerializeString(str, res, opts);
+}
+
+void Json::serializeTo(std::string& res, const WriterOptions& opts,
+                       size_t depth) const noexcept {
+    SerializeValue(res, opts, depth);
+}
+
+void Json::serializeTo(std::pmr::string& res, const WriterOptions& opts,
+                       size_t depth) const noexcept {
+    SerializeValue(res, opts, depth);
+}
+
+void Json::writeNumber(std::string& res, double val) noexcept {
+    AppendNumber(res, val);
+}
+
 /**
  * 类型接口
  */
@@ -164,7 +449,7 @@ double Json::toDouble() const {
     return _jsonVal->toDouble(); 
 }
 
-const std::string& Json::toString() const { 
+std::string_view Json::toString() const { 
     return _jsonVal->toString(); 
 }
 
@@ -176,6 +461,75 @@ const Json::_obj& Json::toObj() const {
     return _jsonVal->toObj(); 
 }
 
+bool Json::isPacked() const noexcept {
+    return _jsonVal->packed() != nullptr;
+}
+
+Span<const double> Json::numbers() const noexcept {
+    auto packed = _jsonVal->packed();
+    if (!packed || packed->isBool()) return {};
+    return {packed->numbers().data(), packed->numbers().size()};
+}
+
+Span<const uint8_t> Json::bools() const noexcept {
+    auto packed = _jsonVal->packed();
+    if (!packed || !packed->isBool()) return {};
+    return {packed->bools().data(), packed->bools().size()};
+}
+
+std::string_view Json::numberText() const noexcept {
+    auto raw = _jsonVal->rawNumber();
+    return raw ? std::string_view(raw->text()) : std::string_view();
+}
+
+Json::_array& Json::mutableArray() {
+    return _jsonVal->mutableArray();
+}
+
+Json::_obj& Json::mutableObj() {
+    return _jsonVal->mutableObj();
+}
+
+Json::_array& Json::MakeArray() {
+    return _jsonVal->makeArray();
+}
+
+Json::_obj& Json::MakeObj() {
+    return _jsonVal->makeObj();
+}
+
+/**
+ * 构建接口
+ */
+void Json::reserve(size_t n) {
+    _jsonVal->reserve(n);
+}
+
+Json& Json::insert(size_t pos, Json val) {
+    _array& arr = mutableArray();
+    if (pos > arr.size()) throw JsonExcept("Error! Out of range!");
+    return *arr.insert(arr.begin() + pos, std::move(val));
+}
+
+size_t Json::erase(size_t pos) {
+    _array& arr = mutableArray();
+    if (pos >= arr.size()) return 0;
+    arr.erase(arr.begin() + pos);
+    return 1;
+}
+
+size_t Json::erase(std::string_view key) {
+    return mutableObj().erase(MemberKey(key));
+}
+
+void Json::clear() {
+    if (isArray()) {
+        mutableArray().clear();
+    } else {
+        mutableObj().clear();
+    }
+}
+
 /**
  * 访问 array / obj 的接口
  */
@@ -188,15 +542,16 @@ Json& Json::operator[](size_t pos) {
     }
 
 const Json& Json::operator[](size_t pos) const {
-    return _jsonVal->operator[](pos);
+    // unique_ptr 不传递 const，显式调用 const 版本以免紧凑数组被转换
+    return static_cast<const JsonValue&>(*_jsonVal)[pos];
 }
 
-Json& Json::operator[](const std::string& key) {
+Json& Json::operator[](std::string_view key) {
     return _jsonVal->operator[](key);
 }
 
-const Json& Json::operator[](const std::string& key) const {
-    return _jsonVal->operator[](key);
+const Json& Json::operator[](std::string_view key) const {
+    return static_cast<const JsonValue&>(*_jsonVal)[key];
 }
 
 void Json::swap(Json& rhs) noexcept {
@@ -207,98 +562,741 @@ void Json::swap(Json& rhs) noexcept {
     swap(_jsonVal, rhs._jsonVal);
 }
 
+JsonValue& Json::Reuse(const allocator_type& alloc) {
+    if (!_jsonVal) _jsonVal.reset(NewIn<JsonValue>(alloc.resource(), nullptr, alloc));
+    return *_jsonVal;
+}
 
-std::string Json::SerializeString() const noexcept {
-    std::string res = "\"";
-    for (auto e : _jsonVal->toString()) {
-        switch (e) {
-            case '\"':
-                res += "\\\"";
-                break;
-            case '\\':
-                res += "\\\\";
+/**
+ * 内存占用
+ * 对象的成员节点按 libstdc++ 的布局估算：next 指针 + 成员 + 缓存的哈希值
+ */
+namespace {
+
+constexpr size_t kMemberNode = sizeof(void*) + sizeof(Json::_obj::value_type) + sizeof(size_t);
+
+void AddString(MemoryUsage& usage, const Json::_string& str) noexcept {
+    static const size_t sso = std::string().capacity();
+    if (str.capacity() <= sso) return;
+    usage.strings += str.capacity() + 1;
+    usage.slack += str.capacity() - str.size();
+}
+
+bool HasSlack(const Json::_string& str) noexcept {
+    static const size_t sso = std::string().capacity();
+    return str.capacity() > std::max(str.size(), sso);
+}
+
+}  // namespace
+
+/**
+ * 共享的子树只计算一次，另加 SharedNode 和 shared_ptr 的控制块.
+ * 不递归：待访问的节点保存在显式的栈中.
+ */
+MemoryUsage Json::memoryUsage() const noexcept {
+    MemoryUsage usage;
+    std::unordered_set<const void*> seen;
+    std::vector<const Json*> pending{this};
+    while (!pending.empty()) {
+        const Json* json = pending.back();
+        pending.pop_back();
+        json->AddMemoryUsage(usage, seen, pending);
+    }
+    return usage;
+}
+
+/**
+ * 只计算自身的存储，子节点放入 pending
+ */
+void Json::AddMemoryUsage(MemoryUsage& usage, std::unordered_set<const void*>& seen,
+                          std::vector<const Json*>& pending) const {
+    if (!_jsonVal) return;
+    usage.nodes += sizeof(JsonValue);
+    if (auto node = _jsonVal->shared()) {
+        if (seen.insert(node).second) {
+            usage.nodes += sizeof(SharedNode) + 2 * sizeof(void*);
+            pending.push_back(&node->json);
+        }
+        return;
+    }
+    if (auto packed = _jsonVal->packed()) {
+        auto& numbers = packed->numbers();
+        auto& bools = packed->bools();
+        usage.packed += sizeof(PackedArray) + numbers.capacity() * sizeof(double) +
+                        bools.capacity();
+        usage.slack += (numbers.capacity() - numbers.size()) * sizeof(double) +
+                       bools.capacity() - bools.size();
+        if (auto boxed = packed->boxedIfAny()) {
+            usage.packed += sizeof(_array) + boxed->capacity() * sizeof(Json) +
+                            boxed->size() * sizeof(JsonValue);
+            usage.slack += sizeof(_array) + boxed->capacity() * sizeof(Json) +
+                           boxed->size() * sizeof(JsonValue);
+        }
+        return;
+    }
+    switch (_jsonVal->getType()) {
+        case JsonType::m_number:
+            if (auto raw = _jsonVal->rawNumber()) AddString(usage, raw->text());
+            break;
+        case JsonType::m_string:
+            AddString(usage, _jsonVal->toString());
+            break;
+        case JsonType::m_array: {
+            auto& arr = _jsonVal->toArray();
+            usage.arrays += arr.capacity() * sizeof(Json);
+            usage.slack += (arr.capacity() - arr.size()) * sizeof(Json);
+            for (auto& val : arr) pending.push_back(&val);
+            break;
+        }
+        case JsonType::m_obj: {
+            auto& obj = _jsonVal->toObj();
+            // 只有一个 bucket 时使用内置的 bucket，不分配
+            if (obj.bucket_count() > 1) usage.objects += obj.bucket_count() * sizeof(void*);
+            usage.objects += obj.size() * kMemberNode;
+            for (auto& p : obj) {
+                AddString(usage, p.first);
+                pending.push_back(&p.second);
+            }
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+/**
+ * 结构哈希
+ * 每种类型使用不同的种子；数组按顺序组合，对象把各成员 (key, value) 的哈希
+ * 相加，与遍历顺序无关.
+ */
+namespace {
+
+enum HashSeed : uint64_t {
+    kHashNull = 1,
+    kHashFalse,
+    kHashTrue,
+    kHashNumber,
+    kHashString,
+    kHashArray,
+    kHashObject
+};
+
+// splitmix64 的收尾
+constexpr uint64_t Mix(uint64_t h) noexcept {
+    h ^= h >> 30;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    h ^= h >> 27;
+    h *= 0x94d049bb133111ebULL;
+    return h ^ (h >> 31);
+}
+
+constexpr uint64_t Combine(uint64_t seed, uint64_t h) noexcept {
+    return Mix(seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
+
+uint64_t HashNumber(double val) noexcept {
+    if (val == 0) val = 0;  // -0.0 == 0.0
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    return Combine(kHashNumber, bits);
+}
+
+uint64_t HashBool(bool val) noexcept { return Mix(val ? kHashTrue : kHashFalse); }
+
+uint64_t HashString(std::string_view str) noexcept {
+    return Combine(kHashString, Fnv1a(str.data(), str.size()));
+}
+
+}  // namespace
+
+uint64_t Json::hash() const noexcept {
+    return Hash(nullptr);
+}
+
+namespace {
+
+/**
+ * 标量和紧凑数组的哈希 (穿过共享的节点)
+ */
+uint64_t LeafHash(const JsonValue& val) noexcept {
+    return val.visit(Overloaded{
+        [](std::nullptr_t) { return Mix(kHashNull); },
+        [](bool val) { return HashBool(val); },
+        [](double val) { return HashNumber(val); },
+        [](const RawNumber& raw) { return HashNumber(raw.value()); },
+        [](const Json::_string& val) { return HashString(val); },
+        [](const PackedArray& packed) {
+            // 与对应的普通数组相同
+            uint64_t h = Mix(kHashArray);
+            for (double num : packed.numbers()) h = Combine(h, HashNumber(num));
+            for (uint8_t b : packed.bools()) h = Combine(h, HashBool(b != 0));
+            return h;
+        },
+        [](const auto&) { return uint64_t(0); },     // 容器由调用者组合
+    });
+}
+
+}  // namespace
+
+/**
+ * 不递归：沿 JsonCursor 后序组合，正在计算的容器的部分结果保存在显式的栈中.
+ * 共享的子树只读，哈希值缓存在 SharedNode 中，已经缓存时不再进入；
+ * 多个线程同时计算时结果相同，重复写入没有关系.
+ */
+uint64_t Json::Hash(HashMemo* memo) const {
+    struct Frame {
+        uint64_t acc;               // 数组：按顺序组合；对象：各成员相加
+        bool isObj;
+        const SharedNode* node;     // 容器本身是共享的节点时，离开时缓存其哈希
+    };
+    std::vector<Frame> frames;
+    uint64_t res = 0;
+    // 一个子树的哈希交给父容器，没有父容器时为结果
+    auto finish = [&](const JsonCursor& cur, uint64_t h) {
+        if (memo) memo->emplace(&cur.value(), h);
+        if (frames.empty()) {
+            res = h;
+        } else if (cur.key()) {
+            frames.back().acc += Combine(HashString(*cur.key()), h);
+        } else {
+            frames.back().acc = Combine(frames.back().acc, h);
+        }
+    };
+
+    JsonCursor cur(*this);
+    while (cur.next()) {
+        const JsonValue& val = *cur.value()._jsonVal;
+        const SharedNode* node = cur.kind() == WalkKind::kLeave ? nullptr : val.shared();
+        uint64_t cached = node ? node->hash.load(std::memory_order_relaxed) : 0;
+        if (cached) {
+            if (cur.kind() == WalkKind::kEnter) cur.skip();
+            finish(cur, cached);
+            continue;
+        }
+        uint64_t h;
+        if (cur.kind() == WalkKind::kLeave) {
+            Frame frame = frames.back();
+            frames.pop_back();
+            h = frame.isObj ? Combine(Mix(kHashObject), frame.acc) : frame.acc;
+            node = frame.node;
+        } else if (cur.kind() == WalkKind::kValue || val.packed()) {
+            if (cur.kind() == WalkKind::kEnter) cur.skip();     // 紧凑数组不生成 boxed 副本
+            h = LeafHash(val);
+        } else {
+            bool isObj = val.getType() == JsonType::m_obj;
+            frames.push_back({isObj ? 0 : Mix(kHashArray), isObj, node});
+            continue;
+        }
+        if (node) node->hash.store(h, std::memory_order_relaxed);
+        finish(cur, h);
+    }
+    return res;
+}
+
+bool Json::isShared() const noexcept {
+    return _jsonVal->shared() != nullptr;
+}
+
+/**
+ * 先记录所有子树的哈希，再按先序遍历：与之前出现过的子树相等时替换为对它的引用，
+ * 不再向下；否则登记后继续向下.  先序遍历保证总是先共享最大的子树.
+ * 第一次出现的子树在遇到相同的子树时才转换为共享的节点，只出现一次的子树保持不变.
+ */
+class Json::Deduper {
+public:
+    /**
+     * 不递归：显式的栈，子节点逆序入栈，访问顺序与递归的先序遍历相同；
+     * 不经过 MutableJsonCursor，它会把已经共享的子树拷贝出来
+     */
+    void run(Json& root) {
+        root.Hash(&_hashes);
+        std::vector<Json*> stack{&root};
+        while (!stack.empty()) {
+            Json& json = *stack.back();
+            stack.pop_back();
+            if (!Visit(json)) continue;
+            size_t mark = stack.size();
+            if (json.isArray()) {
+                for (auto& val : json._jsonVal->reuseArray()) stack.push_back(&val);
+            } else {
+                for (auto& p : json._jsonVal->reuseObj()) stack.push_back(&p.second);
+            }
+            std::reverse(stack.begin() + mark, stack.end());
+        }
+    }
+
+private:
+    struct Candidate {
+        Json* json;
+        SharedPtr node;     // 尚未共享时为空
+    };
+
+    static bool Eligible(const Json& json) {
+        static const size_t sso = std::string().capacity();
+        switch (json.getType()) {
+            case JsonType::m_string:
+                return json.toString().size() > sso;
+            case JsonType::m_array:
+            case JsonType::m_obj:
+                return json.size() != 0;
+            default:
+                return false;
+        }
+    }
+
+    /**
+     * 与之前出现过的子树相等时替换为对它的引用；返回是否还需要访问子节点
+     */
+    bool Visit(Json& json) {
+        if (Eligible(json)) {
+            auto& bucket = _seen[_hashes.at(&json)];
+            for (auto& cand : bucket) {
+                if (cand.json->get_allocator() == json.get_allocator() &&
+                    *cand.json == json) {
+                    json._jsonVal->share(Share(cand));
+                    return false;
+                }
+            }
+            bucket.push_back({&json, json._jsonVal->sharedPtr()});
+        }
+        if (json._jsonVal->shared() || json._jsonVal->packed()) return false;
+        return json.isArray() || json.isObject();
+    }
+
+    /**
+     * 把第一次出现的子树移入 SharedNode，原处替换为引用
+     * 只移动 unique_ptr，子树中已经登记的节点地址不变
+     */
+    static const SharedPtr& Share(Candidate& cand) {
+        if (!cand.node) {
+            auto resource = cand.json->_jsonVal->resource();
+            allocator_type alloc(resource);
+            cand.node = std::allocate_shared<SharedNode>(
+                std::pmr::polymorphic_allocator<SharedNode>(resource),
+                std::move(*cand.json));
+            cand.json->_jsonVal.reset(NewIn<JsonValue>(resource, cand.node, alloc));
+        }
+        return cand.node;
+    }
+
+private:
+    HashMemo _hashes;
+    std::unordered_map<uint64_t, std::vector<Candidate>> _seen;
+};
+
+void Json::dedup() {
+    Deduper().run(*this);
+}
+
+/**
+ * 重新插入 key 有多余容量的成员，最后把 bucket 数降到最少
+ * 共享的子树只读，保持不变.
+ * 不递归：先收紧容器本身再把子节点放入显式的栈，重新插入的成员只移动节点的所有权，
+ * 值的地址不变.
+ */
+void Json::compact() {
+    std::vector<Json*> pending{this};
+    while (!pending.empty()) {
+        JsonValue* val = pending.back()->_jsonVal.get();
+        pending.pop_back();
+        if (!val || val->shared()) continue;
+        if (auto packed = val->mutablePacked()) {
+            packed->compact();
+            continue;
+        }
+        switch (val->getType()) {
+            case JsonType::m_string:
+                val->reuseString().shrink_to_fit();
                 break;
-            case '\b':
-                res += "\\b";
+            case JsonType::m_array: {
+                _array& arr = val->reuseArray();
+                arr.shrink_to_fit();
+                for (auto& child : arr) pending.push_back(&child);
                 break;
-            case '\f':
-                res += "\\f";
+            }
+            case JsonType::m_obj: {
+                _obj& obj = val->reuseObj();
+                std::vector<_obj::node_type> slack;
+                for (auto it = obj.begin(); it != obj.end();) {
+                    if (HasSlack(it->first)) {
+                        slack.push_back(obj.extract(it++));
+                        slack.back().key().shrink_to_fit();
+                    } else {
+                        ++it;
+                    }
+                }
+                for (auto& node : slack) obj.insert(std::move(node));
+                obj.rehash(0);
+                for (auto& p : obj) pending.push_back(&p.second);
                 break;
-            case '\n':
-                res += "\\n";
+            }
+            default:
                 break;
-            case '\r':
-                res += "\\r";
+        }
+    }
+}
+
+namespace {
+
+/**
+ * 控制字符的转义表，代替逐个字符 sprintf("\\u%04X")
+ */
+struct Escape {
+    char text[7];
+    unsigned char len;
+};
+
+constexpr Escape kControlEscape[0x20] = {
+    {"\\u0000", 6}, {"\\u0001", 6}, {"\\u0002", 6}, {"\\u0003", 6},
+    {"\\u0004", 6}, {"\\u0005", 6}, {"\\u0006", 6}, {"\\u0007", 6},
+    {"\\b", 2},     {"\\t", 2},     {"\\n", 2},     {"\\u000B", 6},
+    {"\\f", 2},     {"\\r", 2},     {"\\u000E", 6}, {"\\u000F", 6},
+    {"\\u0010", 6}, {"\\u0011", 6}, {"\\u0012", 6}, {"\\u0013", 6},
+    {"\\u0014", 6}, {"\\u0015", 6}, {"\\u0016", 6}, {"\\u0017", 6},
+    {"\\u0018", 6}, {"\\u0019", 6}, {"\\u001A", 6}, {"\\u001B", 6},
+    {"\\u001C", 6}, {"\\u001D", 6}, {"\\u001E", 6}, {"\\u001F", 6},
+};
+
+/**
+ * pretty 模式下换行并缩进到第 depth 层
+ */
+template <class String>
+void NewLine(String& res, const WriterOptions& opts, size_t depth) {
+    res += '\n';
+    res.append(depth * opts.indent, ' ');
+}
+
+template <class String>
+void AppendU16(String& res, unsigned u) {
+    static const char hex[] = "0123456789ABCDEF";
+    char buf[6] = {'\\', 'u', hex[(u >> 12) & 0xF], hex[(u >> 8) & 0xF],
+                   hex[(u >> 4) & 0xF], hex[u & 0xF]};
+    res.append(buf, sizeof(buf));
+}
+
+/**
+ * asciiOnly：将 [cur, end) 中的 UTF-8 解码并输出为 \uXXXX，
+ * 非法的字节输出为 U+FFFD.
+ */
+template <class String>
+void AppendAsciiOnly(const char* cur, const char* end, String& res) {
+    auto p = reinterpret_cast<const unsigned char*>(cur);
+    auto e = reinterpret_cast<const unsigned char*>(end);
+    while (p != e) {
+        if (*p < 0x80) {
+            res += static_cast<char>(*p++);
+            continue;
+        }
+        long n = *p >= 0xF0 ? 4 : *p >= 0xE0 ? 3 : 2;
+        if (e - p < n || !simd::ValidUTF8(reinterpret_cast<const char*>(p), n)) {
+            AppendU16(res, 0xFFFD);
+            ++p;
+            continue;
+        }
+        unsigned u = *p & (0xFF >> (n + 1));
+        for (long i = 1; i != n; ++i) u = (u << 6) | (p[i] & 0x3F);
+        if (u >= 0x10000) {
+            u -= 0x10000;
+            AppendU16(res, 0xD800 | (u >> 10));
+            AppendU16(res, 0xDC00 | (u & 0x3FF));
+        } else {
+            AppendU16(res, u);
+        }
+        p += n;
+    }
+}
+
+}  // namespace
+
+/**
+ * 用 SIMD 找到下一个需要转义的字符，中间不需要转义的部分整段拷贝
+ */
+template <class String>
+void Json::SerializeString(std::string_view str, String& res,
+                           const WriterOptions& opts) noexcept {
+    const char* cur = str.data();
+    const char* end = cur + str.size();
+    res += '"';
+#ifndef ZZJSON_DISABLE_STATS
+    bool escaped = false;
+#endif
+    while (true) {
+        bool nonAscii = false;
+        size_t n = simd::ScanString(cur, end, nonAscii);
+        if (nonAscii && opts.asciiOnly)
+            AppendAsciiOnly(cur, cur + n, res);
+        else
+            res.append(cur, n);
+        cur += n;
+        if (cur == end) break;
+#ifndef ZZJSON_DISABLE_STATS
+        if (opts.stats && !escaped) {
+            escaped = true;
+            ++opts.stats->escapedStrings;
+        }
+#endif
+        switch (*cur) {
+            case '\"':
+                res += "\\\"";
                 break;
-            case '\t':
-                res += "\\t";
+            case '\\':
+                res += "\\\\";
                 break;
-            default:
-                // int sprintf(char *str, const char *format, ...)
-                    // 发送格式化输出到 str 所指向的字符串
-                if (static_cast<unsigned char>(e) < 0x20) {
-                    char buf[7];
-                    sprintf(buf, "\\u%04X", e);
-                    res += buf;
-                } else
-                    res += e;
+            default: {
+                const Escape& e = kControlEscape[static_cast<unsigned char>(*cur)];
+                res.append(e.text, e.len);
+            }
         }
+        ++cur;
     }
-    return res + '"';
+    res += '"';
 }
 
-std::string Json::SerializeArray() const noexcept {
-    std::string res = "[ ";
-    for (size_t i = 0; i != _jsonVal->size(); ++i) {
-        if (i > 0) {
-            res += ", ";
+/**
+ * 不递归：打开的数组 / 对象保存在显式的栈中，文档的深度不影响调用栈.
+ * sortKeys 时对象的成员先按 key 排序，否则按遍历顺序输出.
+ */
+template <class String>
+void Json::SerializeValue(String& res, const WriterOptions& opts,
+                          size_t depth) const noexcept {
+    struct Frame {
+        const PackedArray* packed;
+        const _array* arr;
+        const _obj* obj;
+        _obj::const_iterator it;
+        std::pmr::vector<const _obj::value_type*> sorted;
+        size_t pos;
+        size_t size;
+    };
+    // 输出到 pmr 字符串时，栈也分配在同一个 resource 中
+    std::pmr::memory_resource* mr = std::pmr::get_default_resource();
+    if constexpr (std::is_same_v<String, std::pmr::string>) mr = res.get_allocator().resource();
+    std::pmr::vector<Frame> stack(mr);
+    const Json* cur = this;     // 下一个要输出的值
+    while (true) {
+        if (cur) {
+            const JsonValue& val = *cur->_jsonVal;
+            size_t level = depth + stack.size();
+#ifndef ZZJSON_DISABLE_STATS
+            if (opts.stats) {
+                ++opts.stats->values;
+                bool container = val.getType() == JsonType::m_array ||
+                                  val.getType() == JsonType::m_obj;
+                opts.stats->maxDepth = std::max(opts.stats->maxDepth, level + container);
+            }
+#endif
+            val.visit(Overloaded{
+                [&](std::nullptr_t) { res += "null"; },
+                [&](bool val) { res += val ? "true" : "false"; },
+                [&](double val) { AppendNumber(res, val); },
+                [&](const RawNumber& raw) { res.append(raw.text().data(), raw.text().size()); },
+                [&](const _string& val) { SerializeString(val, res, opts); },
+                [&](const _obj& obj) {
+                    if (obj.empty()) {
+                        res += "{}";
+                        return;
+                    }
+                    res += '{';
+                    stack.push_back({nullptr, nullptr, &obj, obj.begin(),
+                                     std::pmr::vector<const _obj::value_type*>(mr), 0,
+                                     obj.size()});
+                    if (opts.sortKeys) {
+                        auto& sorted = stack.back().sorted;
+                        sorted.reserve(obj.size());
+                        for (auto&& p : obj) sorted.push_back(&p);
+                        std::sort(sorted.begin(), sorted.end(),
+                                  [](auto lhs, auto rhs) { return lhs->first < rhs->first; });
+                    }
+                },
+                [&](const auto&) {      // 普通的和紧凑存储的数组
+                    size_t size = val.size();
+                    if (size == 0) {
+                        res += "[]";
+                        return;
+                    }
+                    res += '[';
+                    auto packed = val.packed();
+#ifndef ZZJSON_DISABLE_STATS
+                    if (packed && opts.stats) opts.stats->values += size;
+#endif
+                    stack.push_back({packed, packed ? nullptr : &val.toArray(), nullptr,
+                                     {}, std::pmr::vector<const _obj::value_type*>(mr), 0,
+                                     size});
+                },
+            });
+            cur = nullptr;
+        }
+        if (stack.empty()) break;
+
+        Frame& top = stack.back();
+        size_t level = depth + stack.size();    // 子节点所在的层
+        if (top.pos == top.size) {
+            if (opts.pretty) NewLine(res, opts, level - 1);
+            res += top.obj ? '}' : ']';
+            stack.pop_back();
+            continue;
+        }
+        if (top.pos++ > 0) {
+            res += ',';
+        }
+        if (opts.pretty) NewLine(res, opts, level);
+        if (top.obj) {
+            auto& member = top.sorted.empty() ? *top.it++ : *top.sorted[top.pos - 1];
+            SerializeString(member.first, res, opts);  // key 同样需要转义
+            res += opts.pretty ? ": " : ":";
+            cur = &member.second;
+        } else if (top.arr) {
+            cur = &(*top.arr)[top.pos - 1];
+        } else if (top.packed->isBool()) {
+            res += top.packed->bools()[top.pos - 1] ? "true" : "false";
+        } else {
+            AppendNumber(res, top.packed->numbers()[top.pos - 1]);
         }
-        res += (*this)[i].serialize();
     }
-    return res + " ]";
 }
 
-std::string Json::SerializeObject() const noexcept {
-    std::string res = "{ ";
-    bool first = true;  // indicate now is the first object
-    for (auto&& p : _jsonVal->toObj()) {
-        if (first) {
-            first = false;
+namespace {
+
+/**
+ * 共享同一个节点的 Json 返回同一个地址
+ */
+const void* SharedIdentity(const Json& json) {
+    switch (json.getType()) {
+        case JsonType::m_string:
+            return json.toString().data();
+        case JsonType::m_array:
+            if (!json.isPacked()) return &json.toArray();
+            return json.numbers().empty() ? static_cast<const void*>(json.bools().data())
+                                          : json.numbers().data();
+        case JsonType::m_obj:
+            return &json.toObj();
+        default:
+            return nullptr;
+    }
+}
+
+/**
+ * 一次比较中已经证明相等的 (左边的共享节点, 右边的共享节点)
+ * 分别 dedup() 的两份文档中，重复的子树是两边各自的共享节点，哈希相同但地址不同：
+ * 同一对节点只逐个比较一次，之后直接相等
+ */
+using SharedPair = std::pair<const void*, const void*>;
+
+struct SharedPairHash {
+    size_t operator()(const SharedPair& pair) const noexcept {
+        std::hash<const void*> h;
+        return h(pair.first) * 31 + h(pair.second);
+    }
+};
+
+using SharedPairs = std::unordered_set<SharedPair, SharedPairHash>;
+
+/**
+ * 紧凑数组与普通数组逐个比较元素，两边都不生成 boxed 副本
+ */
+bool PackedEqual(const Json& packed, const Json& other) {
+    auto arr = other.get_if<Json::_array>();
+    if (!arr || arr->size() != packed.size()) return false;
+    auto numbers = packed.numbers();
+    auto bools = packed.bools();
+    for (size_t i = 0; i != arr->size(); ++i) {
+        if (!bools.empty()) {
+            auto val = (*arr)[i].get_if<bool>();
+            if (!val || *val != (bools[i] != 0)) return false;
         } else {
-            res += ", ";
+            auto val = (*arr)[i].get_if<double>();
+            if (!val || *val != numbers[i]) return false;
         }
-        res += "\"" + p.first + "\"";
-        res += ": ";
-        res += p.second.serialize();
     }
-    return res + " }";
+    return true;
 }
 
-bool operator==(const Json& lhs, const Json& rhs) {
-    if (lhs.getType() != rhs.getType()) {
-        return false;
+/**
+ * 只比较一对节点的顶层：不等返回 false；descend 表示还需要逐个比较子节点
+ * 共享的子树：同一个节点或已经证明相等的一对节点直接相等，哈希 (已缓存) 不同直接不等；
+ * 否则 pending 为这一对节点，子节点全部比较完后由调用者记入 proven
+ */
+bool ShallowEqual(const Json& lhs, const Json& rhs, const SharedPairs& proven,
+                  SharedPair& pending, bool& descend) {
+    descend = false;
+    pending = SharedPair();
+    if (&lhs == &rhs) return true;
+    if (lhs.isShared() && rhs.isShared()) {
+        SharedPair pair(SharedIdentity(lhs), SharedIdentity(rhs));
+        if (pair.first == pair.second) return true;
+        if (lhs.hash() != rhs.hash()) return false;
+        if (proven.count(pair)) return true;
+        pending = pair;
     }
-    switch (lhs.getType()) {
-        case JsonType::m_nullptr: {
-            return true;
-        }
-        case JsonType::m_bool: {
-            return lhs.toBool() == rhs.toBool();
-        }
-        case JsonType::m_number: {
-            return lhs.toDouble() == rhs.toDouble();
+    // 两边都是紧凑存储时直接比较连续的内存，不生成 boxed 副本
+    if (lhs.isPacked() && rhs.isPacked()) {
+        auto ln = lhs.numbers(), rn = rhs.numbers();
+        auto lb = lhs.bools(), rb = rhs.bools();
+        return std::equal(ln.begin(), ln.end(), rn.begin(), rn.end()) &&
+               std::equal(lb.begin(), lb.end(), rb.begin(), rb.end());
+    }
+    // 只有一边是紧凑存储时与另一边的元素逐个比较
+    if (lhs.isPacked()) return PackedEqual(lhs, rhs);
+    if (rhs.isPacked()) return PackedEqual(rhs, lhs);
+    // 左边只分派一次，右边类型不符时 get_if() 返回 nullptr
+    return lhs.visit([&](const auto& val) {
+        using T = std::decay_t<decltype(val)>;
+        if constexpr (std::is_same_v<T, Span<const double>> ||
+                      std::is_same_v<T, Span<const uint8_t>>) {
+            return false;   // 紧凑数组已在上面比较
+        } else if constexpr (std::is_same_v<T, Json::_array> ||
+                             std::is_same_v<T, Json::_obj>) {
+            auto other = rhs.get_if<T>();
+            descend = other && other->size() == val.size();
+            return descend;
+        } else {
+            auto other = rhs.get_if<T>();
+            return other && *other == val;
         }
-        case JsonType::m_string: {
-            return lhs.toString() == rhs.toString();
+    });
+}
+
+}  // namespace
+
+/**
+ * 不递归：沿左边先序遍历，others 为右边对应的容器；
+ * 任何不等都会立即返回，因此走到 kLeave 的一对容器一定相等
+ */
+bool operator==(const Json& lhs, const Json& rhs) {
+    struct Frame {
+        const Json* other;
+        SharedPair pending;
+    };
+    std::vector<Frame> others;
+    SharedPairs proven;
+    JsonCursor cur(lhs);
+    while (cur.next()) {
+        if (cur.kind() == WalkKind::kLeave) {
+            if (others.back().pending.first) proven.insert(others.back().pending);
+            others.pop_back();
+            continue;
         }
-        case JsonType::m_array: {
-            return lhs.toArray() == rhs.toArray();
+        const Json* other = &rhs;
+        if (!others.empty()) {
+            if (cur.key()) {
+                auto& obj = others.back().other->toObj();
+                auto it = obj.find(*cur.key());
+                if (it == obj.end()) return false;
+                other = &it->second;
+            } else {
+                other = &others.back().other->toArray()[cur.index()];
+            }
         }
-        case JsonType::m_obj: {
-            return lhs.toObj() == rhs.toObj();
+        bool descend;
+        SharedPair pending;
+        if (!ShallowEqual(cur.value(), *other, proven, pending, descend)) return false;
+        if (descend) {
+            others.push_back({other, pending});
+        } else if (cur.kind() == WalkKind::kEnter) {
+            cur.skip();
         }
-        default: { return false; }
     }
+    return true;
 }
 
 };  // ------------------- namespace zzjson
\ No newline at end of file
@@ -3,10 +3,17 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
+#include <string_view>
 #include <memory>
+#include <memory_resource>
+#include "json_stats.h"
 
 namespace zzjson {  // ------------------- namespace zzjson
 
@@ -19,6 +26,108 @@ enum class JsonType {
     m_obj
 };
 
+/**
+ * 解析选项
+ */
+struct ParseOptions {
+    // 校验字符串中的原始字节是否为合法的 UTF-8 (overlong、代理项、超出范围的码点)
+    bool validateUtf8 = false;
+    // 元素全部为数字 (或全部为 bool) 的数组紧凑存储为连续的 double (uint8_t)，
+    // 见 Json::numbers() / Json::bools()
+    bool packArrays = false;
+    // 数字只校验并保存原文，第一次读取数值时才转换 (结果缓存)；序列化时原样输出原文，
+    // 见 Json::numberText()。与 packArrays 同时使用时，紧凑数组中的数字仍然立即转换
+    bool lazyNumbers = false;
+    // 非空时记录本次解析的统计，见 json_stats.h
+    ParseStats* stats = nullptr;
+};
+
+/**
+ * 序列化选项
+ * 默认为紧凑输出，不含任何多余的空白
+ */
+struct WriterOptions {
+    // 是否换行缩进输出
+    bool pretty = false;
+    // pretty 模式下每层缩进的空格数
+    unsigned indent = 4;
+    // 非 ASCII 字符输出为 \uXXXX (必要时使用代理对)
+    bool asciiOnly = false;
+    // 对象按 key 排序输出，使结果与 unordered_map 的遍历顺序无关
+    bool sortKeys = false;
+    // 非空时记录本次序列化的统计，见 json_stats.h
+    SerializeStats* stats = nullptr;
+};
+
+/**
+ * Json 占用的堆内存 (字节)，见 Json::memoryUsage()
+ */
+struct MemoryUsage {
+    size_t nodes = 0;       // 每个值一个的 JsonValue 节点
+    size_t strings = 0;     // 字符串和 key 超出 SSO 的缓冲区
+    size_t arrays = 0;      // 数组的元素表
+    size_t objects = 0;     // 对象的 bucket 表和成员节点 (不含 key 的缓冲区)
+    size_t packed = 0;      // 紧凑数组的存储和 boxed 副本
+    size_t slack = 0;       // 以上各项中已分配但未使用的容量，compact() 可以回收
+
+    size_t total() const noexcept {
+        return nodes + strings + arrays + objects + packed;
+    }
+};
+
+/**
+ * 连续内存的只读视图 (C++20 std::span 的简化版)
+ */
+template <class T>
+class Span {
+public:
+    constexpr Span() noexcept = default;
+    constexpr Span(T* data, size_t size) noexcept : _data(data), _size(size) {}
+
+    constexpr T* data() const noexcept { return _data; }
+    constexpr size_t size() const noexcept { return _size; }
+    constexpr bool empty() const noexcept { return _size == 0; }
+    constexpr T* begin() const noexcept { return _data; }
+    constexpr T* end() const noexcept { return _data + _size; }
+    constexpr T& operator[](size_t pos) const noexcept { return _data[pos]; }
+
+private:
+    T* _data = nullptr;
+    size_t _size = 0;
+};
+
+/**
+ * 把多个 lambda 组合为一个访问者，用于 Json::visit()
+ */
+template <class... Fs>
+struct Overloaded : Fs... {
+    using Fs::operator()...;
+};
+template <class... Fs>
+Overloaded(Fs...) -> Overloaded<Fs...>;
+
+/**
+ * 在对象中查找成员时的 key：C++17 的 unordered_map 不支持异构查找，key 要先构造为
+ * std::pmr::string；不超过 kInline 字节的 key 构造在自身的缓冲区中，不经过任何分配器
+ *   obj.find(MemberKey(key))
+ */
+class MemberKey {
+public:
+    explicit MemberKey(std::string_view key)
+        : _resource(_buffer, sizeof(_buffer)), _key(key, &_resource) {}
+
+    MemberKey(const MemberKey&) = delete;
+    MemberKey& operator=(const MemberKey&) = delete;
+
+    operator const std::pmr::string&() const noexcept { return _key; }
+
+private:
+    static constexpr size_t kInline = 128;
+    alignas(std::max_align_t) char _buffer[kInline];
+    std::pmr::monotonic_buffer_resource _resource;
+    std::pmr::string _key;
+};
+
 /**
  * 前置声明
  */
@@ -27,29 +136,50 @@ class JsonValue;
 class Json final {
 public:
     // 声明变量的别名
-    using _array  = std::vector<Json>;
-    using _obj    = std::unordered_map<std::string, Json>;
+    // 字符串、数组和对象使用 std::pmr 容器：元素、key 和字符串的缓冲区
+    // 与所在的节点分配在同一个 memory_resource 中
+    using _string = std::pmr::string;
+    using _array  = std::pmr::vector<Json>;
+    using _obj    = std::pmr::unordered_map<_string, Json>;
+    using allocator_type = std::pmr::polymorphic_allocator<Json>;
 
 public:
     /**
      * 构造函数
+     * alloc 指定节点以及其中的字符串 / 数组 / 对象 (包括 key) 所使用的 memory_resource，
+     * 默认为 std::pmr::get_default_resource()；字符串总是拷贝到 alloc 中.
      */
-    Json() : Json(nullptr){};
-    Json(std::nullptr_t);
-    Json(bool);
-    Json(int val) : Json(1.0 * val) {};         // 转换为double
-    Json(double);
-    Json(const char* cstr) : Json(std::string(cstr)) {};
-    Json(const std::string&);
-    Json(std::string&&);
-    Json(const _array&);
-    Json(_array&&);
-    Json(const _obj&);
-    Json(_obj&&);
+    Json() : Json(nullptr) {}
+    explicit Json(const allocator_type& alloc) : Json(nullptr, alloc) {}
+    explicit Json(std::pmr::memory_resource* resource) : Json(nullptr, resource) {}
+    Json(std::nullptr_t, const allocator_type& alloc = allocator_type());
+    Json(bool, const allocator_type& alloc = allocator_type());
+    Json(int val, const allocator_type& alloc = allocator_type())
+        : Json(1.0 * val, alloc) {}             // 转换为double
+    Json(double, const allocator_type& alloc = allocator_type());
+    Json(const char* cstr, const allocator_type& alloc = allocator_type())
+        : Json(std::string_view(cstr), alloc) {}
+    Json(const std::string& str, const allocator_type& alloc = allocator_type())
+        : Json(std::string_view(str), alloc) {}
+    Json(std::string_view, const allocator_type& alloc = allocator_type());
+    Json(const _string&, const allocator_type& alloc = allocator_type());
+    Json(_string&&, const allocator_type& alloc = allocator_type());
+    Json(const _array&, const allocator_type& alloc = allocator_type());
+    Json(_array&&, const allocator_type& alloc = allocator_type());
+    Json(const _obj&, const allocator_type& alloc = allocator_type());
+    Json(_obj&&, const allocator_type& alloc = allocator_type());
 
     // 防止 Json(*) 意外产生 bool
     Json(void*) = delete;
 
+    /**
+     * 紧凑存储的数组，元素通过 operator[] / toArray() 访问时才转换为 Json
+     */
+    static Json packNumbers(const std::vector<double>& numbers,
+                            const allocator_type& alloc = allocator_type());
+    static Json packBools(const std::vector<uint8_t>& bools,
+                          const allocator_type& alloc = allocator_type());
+
 public:
     /**
      * 隐式构造函数
@@ -64,7 +194,8 @@ public:
                 std::is_constructible<
                     Json, decltype(std::declval<M>().begin()->second)>::value,
             int>::type = 0>
-    Json(const M& m) : Json(_object(m.begin(), m.end())) {}
+    Json(const M& m, const allocator_type& alloc = allocator_type())
+        : Json(_obj(m.begin(), m.end(), 0, alloc), alloc) {}
     
     /**
      * 隐式构造函数
@@ -75,24 +206,37 @@ public:
                     std::is_constructible<
                         Json, decltype(* std::declval<V>().begin())>::value,
                             int>::type = 0>
-    Json(const V& v) : Json(_array(v.begin(), v.end())) {}
+    Json(const V& v, const allocator_type& alloc = allocator_type())
+        : Json(_array(v.begin(), v.end(), alloc), alloc) {}
 
 public:
     /**
      * 析构函数
+     * 不递归：嵌套的容器先摘下放入工作表再逐个释放，文档的深度不影响调用栈
+     * releaseAsync()   -> 交给后台线程释放，请求的延迟中不再包含释放大文档的时间；
+     *                     json 之后处于被移动后的状态.  其他 resource 不一定是线程安全的，
+     *                     只有 new_delete_resource() 中的文档在后台释放，其余直接释放；
+     *                     进程退出时 (exit() 之后静态对象的析构中) 也直接释放
      */
     ~Json();
+    static void releaseAsync(Json&& json) noexcept;
 
 public:
     /**
      * 拷贝构造 / 拷贝赋值
+     * 与 std::pmr 容器相同：拷贝构造使用默认的 resource (或指定的 alloc)，
+     * 拷贝赋值保留左边原有的 resource；移动时节点连同其 resource 一起转移.
      */
     Json(const Json&);
+    Json(const Json&, const allocator_type& alloc);
     Json(Json&&) noexcept;
+    Json(Json&&, const allocator_type& alloc);
 
     Json& operator= (const Json&) noexcept;     // noexcept -> std: c++11
     Json& operator= (Json&&) noexcept;
 
+    allocator_type get_allocator() const noexcept;
+
     /**
      * Notes:
      * 拷贝构造函数通常伴随着内存分配操作，因此很可能会抛出异常；
@@ -107,8 +251,46 @@ public:
      * serialize()  -> 序列化接口
      * errMsg       -> 存储异常消息
      */
-    static Json parse(const std::string& content, std::string& errMsg) noexcept;
-    std::string serialize() const noexcept;
+    static Json parse(const std::string& content, std::string& errMsg,
+                      const ParseOptions& opts = ParseOptions(),
+                      const allocator_type& alloc = allocator_type()) noexcept;
+    std::string serialize(const WriterOptions& opts = WriterOptions()) const noexcept;
+    std::pmr::string serialize(const WriterOptions& opts,
+                               const allocator_type& alloc) const noexcept;
+
+    /**
+     * validate()   -> 只校验是否为合法的 JSON，不构造 Json 也不转换数字
+     *                 错误类型和位置与 parse() 相同
+     */
+    static bool validate(const char* data, size_t len, std::string& errMsg,
+                         const ParseOptions& opts = ParseOptions()) noexcept;
+    static bool validate(const std::string& content, std::string& errMsg,
+                         const ParseOptions& opts = ParseOptions()) noexcept;
+
+public:
+    /**
+     * MessagePack 编解码
+     * toMsgPack()      -> 编码为 MessagePack，整数值的数字按整数编码；编码不限制层数
+     * fromMsgPack()    -> 解码，errMsg 存储异常消息；数组 / map 的嵌套超过 1000 层时
+     *                     报 MSGPACK TOO DEEP
+     */
+    std::string toMsgPack() const;
+    static Json fromMsgPack(const std::string& data, std::string& errMsg) noexcept;
+
+public:
+    /**
+     * 底层输出接口，供 json_bind.h 直接序列化 C++ 类型
+     * writeString() -> 追加带引号并转义的字符串
+     * writeNumber() -> 追加数字
+     * serializeTo() -> 以第 depth 层的缩进追加序列化结果
+     */
+    static void writeString(std::string& res, std::string_view str,
+                            const WriterOptions& opts = WriterOptions()) noexcept;
+    static void writeNumber(std::string& res, double val) noexcept;
+    void serializeTo(std::string& res, const WriterOptions& opts = WriterOptions(),
+                     size_t depth = 0) const noexcept;
+    void serializeTo(std::pmr::string& res, const WriterOptions& opts = WriterOptions(),
+                     size_t depth = 0) const noexcept;
 
 public:
     /**
@@ -124,41 +306,195 @@ public:
     bool isArray()  const noexcept;
     bool isObject() const noexcept;
 
+public:
+    /**
+     * 不抛出异常、不分配内存的访问接口，穿过共享的节点；只按节点的类型内联分派一次
+     * get_if<T>()      -> T 为 std::nullptr_t / bool / double / _string / _array / _obj，
+     *                     类型不符时返回 nullptr；紧凑数组没有 _array，get_if<_array>() 返回
+     *                     nullptr (用 numbers() / bools() 读取)
+     * value_or(def)    -> 类型不符时返回 def：bool 对应 bool，其他算术类型对应数字
+     *                     (static_cast 转换)，字符串类型返回 std::string_view
+     * visit(f)         -> 以 std::nullptr_t / bool / double / const _string& /
+     *                     const _array& / const _obj& 调用 f，紧凑数组以 Span<const double>
+     *                     或 Span<const uint8_t> 调用 f (可以用 Overloaded 组合)；
+     *                     返回类型与 f(nullptr) 相同
+     * 两者的定义需要完整的 JsonValue，见 json_val.h
+     */
+    template <class T>
+    const T* get_if() const;
+
+    template <class T>
+    auto value_or(const T& def) const {
+        if constexpr (std::is_same_v<T, bool>) {
+            auto val = get_if<bool>();
+            return val ? *val : def;
+        } else if constexpr (std::is_arithmetic_v<T>) {
+            auto val = get_if<double>();
+            return val ? static_cast<T>(*val) : def;
+        } else {
+            auto val = get_if<_string>();
+            return val ? std::string_view(*val) : std::string_view(def);
+        }
+    }
+
+    template <class F>
+    decltype(auto) visit(F&& f) const;
+
 public:
     /**
      * 类型转换接口
      */
     bool toBool() const;
     double toDouble() const;
-    const std::string& toString() const;
+    std::string_view toString() const;
     const _array& toArray() const;
     const _obj& toObj() const;
 
+    /**
+     * 紧凑存储的数组 (ParseOptions::packArrays)
+     * isPacked()   -> 是否以紧凑的形式存储
+     * numbers()    -> 紧凑存储的数字数组的内容，否则为空
+     * bools()      -> 紧凑存储的 bool 数组的内容 (0 / 1)，否则为空
+     * 通过非 const 的 operator[] 访问时会转换回普通的数组
+     */
+    bool isPacked() const noexcept;
+    Span<const double> numbers() const noexcept;
+    Span<const uint8_t> bools() const noexcept;
+
+    /**
+     * 延迟转换的数字 (ParseOptions::lazyNumbers) 在输入中的原文，其他情况返回空
+     * 原文与数值在拷贝、比较和哈希时按数值处理：1.0 == 1
+     */
+    std::string_view numberText() const noexcept;
+
+    /**
+     * 可修改的 array / obj，其他类型 (包括 null) 抛出 JsonExcept
+     * 共享的子树 (dedup()) 先拷贝，紧凑数组先转换回普通的数组
+     */
+    _array& mutableArray();
+    _obj& mutableObj();
+
 public:
     /**
      * 访问 array / obj 的接口
+     * 非 const 的 operator[](pos) 越界时抛出 JsonExcept (不会改变 null 的类型)；
+     * 非 const 的 operator[](key) 在 key 不存在时插入 null (null 先变为空的对象)
      */
     size_t size() const;
     Json& operator[] (size_t);   
     const Json& operator[](size_t) const;
-    Json& operator[](const std::string&);  
-    const Json& operator[](const std::string&) const;
+    Json& operator[](std::string_view key);
+    const Json& operator[](std::string_view key) const;
+
+public:
+    /**
+     * 构建接口：直接在文档中构造元素，不需要临时的 vector / unordered_map 再拷贝
+     * 规则同 mutableArray() / mutableObj()；元素与本节点使用同一个 memory_resource
+     * 只有 emplace_back() / push_back() / emplace() 会把 null 先变为空的数组 / 对象
+     * reserve()        -> 数组预留元素，对象预留 bucket
+     * emplace_back()   -> 以 args 在数组末尾构造元素，返回新元素
+     * emplace()        -> 以 args 构造成员，key 已存在时不修改；返回 (成员, 是否插入)
+     * insert()         -> 在数组的 pos 处插入，pos 超出 size() 时抛出 JsonExcept
+     * erase()          -> 删除数组的元素 / 对象的成员，返回删除的个数
+     * clear()          -> 清空数组 / 对象，保留类型
+     */
+    void reserve(size_t n);
+    template <class... Args>
+    Json& emplace_back(Args&&... args) {
+        return MakeArray().emplace_back(std::forward<Args>(args)...);
+    }
+    void push_back(const Json& val) { emplace_back(val); }
+    void push_back(Json&& val) { emplace_back(std::move(val)); }
+    template <class... Args>
+    std::pair<Json&, bool> emplace(std::string_view key, Args&&... args) {
+        _obj& obj = MakeObj();
+        auto res = obj.try_emplace(_string(key, obj.get_allocator()), std::forward<Args>(args)...);
+        return {res.first->second, res.second};
+    }
+    Json& insert(size_t pos, Json val);
+    size_t erase(size_t pos);
+    size_t erase(std::string_view key);
+    void clear();
+
+public:
+    /**
+     * 内存占用
+     * memoryUsage()    -> 按类型统计整个文档占用的堆内存 (估算分配器的开销除外)
+     * compact()        -> 原地收紧：数组和字符串去掉多余的容量，对象使用最少的 bucket，
+     *                     紧凑数组丢弃 boxed 副本；长期只读的文档可以进一步
+     *                     用 Snapshot::freeze() 转换为扁平的布局
+     */
+    MemoryUsage memoryUsage() const noexcept;
+    void compact();
+
+public:
+    /**
+     * 结构哈希与共享
+     * hash()       -> 与 operator== 一致的哈希：相等的 Json 哈希相同，对象与成员的
+     *                 遍历顺序无关，紧凑数组与对应的普通数组相同；结果在不同进程间稳定
+     * dedup()      -> 相同的子树 (非空的数组 / 对象和超出 SSO 的字符串) 只保留一份，
+     *                 各处共享；共享的子树只读，其哈希值只计算一次，
+     *                 通过非 const 的接口修改时先拷贝 (写时复制)
+     * isShared()   -> 是否是共享的子树
+     */
+    uint64_t hash() const noexcept;
+    void dedup();
+    bool isShared() const noexcept;
 
 private:
+    _array& MakeArray();
+    _obj& MakeObj();
+    bool AssignShallow(const Json& src);
     void swap(Json&) noexcept;
+    void AddMemoryUsage(MemoryUsage& usage, std::unordered_set<const void*>& seen,
+                        std::vector<const Json*>& pending) const;
+
+    /**
+     * memo 非空时记录每个子树的哈希，供 dedup() 使用
+     */
+    using HashMemo = std::unordered_map<const Json*, uint64_t>;
+    uint64_t Hash(HashMemo* memo) const;
+    class Deduper;
+    class Reaper;
+
+    /**
+     * 供 Parser 原地解析 (ParseContext) 时覆盖原有的值
+     * 被移动过的 Json 先重新生成一个 null
+     */
+    friend class Parser;
+    JsonValue& Reuse(const allocator_type& alloc);
 
     /**
-     * 辅助函数
+     * JsonValue 穿过共享的节点访问其中的 JsonValue
      */
-    std::string SerializeString() const noexcept;
-    std::string SerializeArray()  const noexcept;
-    std::string SerializeObject() const noexcept;
+    friend class JsonValue;
+
+    /**
+     * 辅助函数：全部追加到同一个 res 中，避免逐层拼接临时字符串
+     * String 为 std::string 或 std::pmr::string
+     */
+    template <class String>
+    void SerializeValue(String& res, const WriterOptions& opts,
+                        size_t depth) const noexcept;
+    template <class String>
+    static void SerializeString(std::string_view str, String& res,
+                                const WriterOptions& opts) noexcept;
+
+    /**
+     * Parser 直接接管已经分配在目标 resource 中的存储
+     */
+    static Json PackNumbers(std::pmr::vector<double>&& numbers);
+    static Json PackBools(std::pmr::vector<uint8_t>&& bools);
+    static Json LazyNumber(std::string_view text, const allocator_type& alloc);
 
 private:
     /**
      * 数据成员
      */
-    std::unique_ptr<JsonValue> _jsonVal;
+    struct ValueDeleter {
+        void operator()(JsonValue*) const noexcept;   // 归还到节点自己的 resource
+    };
+    std::unique_ptr<JsonValue, ValueDeleter> _jsonVal;
 };
 
 inline
@@ -175,6 +511,7 @@ bool operator!=(const Json& lhs, const Json& rhs) {
 
 };  // ------------------- namespace zzjson
 
-
+// Json::visit() / Json::get_if() 的定义
+#include "json_val.h"
 
 #endif // JSON_H__
\ No newline at end of file
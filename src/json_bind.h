@@ -0,0 +1,454 @@
+#ifndef JSON_BIND_H__
+#define JSON_BIND_H__
+
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "json.h"
+#include "json_except.h"
+#include "json_hash.h"
+#include "parse.h"
+
+/**
+ * 结构体绑定：不经过 Json 树，直接从文本解析到 C++ 类型，或直接序列化 C++ 类型.
+ *
+ * 用法：
+ *     struct Point { double x; double y; };
+ *     ZZJSON_BIND(Point, x, y)          // 与 Point 位于同一个命名空间
+ *
+ *     Point pt;
+ *     std::string errMsg;
+ *     zzjson::fromJson("{\"x\":1,\"y\":2}", pt, errMsg);
+ *     std::string out = zzjson::toJson(pt);
+ *
+ * 支持的成员类型：bool、算术类型、std::string、std::vector<T>、
+ * std::optional<T>、Json 以及同样用 ZZJSON_BIND 描述过的结构体.
+ * 未知的 key 会被跳过，缺失的成员保持原值，类型不符时报 TYPE MISMATCH.
+ */
+
+/**
+ * 展开字段列表的宏，最多支持 32 个字段
+ */
+#define ZZJSON_EXPAND(x) x
+#define ZZJSON_FE_1(m, t, x) m(t, x)
+#define ZZJSON_FE_2(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_1(m, t, __VA_ARGS__))
+#define ZZJSON_FE_3(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_2(m, t, __VA_ARGS__))
+#define ZZJSON_FE_4(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_3(m, t, __VA_ARGS__))
+#define ZZJSON_FE_5(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_4(m, t, __VA_ARGS__))
+#define ZZJSON_FE_6(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_5(m, t, __VA_ARGS__))
+#define ZZJSON_FE_7(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_6(m, t, __VA_ARGS__))
+#define ZZJSON_FE_8(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_7(m, t, __VA_ARGS__))
+#define ZZJSON_FE_9(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_8(m, t, __VA_ARGS__))
+#define ZZJSON_FE_10(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_9(m, t, __VA_ARGS__))
+#define ZZJSON_FE_11(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_10(m, t, __VA_ARGS__))
+#define ZZJSON_FE_12(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_11(m, t, __VA_ARGS__))
+#define ZZJSON_FE_13(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_12(m, t, __VA_ARGS__))
+#define ZZJSON_FE_14(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_13(m, t, __VA_ARGS__))
+#define ZZJSON_FE_15(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_14(m, t, __VA_ARGS__))
+#define ZZJSON_FE_16(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_15(m, t, __VA_ARGS__))
+#define ZZJSON_FE_17(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_16(m, t, __VA_ARGS__))
+#define ZZJSON_FE_18(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_17(m, t, __VA_ARGS__))
+#define ZZJSON_FE_19(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_18(m, t, __VA_ARGS__))
+#define ZZJSON_FE_20(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_19(m, t, __VA_ARGS__))
+#define ZZJSON_FE_21(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_20(m, t, __VA_ARGS__))
+#define ZZJSON_FE_22(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_21(m, t, __VA_ARGS__))
+#define ZZJSON_FE_23(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_22(m, t, __VA_ARGS__))
+#define ZZJSON_FE_24(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_23(m, t, __VA_ARGS__))
+#define ZZJSON_FE_25(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_24(m, t, __VA_ARGS__))
+#define ZZJSON_FE_26(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_25(m, t, __VA_ARGS__))
+#define ZZJSON_FE_27(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_26(m, t, __VA_ARGS__))
+#define ZZJSON_FE_28(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_27(m, t, __VA_ARGS__))
+#define ZZJSON_FE_29(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_28(m, t, __VA_ARGS__))
+#define ZZJSON_FE_30(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_29(m, t, __VA_ARGS__))
+#define ZZJSON_FE_31(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_30(m, t, __VA_ARGS__))
+#define ZZJSON_FE_32(m, t, x, ...) \
+    m(t, x), ZZJSON_EXPAND(ZZJSON_FE_31(m, t, __VA_ARGS__))
+#define ZZJSON_GET_FE(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12,  \
+                      _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, \
+                      _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, \
+                      NAME, ...) NAME
+#define ZZJSON_FOR_EACH(m, t, ...)                                         \
+    ZZJSON_EXPAND(ZZJSON_GET_FE(__VA_ARGS__,                              \
+        ZZJSON_FE_32, ZZJSON_FE_31, ZZJSON_FE_30, ZZJSON_FE_29,           \
+        ZZJSON_FE_28, ZZJSON_FE_27, ZZJSON_FE_26, ZZJSON_FE_25,           \
+        ZZJSON_FE_24, ZZJSON_FE_23, ZZJSON_FE_22, ZZJSON_FE_21,           \
+        ZZJSON_FE_20, ZZJSON_FE_19, ZZJSON_FE_18, ZZJSON_FE_17,           \
+        ZZJSON_FE_16, ZZJSON_FE_15, ZZJSON_FE_14, ZZJSON_FE_13,           \
+        ZZJSON_FE_12, ZZJSON_FE_11, ZZJSON_FE_10, ZZJSON_FE_9,            \
+        ZZJSON_FE_8, ZZJSON_FE_7, ZZJSON_FE_6, ZZJSON_FE_5,               \
+        ZZJSON_FE_4, ZZJSON_FE_3, ZZJSON_FE_2, ZZJSON_FE_1)               \
+        (m, t, __VA_ARGS__))
+
+#define ZZJSON_FIELD(Type, name) \
+    ::zzjson::BindField<Type, decltype(Type::name)>{#name, &Type::name}
+
+/**
+ * 描述结构体的字段，生成的函数通过 ADL 查找
+ */
+#define ZZJSON_BIND(Type, ...)                                      \
+    inline constexpr auto zzjsonFields(const Type*) {               \
+        return std::make_tuple(                                     \
+            ZZJSON_FOR_EACH(ZZJSON_FIELD, Type, __VA_ARGS__));      \
+    }
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+template <class C, class M>
+struct BindField {
+    std::string_view name;
+    M C::*member;
+};
+
+/**
+ * 每种 C++ 类型的读写规则
+ * read()  -> 从 Parser 中读取一个值
+ * write() -> 追加序列化结果
+ */
+template <class T, class = void>
+struct JsonBind {
+    static_assert(sizeof(T) == 0,
+                  "type is not bindable, describe it with ZZJSON_BIND");
+};
+
+namespace bind_detail {
+
+template <class T, class = void>
+struct IsBound : std::false_type {};
+
+template <class T>
+struct IsBound<T, std::void_t<decltype(zzjsonFields(static_cast<const T*>(nullptr)))>>
+    : std::true_type {};
+
+inline void NewLine(std::string& res, const WriterOptions& opts, size_t depth) {
+    if (opts.pretty) {
+        res += '\n';
+        res.append(depth * opts.indent, ' ');
+    }
+}
+
+/**
+ * 编译期完美哈希表
+ * 寻找一个 seed 使所有 key 的哈希值落在不同的槽中；
+ * 找不到时 perfect 为 false，查找退化为线性比较.
+ */
+template <size_t N>
+struct KeyTable {
+    static constexpr size_t kBits = [] {
+        size_t bits = 1;
+        while ((size_t(1) << bits) < 2 * N) ++bits;
+        return bits;
+    }();
+    static constexpr size_t kSize = size_t(1) << kBits;
+
+    uint64_t seed = 0;
+    bool perfect = false;
+    std::array<int, kSize> slots{};
+
+    constexpr size_t slot(uint64_t hash) const noexcept {
+        return static_cast<size_t>(((hash ^ seed) * 0x9E3779B97F4A7C15ULL) >>
+                                   (64 - kBits));
+    }
+};
+
+template <size_t N>
+constexpr KeyTable<N> MakeKeyTable(const std::array<uint64_t, N>& hashes) {
+    KeyTable<N> table;
+    for (uint64_t seed = 0; seed != 1024; ++seed) {
+        table.seed = seed;
+        for (auto& s : table.slots) s = -1;
+        bool ok = true;
+        for (size_t i = 0; i != N && ok; ++i) {
+            size_t s = table.slot(hashes[i]);
+            if (table.slots[s] != -1) ok = false;
+            table.slots[s] = static_cast<int>(i);
+        }
+        if (ok) {
+            table.perfect = true;
+            return table;
+        }
+    }
+    table.seed = 0;
+    return table;
+}
+
+/**
+ * 结构体的字段信息，全部在编译期计算
+ */
+template <class T>
+struct Bound {
+    static constexpr auto fields = zzjsonFields(static_cast<const T*>(nullptr));
+    static constexpr size_t N = std::tuple_size<std::decay_t<decltype(fields)>>::value;
+
+    template <size_t... I>
+    static constexpr std::array<std::string_view, N> Names(std::index_sequence<I...>) {
+        return {std::get<I>(fields).name...};
+    }
+    template <size_t... I>
+    static constexpr std::array<uint64_t, N> Hashes(std::index_sequence<I...>) {
+        return {Fnv1a(std::get<I>(fields).name.data(),
+                      std::get<I>(fields).name.size())...};
+    }
+
+    static constexpr std::array<std::string_view, N> names =
+        Names(std::make_index_sequence<N>());
+    static constexpr KeyTable<N> table =
+        MakeKeyTable<N>(Hashes(std::make_index_sequence<N>()));
+
+    /**
+     * 返回 key 对应的字段下标，不存在时返回 -1
+     */
+    static int find(std::string_view key) noexcept {
+        if (table.perfect) {
+            int i = table.slots[table.slot(Fnv1a(key.data(), key.size()))];
+            return (i >= 0 && names[i] == key) ? i : -1;
+        }
+        for (size_t i = 0; i != N; ++i) {
+            if (names[i] == key) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    /**
+     * 按字段下标跳转的读取函数表
+     */
+    using Reader = void (*)(Parser&, T&);
+
+    template <size_t I>
+    static void ReadField(Parser& p, T& obj) {
+        auto& field = std::get<I>(fields);
+        using M = std::remove_reference_t<decltype(obj.*(field.member))>;
+        JsonBind<M>::read(p, obj.*(field.member));
+    }
+
+    template <size_t... I>
+    static constexpr std::array<Reader, N> Readers(std::index_sequence<I...>) {
+        return {&ReadField<I>...};
+    }
+
+    static constexpr std::array<Reader, N> readers =
+        Readers(std::make_index_sequence<N>());
+
+    template <size_t... I>
+    static void write(std::string& res, const T& obj, const WriterOptions& opts,
+                      size_t depth, std::index_sequence<I...>) {
+        auto one = [&](auto& field, size_t i) {
+            using M = std::remove_const_t<
+                std::remove_reference_t<decltype(obj.*(field.member))>>;
+            if (i > 0) res += ',';
+            NewLine(res, opts, depth + 1);
+            Json::writeString(res, field.name, opts);
+            res += opts.pretty ? ": " : ":";
+            JsonBind<M>::write(res, obj.*(field.member), opts, depth + 1);
+        };
+        (one(std::get<I>(fields), I), ...);
+    }
+};
+
+};  // namespace bind_detail
+
+template <>
+struct JsonBind<bool> {
+    static void read(Parser& p, bool& val) { val = p.readBool(); }
+    static void write(std::string& res, bool val, const WriterOptions&, size_t) {
+        res += val ? "true" : "false";
+    }
+};
+
+template <class T>
+struct JsonBind<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+    static void read(Parser& p, T& val) { val = static_cast<T>(p.readNumber()); }
+    static void write(std::string& res, T val, const WriterOptions&, size_t) {
+        Json::writeNumber(res, val);
+    }
+};
+
+template <class T>
+struct JsonBind<T, std::enable_if_t<std::is_integral<T>::value &&
+                                    !std::is_same<T, bool>::value>> {
+    static void read(Parser& p, T& val) {
+        if constexpr (std::is_unsigned<T>::value) {
+            // 单独解析，超出 INT64_MAX 的 uint64 也能读取
+            unsigned long long v = p.readUnsigned();
+            if (v > std::numeric_limits<T>::max()) p.fail("NUMBER TOO BIG");
+            val = static_cast<T>(v);
+        } else {
+            long long v = p.readInteger();
+            if (v < static_cast<long long>(std::numeric_limits<T>::min()) ||
+                v > static_cast<long long>(std::numeric_limits<T>::max()))
+                p.fail("NUMBER TOO BIG");
+            val = static_cast<T>(v);
+        }
+    }
+    static void write(std::string& res, T val, const WriterOptions&, size_t) {
+        res += std::to_string(val);
+    }
+};
+
+template <>
+struct JsonBind<std::string> {
+    static void read(Parser& p, std::string& val) { p.readString(val); }
+    static void write(std::string& res, const std::string& val,
+                      const WriterOptions& opts, size_t) {
+        Json::writeString(res, val, opts);
+    }
+};
+
+template <>
+struct JsonBind<Json> {
+    static void read(Parser& p, Json& val) { val = p.readValue(); }
+    static void write(std::string& res, const Json& val,
+                      const WriterOptions& opts, size_t depth) {
+        val.serializeTo(res, opts, depth);
+    }
+};
+
+template <class E>
+struct JsonBind<std::optional<E>> {
+    static void read(Parser& p, std::optional<E>& val) {
+        if (p.peek() == 'n') {
+            p.skipValue();      // null, 其余以 n 开头的都不合法
+            val.reset();
+            return;
+        }
+        if (!val) val.emplace();
+        JsonBind<E>::read(p, *val);
+    }
+    static void write(std::string& res, const std::optional<E>& val,
+                      const WriterOptions& opts, size_t depth) {
+        if (val)
+            JsonBind<E>::write(res, *val, opts, depth);
+        else
+            res += "null";
+    }
+};
+
+template <class E, class A>
+struct JsonBind<std::vector<E, A>> {
+    static void read(Parser& p, std::vector<E, A>& val) {
+        if (p.peek() != '[') p.fail("TYPE MISMATCH");
+        p.consume('[');
+        val.clear();
+        if (p.consume(']')) return;
+        do {
+            // 读到局部变量再加入：std::vector<bool> 的元素不能绑定到 bool&
+            E elem{};
+            JsonBind<E>::read(p, elem);
+            val.push_back(std::move(elem));
+        } while (p.consume(','));
+        p.expect(']', "MISS COMMA OR SQUARE BRACKET");
+    }
+    static void write(std::string& res, const std::vector<E, A>& val,
+                      const WriterOptions& opts, size_t depth) {
+        if (val.empty()) {
+            res += "[]";
+            return;
+        }
+        res += '[';
+        for (size_t i = 0; i != val.size(); ++i) {
+            if (i > 0) res += ',';
+            bind_detail::NewLine(res, opts, depth + 1);
+            JsonBind<E>::write(res, val[i], opts, depth + 1);
+        }
+        bind_detail::NewLine(res, opts, depth);
+        res += ']';
+    }
+};
+
+template <class T>
+struct JsonBind<T, std::enable_if_t<bind_detail::IsBound<T>::value>> {
+    using Info = bind_detail::Bound<T>;
+
+    static void read(Parser& p, T& val) {
+        if (p.peek() != '{') p.fail("TYPE MISMATCH");
+        p.consume('{');
+        if (p.consume('}')) return;
+        std::string scratch;    // 只有 key 含转义时才会用到
+        do {
+            std::string_view key = p.readKey(scratch);
+            p.expect(':', "MISS COLON");
+            int i = Info::find(key);
+            if (i >= 0)
+                Info::readers[i](p, val);
+            else
+                p.skipValue();
+        } while (p.consume(','));
+        p.expect('}', "MISS COMMA OR CURLY BRACKET");
+    }
+
+    static void write(std::string& res, const T& val, const WriterOptions& opts,
+                      size_t depth) {
+        res += '{';
+        Info::write(res, val, opts, depth, std::make_index_sequence<Info::N>());
+        bind_detail::NewLine(res, opts, depth);
+        res += '}';
+    }
+};
+
+/**
+ * fromJson()   -> 直接把 JSON 文本解析到 C++ 类型，出错时返回 false 并写入 errMsg
+ * toJson()     -> 直接把 C++ 类型序列化为 JSON 文本
+ */
+template <class T>
+bool fromJson(const std::string& content, T& out, std::string& errMsg,
+              const ParseOptions& opts = ParseOptions()) noexcept {
+    try {
+        Parser p(content, opts);
+        JsonBind<T>::read(p, out);
+        p.finish();
+        return true;
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+        return false;
+    }
+}
+
+template <class T>
+std::string toJson(const T& val, const WriterOptions& opts = WriterOptions()) {
+    std::string res;
+    JsonBind<T>::write(res, val, opts, 0);
+    return res;
+}
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_BIND_H__
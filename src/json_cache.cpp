@@ -0,0 +1,117 @@
+#include <algorithm>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include "json_cache.h"
+#include "json_hash.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * 一个分片：lru 中最近使用的在前，index 按哈希找到 lru 中的条目
+ * 计数在锁内累加，不需要原子操作
+ */
+struct ParseCache::Shard {
+    struct Entry {
+        uint64_t hash;
+        std::string text;
+        Document doc;
+    };
+    using List = std::list<Entry>;
+
+    mutable std::mutex mutex;
+    List lru;
+    std::unordered_map<uint64_t, List::iterator> index;
+    size_t capacity = 1;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+};
+
+/**
+ * 容量平均分配到各个分片 (向上取整)，分片数不超过容量
+ * 多个线程共享同一个 ParseStats 会产生数据竞争，opts.stats 被忽略
+ */
+ParseCache::ParseCache(size_t capacity, const ParseOptions& opts, size_t shards)
+    : _opts(opts) {
+    _opts.stats = nullptr;
+    capacity = std::max<size_t>(capacity, 1);
+    _shardCount = std::clamp<size_t>(shards, 1, capacity);
+    _shards = std::make_unique<Shard[]>(_shardCount);
+    for (size_t i = 0; i != _shardCount; ++i)
+        _shards[i].capacity = (capacity + _shardCount - 1) / _shardCount;
+}
+
+ParseCache::~ParseCache() = default;
+
+ParseCache::Shard& ParseCache::ShardOf(uint64_t hash) const noexcept {
+    return _shards[(hash >> 32) % _shardCount];
+}
+
+/**
+ * 未命中时在锁外解析；插入时同一哈希已有条目 (其他线程刚插入，或哈希碰撞) 则替换它.
+ * 被替换和淘汰的条目移到 dropped 中，在锁外释放.
+ */
+ParseCache::Document ParseCache::parse(std::string_view content, std::string& errMsg) {
+    uint64_t hash = HashBytes(content.data(), content.size());
+    Shard& shard = ShardOf(hash);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(hash);
+        if (it != shard.index.end() && it->second->text == content) {
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            ++shard.hits;
+            return it->second->doc;
+        }
+        ++shard.misses;
+    }
+
+    std::string text(content);
+    std::string err;
+    Json json = Json::parse(text, err, _opts);
+    if (!err.empty()) {
+        errMsg = std::move(err);
+        return nullptr;
+    }
+    Document doc = SharedJson::share(std::move(json));
+
+    Shard::List dropped;
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (auto it = shard.index.find(hash); it != shard.index.end()) {
+        dropped.splice(dropped.end(), shard.lru, it->second);
+        shard.index.erase(it);
+    }
+    shard.lru.push_front({hash, std::move(text), doc});
+    shard.index[hash] = shard.lru.begin();
+    while (shard.lru.size() > shard.capacity) {
+        shard.index.erase(shard.lru.back().hash);
+        dropped.splice(dropped.end(), shard.lru, std::prev(shard.lru.end()));
+        ++shard.evictions;
+    }
+    return doc;
+}
+
+CacheStats ParseCache::stats() const {
+    CacheStats res;
+    for (size_t i = 0; i != _shardCount; ++i) {
+        const Shard& shard = _shards[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        res.hits += shard.hits;
+        res.misses += shard.misses;
+        res.evictions += shard.evictions;
+        res.entries += shard.lru.size();
+    }
+    return res;
+}
+
+void ParseCache::clear() {
+    for (size_t i = 0; i != _shardCount; ++i) {
+        Shard::List dropped;
+        Shard& shard = _shards[i];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        dropped.swap(shard.lru);
+        shard.index.clear();
+    }
+}
+
+};                  // ------------------- namespace zzjson
@@ -0,0 +1,71 @@
+#ifndef JSON_CACHE_H__
+#define JSON_CACHE_H__
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "json.h"
+#include "json_shared.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * ParseCache 的计数，各分片之和
+ */
+struct CacheStats {
+    size_t hits = 0;
+    size_t misses = 0;          // 包括解析失败的输入
+    size_t evictions = 0;       // 因超出容量被淘汰的条目
+    size_t entries = 0;         // 当前缓存的文档数
+};
+
+/**
+ * 解析结果的缓存：以输入的 64 位哈希 (HashBytes) 为 key，最多保留 capacity 个文档，
+ * 按最近使用淘汰 (LRU).  相同的输入反复出现时 (心跳、重复拉取的配置)，
+ * 命中的解析只需要一次哈希、一次查找和一次原文比较.
+ *
+ * 条目按哈希分到 shards 个分片，每个分片一把锁，不同分片的查找互不阻塞；
+ * 未命中时在锁外解析，同一输入同时未命中的线程可能各自解析一次.
+ * 命中时比较保存的原文，哈希碰撞不会返回错误的文档；因此缓存还占用与输入相同大小的内存.
+ * 解析失败的输入不缓存.  返回的文档只读，可以在多个线程之间共享.
+ */
+class ParseCache {
+public:
+    using Document = SharedJson::Document;
+
+    explicit ParseCache(size_t capacity = 1024, const ParseOptions& opts = ParseOptions(),
+                        size_t shards = 16);
+    ~ParseCache();
+
+    /**
+     * 令其不可拷贝
+     */
+    ParseCache(const ParseCache&) = delete;
+    ParseCache& operator=(const ParseCache&) = delete;
+
+public:
+    /**
+     * parse()  -> 与 Json::parse() 相同，结果为共享的只读文档；失败时返回 nullptr 并写入 errMsg
+     * stats()  -> 命中 / 未命中等计数
+     * clear()  -> 清空缓存的文档 (不清零计数)
+     */
+    Document parse(std::string_view content, std::string& errMsg);
+    CacheStats stats() const;
+    void clear();
+
+private:
+    struct Shard;
+    Shard& ShardOf(uint64_t hash) const noexcept;
+
+private:
+    ParseOptions _opts;
+    size_t _shardCount;
+    std::unique_ptr<Shard[]> _shards;
+};
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_CACHE_H__
@@ -0,0 +1,232 @@
+#include <algorithm>
+#include <cmath>
+#include "json_columns.h"
+#include "json_except.h"
+#include "parse.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+namespace {
+
+/**
+ * 逐行填充各列：每行开始时先放入默认值，字段匹配时再覆盖
+ * 同一行中重复出现的字段只取第一个
+ */
+class ColumnBuilder {
+public:
+    ColumnBuilder(const std::vector<ColumnSpec>& specs, ColumnTable& table)
+        : _table(table), _seen(specs.size()) {
+        table.rows = 0;
+        table.columns.resize(specs.size());
+        for (size_t i = 0; i != specs.size(); ++i) {
+            Column& col = table.columns[i];
+            col.name = specs[i].name;
+            col.type = specs[i].type;
+            col.doubles.clear();
+            col.ints.clear();
+            col.bools.clear();
+            col.offsets.assign(1, 0);
+            col.bytes.clear();
+            col.validity.clear();
+            col.nullCount = 0;
+        }
+    }
+
+    void beginRow() {
+        size_t row = _table.rows++;
+        for (Column& col : _table.columns) {
+            switch (col.type) {
+                case ColumnType::kDouble:
+                    col.doubles.push_back(0);
+                    break;
+                case ColumnType::kInt64:
+                    col.ints.push_back(0);
+                    break;
+                case ColumnType::kBool:
+                    col.bools.push_back(0);
+                    break;
+                case ColumnType::kString:
+                    break;
+            }
+            if (row % 64 == 0) col.validity.push_back(0);
+        }
+        std::fill(_seen.begin(), _seen.end(), false);
+    }
+
+    void endRow() {
+        size_t row = _table.rows - 1;
+        for (Column& col : _table.columns) {
+            if (col.type == ColumnType::kString)
+                col.offsets.push_back(static_cast<uint32_t>(col.bytes.size()));
+            if (!col.valid(row)) ++col.nullCount;
+        }
+    }
+
+    /**
+     * 返回 false 表示该字段在本行中已经出现过
+     */
+    bool claim(size_t i) {
+        if (_seen[i]) return false;
+        _seen[i] = true;
+        return true;
+    }
+
+    void setDouble(size_t i, double val) { column(i).doubles.back() = val; }
+    void setInt(size_t i, int64_t val) { column(i).ints.back() = val; }
+    void setBool(size_t i, bool val) { column(i).bools.back() = val; }
+    void setString(size_t i, std::string_view val) { column(i).bytes.append(val); }
+
+    /**
+     * 从 Json 中取值，类型不符时该行保持无效
+     */
+    void set(size_t i, const Json& val) {
+        switch (_table.columns[i].type) {
+            case ColumnType::kDouble:
+                if (val.isNumber()) setDouble(i, val.toDouble());
+                break;
+            case ColumnType::kInt64:
+                if (val.isNumber()) {
+                    double num = val.toDouble();
+                    if (num == std::trunc(num) && fabs(num) < 9223372036854775808.0)
+                        setInt(i, static_cast<int64_t>(num));
+                }
+                break;
+            case ColumnType::kBool:
+                if (val.isBool()) setBool(i, val.toBool());
+                break;
+            case ColumnType::kString:
+                if (val.isString()) setString(i, val.toString());
+                break;
+        }
+    }
+
+    /**
+     * 从输入中读取值，类型不符时跳过 (该行保持无效)
+     */
+    void read(size_t i, Parser& p, std::string& scratch) {
+        char ch = p.peek();
+        bool number = ch == '-' || ISDIGIT(ch);
+        switch (_table.columns[i].type) {
+            case ColumnType::kDouble:
+                if (number) {
+                    setDouble(i, p.readNumber());
+                    return;
+                }
+                break;
+            case ColumnType::kInt64:
+                if (number) {
+                    long long val;
+                    if (p.tryReadInteger(val)) setInt(i, val);
+                    return;
+                }
+                break;
+            case ColumnType::kBool:
+                if (ch == 't' || ch == 'f') {
+                    setBool(i, p.readBool());
+                    return;
+                }
+                break;
+            case ColumnType::kString:
+                if (ch == '"') {
+                    setString(i, p.readKey(scratch));   // 不含转义时不拷贝
+                    return;
+                }
+                break;
+        }
+        p.skipValue();
+    }
+
+private:
+    Column& column(size_t i) {
+        Column& col = _table.columns[i];
+        size_t row = _table.rows - 1;
+        col.validity[row / 64] |= uint64_t(1) << (row % 64);
+        return col;
+    }
+
+private:
+    ColumnTable& _table;
+    std::vector<bool> _seen;
+};
+
+};  // namespace
+
+const Column* ColumnTable::find(std::string_view name) const noexcept {
+    for (auto& col : columns) {
+        if (col.name == name) return &col;
+    }
+    return nullptr;
+}
+
+/**
+ * ColumnReader
+ */
+ColumnReader::ColumnReader(std::vector<ColumnSpec> specs) : _specs(std::move(specs)) {
+    for (size_t i = 0; i != _specs.size(); ++i) _index.emplace(_specs[i].name, i);
+}
+
+bool ColumnReader::read(const Json& array, ColumnTable& table,
+                        std::string& errMsg) const {
+    if (!array.isArray()) {
+        errMsg = "Error! Not a array!";
+        return false;
+    }
+    ColumnBuilder builder(_specs, table);
+    // 对象的 key 类型，每一行查找时不再转换
+    std::vector<Json::_string> names;
+    for (auto& spec : _specs) names.emplace_back(spec.name);
+    for (auto& row : array.toArray()) {
+        builder.beginRow();
+        if (row.isObject()) {
+            auto& obj = row.toObj();
+            for (size_t i = 0; i != _specs.size(); ++i) {
+                auto it = obj.find(names[i]);
+                if (it != obj.end()) builder.set(i, it->second);
+            }
+        }
+        builder.endRow();
+    }
+    return true;
+}
+
+bool ColumnReader::parse(const std::string& content, ColumnTable& table,
+                         std::string& errMsg) const {
+    try {
+        Parser p(content);
+        if (p.peek() != '[') p.fail("TYPE MISMATCH");
+        p.consume('[');
+        ColumnBuilder builder(_specs, table);
+        if (!p.consume(']')) {
+            std::string keyScratch, valScratch;
+            do {
+                builder.beginRow();
+                if (p.peek() == '{') {
+                    p.consume('{');
+                    if (!p.consume('}')) {
+                        do {
+                            std::string_view key = p.readKey(keyScratch);
+                            p.expect(':', "MISS COLON");
+                            auto it = _index.find(key);
+                            if (it != _index.end() && builder.claim(it->second))
+                                builder.read(it->second, p, valScratch);
+                            else
+                                p.skipValue();
+                        } while (p.consume(','));
+                        p.expect('}', "MISS COMMA OR CURLY BRACKET");
+                    }
+                } else {
+                    p.skipValue();
+                }
+                builder.endRow();
+            } while (p.consume(','));
+            p.expect(']', "MISS COMMA OR SQUARE BRACKET");
+        }
+        p.finish();
+        return true;
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+    }
+    return false;
+}
+
+};                  // ------------------- namespace zzjson
@@ -0,0 +1,100 @@
+#ifndef JSON_COLUMNS_H__
+#define JSON_COLUMNS_H__
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "json.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * 列的类型
+ */
+enum class ColumnType {
+    kDouble,
+    kInt64,     // 只接受 int64 范围内的整数
+    kBool,
+    kString
+};
+
+struct ColumnSpec {
+    std::string name;
+    ColumnType type;
+};
+
+/**
+ * 一列连续存储的数据，只有与 type 对应的容器会被填充
+ * 字段不存在、为 null 或类型不符时，该行无效 (validity 中对应的 bit 为 0)，
+ * 值为 0 / false / 空字符串
+ */
+struct Column {
+    std::string name;
+    ColumnType type;
+
+    std::vector<double> doubles;
+    std::vector<int64_t> ints;
+    std::vector<uint8_t> bools;
+    std::vector<uint32_t> offsets;      // 第 i 行的字符串为 bytes[offsets[i], offsets[i + 1])
+    std::string bytes;
+
+    std::vector<uint64_t> validity;     // 每行一个 bit
+    size_t nullCount = 0;
+
+    bool valid(size_t row) const noexcept {
+        return (validity[row / 64] >> (row % 64)) & 1;
+    }
+    std::string_view stringAt(size_t row) const noexcept {
+        return std::string_view(bytes).substr(offsets[row],
+                                              offsets[row + 1] - offsets[row]);
+    }
+};
+
+struct ColumnTable {
+    size_t rows = 0;
+    std::vector<Column> columns;
+
+    /**
+     * 按名字查找列，不存在时返回 nullptr
+     */
+    const Column* find(std::string_view name) const noexcept;
+};
+
+/**
+ * 列式提取：把由对象组成的数组按字段一次性拆成若干列
+ * 既可以从已有的 Json 中提取，也可以直接从文本中提取 (不构造 Json，
+ * 未选中的字段直接跳过)；不是对象的元素整行无效.
+ */
+class ColumnReader {
+public:
+    explicit ColumnReader(std::vector<ColumnSpec> specs);
+
+    /**
+     * _index 中的 key 指向 _specs 中的字符串，令其不可拷贝
+     */
+    ColumnReader(const ColumnReader&) = delete;
+    ColumnReader& operator=(const ColumnReader&) = delete;
+    ColumnReader(ColumnReader&&) = default;
+    ColumnReader& operator=(ColumnReader&&) = default;
+
+    /**
+     * read()   -> 从 Json 中提取到 table 中
+     * parse()  -> 直接从文本中提取，不构造 Json
+     * table 中原有的容器容量会被复用；输入不是数组或语法错误时返回 false 并写入 errMsg
+     */
+    bool read(const Json& array, ColumnTable& table, std::string& errMsg) const;
+    bool parse(const std::string& content, ColumnTable& table,
+               std::string& errMsg) const;
+
+private:
+    std::vector<ColumnSpec> _specs;
+    std::unordered_map<std::string_view, size_t> _index;    // 字段名 -> 列
+};
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_COLUMNS_H__
@@ -0,0 +1,38 @@
+#include "json_context.h"
+#include "json_val.h"
+#include "parse.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+ParseContext::ParseContext(const ParseOptions& opts, const Json::allocator_type& alloc)
+    : _opts(opts), _root(alloc),
+      _pool(NewIn<ParsePool>(alloc.resource(), alloc.resource())) {}
+
+ParseContext::~ParseContext() = default;
+
+void ParseContext::PoolDeleter::operator()(ParsePool* pool) const noexcept {
+    if (pool) DeleteIn(pool->resource(), pool);
+}
+
+bool ParseContext::parse(const std::string& content, std::string& errMsg) noexcept {
+    StatsScope<ParseStats> stats(_opts.stats);
+    if (stats) stats->bytes = content.size();
+    bool ok = false;
+    try {
+        Parser p(content, _opts, _root.get_allocator().resource());
+        p.parseInto(_root, *_pool);
+        ok = true;
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+    }
+    if (stats) stats->ok = ok;
+    stats.finish(&ParseStats::parseTime);
+    return ok;
+}
+
+void ParseContext::clear() noexcept {
+    _root = Json(_root.get_allocator());
+    *_pool = ParsePool(_root.get_allocator().resource());
+}
+
+};                  // ------------------- namespace zzjson
@@ -0,0 +1,59 @@
+#ifndef JSON_CONTEXT_H__
+#define JSON_CONTEXT_H__
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include "json.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+struct ParsePool;
+
+/**
+ * 可复用的解析上下文：多次 parse() 之间保留上一个文档的节点、字符串和容器的容量，
+ * 新的文档原地覆盖上一个文档.
+ * 结构相同的文档 (同样的 key 和类型，数组不变长，字符串不变长) 预热后不再分配内存，
+ * 适合在请求循环中反复解析相似的小文档.
+ */
+class ParseContext {
+public:
+    /**
+     * alloc -> 文档以及解析时保留的缓冲区所使用的 memory_resource
+     */
+    explicit ParseContext(const ParseOptions& opts = ParseOptions(),
+                          const Json::allocator_type& alloc = Json::allocator_type());
+    ~ParseContext();
+
+    /**
+     * 令其不可拷贝
+     */
+    ParseContext(const ParseContext&) = delete;
+    ParseContext& operator=(const ParseContext&) = delete;
+
+public:
+    /**
+     * parse()  -> 解析 content，结果通过 root() 访问，在下一次 parse() 之前有效；
+     *             失败时返回 false 并写入 errMsg，此时 root() 的内容未指定
+     * root()   -> 当前的文档
+     * clear()  -> 释放保留的所有内存
+     */
+    bool parse(const std::string& content, std::string& errMsg) noexcept;
+    Json& root() noexcept { return _root; }
+    const Json& root() const noexcept { return _root; }
+    void clear() noexcept;
+
+private:
+    struct PoolDeleter {
+        void operator()(ParsePool* pool) const noexcept;    // 归还到 pool 自己的 resource
+    };
+
+    ParseOptions _opts;
+    Json _root;
+    std::unique_ptr<ParsePool, PoolDeleter> _pool;
+};
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_CONTEXT_H__
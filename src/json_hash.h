@@ -0,0 +1,55 @@
+#ifndef JSON_HASH_H__
+#define JSON_HASH_H__
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * FNV-1a 64 位哈希
+ * constexpr，可以在编译期计算 key 的哈希值
+ */
+constexpr uint64_t kFnvOffset = 14695981039346656037ULL;
+constexpr uint64_t kFnvPrime  = 1099511628211ULL;
+
+constexpr uint64_t Fnv1a(const char* data, size_t len,
+                         uint64_t hash = kFnvOffset) noexcept {
+    for (size_t i = 0; i != len; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= kFnvPrime;
+    }
+    return hash;
+}
+
+/**
+ * 长输入的 64 位哈希：每次读取 8 个字节，乘法加 splitmix64 的收尾混合，
+ * 比逐字节的 Fnv1a 快得多；不用于密码学，结果只在同一进程内使用.
+ */
+inline uint64_t HashBytes(const char* data, size_t len,
+                          uint64_t seed = kFnvOffset) noexcept {
+    constexpr uint64_t kMul = 0x9e3779b97f4a7c15ULL;
+    auto mix = [](uint64_t h) {
+        h ^= h >> 30;
+        h *= 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 27;
+        h *= 0x94d049bb133111ebULL;
+        return h ^ (h >> 31);
+    };
+    uint64_t h = seed ^ (len * kMul);
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, data, 8);
+        h = (h ^ mix(word)) * kMul;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data, len);
+    return mix(h ^ tail);
+}
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_HASH_H__
@@ -0,0 +1,367 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include "json.h"
+#include "json_except.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * MessagePack 格式
+ * 详见：https://github.com/msgpack/msgpack/blob/master/spec.md
+ *
+ * 容器都带有长度前缀，解码时可以一次 reserve 到位；
+ * 数字直接以二进制的整数/浮点数编码，不经过文本转换.
+ */
+namespace {
+
+/**
+ * 大端序写入
+ */
+template <class T>
+void PutBE(std::string& out, T val) {
+    char buf[sizeof(T)];
+    for (size_t i = 0; i != sizeof(T); ++i) {
+        buf[i] = static_cast<char>(val >> (8 * (sizeof(T) - 1 - i)));
+    }
+    out.append(buf, sizeof(T));
+}
+
+void PutTag(std::string& out, unsigned char tag) {
+    out += static_cast<char>(tag);
+}
+
+/**
+ * 按长度选择最短的头部
+ * fix    -> 长度直接编码在类型字节中 (fixLimit 以内)
+ * 8/16/32 -> 后跟 1/2/4 字节的长度，tag8 为 0 表示该类型没有 8 位的形式
+ */
+void PutLength(std::string& out, size_t len, unsigned char fix, size_t fixLimit,
+               unsigned char tag8, unsigned char tag16, unsigned char tag32) {
+    if (len <= fixLimit) {
+        PutTag(out, static_cast<unsigned char>(fix | len));
+    } else if (tag8 && len <= 0xFF) {
+        PutTag(out, tag8);
+        PutBE<uint8_t>(out, static_cast<uint8_t>(len));
+    } else if (len <= 0xFFFF) {
+        PutTag(out, tag16);
+        PutBE<uint16_t>(out, static_cast<uint16_t>(len));
+    } else {
+        PutTag(out, tag32);
+        PutBE<uint32_t>(out, static_cast<uint32_t>(len));
+    }
+}
+
+void PutNumber(std::string& out, double val) {
+    // 整数值 (不含 -0.0) 按最短的整数编码
+    if (val == std::trunc(val) && val >= -9223372036854775808.0 &&
+        val < 18446744073709551616.0 && !(val == 0 && std::signbit(val))) {
+        if (val >= 0) {
+            auto u = static_cast<uint64_t>(val);
+            if (u <= 0x7F) {
+                PutTag(out, static_cast<unsigned char>(u));
+            } else if (u <= 0xFF) {
+                PutTag(out, 0xcc);
+                PutBE<uint8_t>(out, static_cast<uint8_t>(u));
+            } else if (u <= 0xFFFF) {
+                PutTag(out, 0xcd);
+                PutBE<uint16_t>(out, static_cast<uint16_t>(u));
+            } else if (u <= 0xFFFFFFFF) {
+                PutTag(out, 0xce);
+                PutBE<uint32_t>(out, static_cast<uint32_t>(u));
+            } else {
+                PutTag(out, 0xcf);
+                PutBE<uint64_t>(out, u);
+            }
+        } else {
+            auto i = static_cast<int64_t>(val);
+            if (i >= -32) {
+                PutTag(out, static_cast<unsigned char>(i));
+            } else if (i >= INT8_MIN) {
+                PutTag(out, 0xd0);
+                PutBE<uint8_t>(out, static_cast<uint8_t>(i));
+            } else if (i >= INT16_MIN) {
+                PutTag(out, 0xd1);
+                PutBE<uint16_t>(out, static_cast<uint16_t>(i));
+            } else if (i >= INT32_MIN) {
+                PutTag(out, 0xd2);
+                PutBE<uint32_t>(out, static_cast<uint32_t>(i));
+            } else {
+                PutTag(out, 0xd3);
+                PutBE<uint64_t>(out, static_cast<uint64_t>(i));
+            }
+        }
+        return;
+    }
+    // 能被 float 精确表示时用 float32
+    auto f = static_cast<float>(val);
+    if (static_cast<double>(f) == val) {
+        uint32_t bits;
+        memcpy(&bits, &f, sizeof(bits));
+        PutTag(out, 0xca);
+        PutBE<uint32_t>(out, bits);
+    } else {
+        uint64_t bits;
+        memcpy(&bits, &val, sizeof(bits));
+        PutTag(out, 0xcb);
+        PutBE<uint64_t>(out, bits);
+    }
+}
+
+void PutString(std::string& out, std::string_view str) {
+    PutLength(out, str.size(), 0xa0, 31, 0xd9, 0xda, 0xdb);
+    out += str;
+}
+
+/**
+ * 不递归：长度写在元素之前，不需要回填；待写的 (key, 值) 按输出顺序的逆序放在显式的栈中，
+ * 不是对象的成员时 key 为空
+ */
+void Encode(std::string& out, const Json& root) {
+    std::vector<std::pair<const Json::_string*, const Json*>> pending{{nullptr, &root}};
+    while (!pending.empty()) {
+        auto [key, value] = pending.back();
+        pending.pop_back();
+        if (key) PutString(out, *key);
+        const Json& json = *value;
+        switch (json.getType()) {
+            case JsonType::m_nullptr:
+                PutTag(out, 0xc0);
+                break;
+            case JsonType::m_bool:
+                PutTag(out, json.toBool() ? 0xc3 : 0xc2);
+                break;
+            case JsonType::m_number:
+                PutNumber(out, json.toDouble());
+                break;
+            case JsonType::m_string:
+                PutString(out, json.toString());
+                break;
+            case JsonType::m_array: {
+                // 紧凑数组直接写出其存储，不生成 boxed 副本
+                if (json.isPacked()) {
+                    Span<const double> numbers = json.numbers();
+                    Span<const uint8_t> bools = json.bools();
+                    PutLength(out, numbers.size() + bools.size(), 0x90, 15, 0, 0xdc, 0xdd);
+                    for (double num : numbers) PutNumber(out, num);
+                    for (uint8_t b : bools) PutTag(out, b ? 0xc3 : 0xc2);
+                    break;
+                }
+                const Json::_array& arr = json.toArray();
+                PutLength(out, arr.size(), 0x90, 15, 0, 0xdc, 0xdd);
+                for (auto it = arr.rbegin(); it != arr.rend(); ++it)
+                    pending.push_back({nullptr, &*it});
+                break;
+            }
+            case JsonType::m_obj: {
+                const Json::_obj& obj = json.toObj();
+                PutLength(out, obj.size(), 0x80, 15, 0, 0xde, 0xdf);
+                size_t mark = pending.size();
+                for (auto&& p : obj) pending.push_back({&p.first, &p.second});
+                std::reverse(pending.begin() + mark, pending.end());
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * 解码器
+ * 出错时抛出 JsonExcept，消息为 "错误类型: offset N"
+ */
+class MsgPackReader {
+public:
+    MsgPackReader(const char* data, size_t len) noexcept
+        : _begin(data), _cur(data), _end(data + len) {}
+
+    Json parse() {
+        Json json = ReadValue();
+        if (_cur != _end) error("ROOT NOT SINGULAR");
+        return json;
+    }
+
+private:
+    [[noreturn]] void error(const char* msg) const {
+        throw JsonExcept(std::string(msg) + ": offset " +
+                         std::to_string(_cur - _begin));
+    }
+
+    void Need(size_t n) const {
+        if (static_cast<size_t>(_end - _cur) < n) error("MSGPACK TRUNCATED");
+    }
+
+    template <class T>
+    T GetBE() {
+        Need(sizeof(T));
+        T val = 0;
+        for (size_t i = 0; i != sizeof(T); ++i) {
+            val = static_cast<T>((val << 8) | static_cast<unsigned char>(_cur[i]));
+        }
+        _cur += sizeof(T);
+        return val;
+    }
+
+    /**
+     * 读取 U 类型的大端整数，按 S 解释符号
+     */
+    template <class U, class S>
+    double GetInt() {
+        return static_cast<double>(static_cast<S>(GetBE<U>()));
+    }
+
+    /**
+     * 指向输入的 string_view，由调用者拷贝到节点中
+     */
+    std::string_view ReadString(size_t len) {
+        Need(len);
+        std::string_view str(_cur, len);
+        _cur += len;
+        return str;
+    }
+
+    /**
+     * 每个元素至少占 minSize 个字节，
+     * 因此 reserve 不会超过剩余输入所能容纳的数量，避免恶意的长度前缀
+     */
+    size_t Reservable(size_t n, size_t minSize) const {
+        return std::min(n, static_cast<size_t>(_end - _cur) / minSize);
+    }
+
+    /**
+     * 解码按嵌套层数递归：限制深度，恶意的深层嵌套报错而不是耗尽调用栈
+     */
+    class DepthGuard {
+    public:
+        explicit DepthGuard(MsgPackReader& reader) : _reader(reader) {
+            if (++_reader._depth > kMaxDepth) _reader.error("MSGPACK TOO DEEP");
+        }
+        ~DepthGuard() { --_reader._depth; }
+
+    private:
+        MsgPackReader& _reader;
+    };
+
+    Json ReadArray(size_t n) {
+        DepthGuard guard(*this);
+        Json::_array arr;
+        arr.reserve(Reservable(n, 1));
+        for (size_t i = 0; i != n; ++i) arr.push_back(ReadValue());
+        return Json(std::move(arr));
+    }
+
+    Json ReadMap(size_t n) {
+        DepthGuard guard(*this);
+        Json::_obj obj;
+        obj.reserve(Reservable(n, 2));
+        for (size_t i = 0; i != n; ++i) {
+            std::string_view key = ReadKey();
+            obj.try_emplace(Json::_string(key), ReadValue());
+        }
+        return Json(std::move(obj));
+    }
+
+    std::string_view ReadKey() {
+        Need(1);
+        auto tag = static_cast<unsigned char>(*_cur);
+        if ((tag & 0xe0) == 0xa0) {
+            ++_cur;
+            return ReadString(tag & 0x1f);
+        }
+        switch (tag) {
+            case 0xd9: ++_cur; return ReadString(GetBE<uint8_t>());
+            case 0xda: ++_cur; return ReadString(GetBE<uint16_t>());
+            case 0xdb: ++_cur; return ReadString(GetBE<uint32_t>());
+            default: error("MSGPACK KEY NOT STRING");
+        }
+    }
+
+    Json ReadValue() {
+        Need(1);
+        auto tag = static_cast<unsigned char>(*_cur);
+        if (tag <= 0x7f) {
+            ++_cur;
+            return Json(static_cast<double>(tag));
+        }
+        if (tag >= 0xe0) {
+            ++_cur;
+            return Json(static_cast<double>(static_cast<int8_t>(tag)));
+        }
+        if ((tag & 0xf0) == 0x80) {
+            ++_cur;
+            return ReadMap(tag & 0x0f);
+        }
+        if ((tag & 0xf0) == 0x90) {
+            ++_cur;
+            return ReadArray(tag & 0x0f);
+        }
+        if ((tag & 0xe0) == 0xa0) return Json(ReadKey());
+        switch (tag) {
+            case 0xc0: ++_cur; return Json(nullptr);
+            case 0xc2: ++_cur; return Json(false);
+            case 0xc3: ++_cur; return Json(true);
+            case 0xca: {
+                ++_cur;
+                uint32_t bits = GetBE<uint32_t>();
+                float f;
+                memcpy(&f, &bits, sizeof(f));
+                return Json(static_cast<double>(f));
+            }
+            case 0xcb: {
+                ++_cur;
+                uint64_t bits = GetBE<uint64_t>();
+                double d;
+                memcpy(&d, &bits, sizeof(d));
+                return Json(d);
+            }
+            case 0xcc: ++_cur; return Json(GetInt<uint8_t, uint8_t>());
+            case 0xcd: ++_cur; return Json(GetInt<uint16_t, uint16_t>());
+            case 0xce: ++_cur; return Json(GetInt<uint32_t, uint32_t>());
+            case 0xcf: ++_cur; return Json(GetInt<uint64_t, uint64_t>());
+            case 0xd0: ++_cur; return Json(GetInt<uint8_t, int8_t>());
+            case 0xd1: ++_cur; return Json(GetInt<uint16_t, int16_t>());
+            case 0xd2: ++_cur; return Json(GetInt<uint32_t, int32_t>());
+            case 0xd3: ++_cur; return Json(GetInt<uint64_t, int64_t>());
+            case 0xd9:
+            case 0xda:
+            case 0xdb: return Json(ReadKey());
+            case 0xdc: ++_cur; return ReadArray(GetBE<uint16_t>());
+            case 0xdd: ++_cur; return ReadArray(GetBE<uint32_t>());
+            case 0xde: ++_cur; return ReadMap(GetBE<uint16_t>());
+            case 0xdf: ++_cur; return ReadMap(GetBE<uint32_t>());
+            default:
+                // bin / ext 等 JSON 无法表示的类型
+                error("INVALID MSGPACK TYPE");
+        }
+    }
+
+public:
+    static constexpr size_t kMaxDepth = 1000;
+
+private:
+    const char* _begin;
+    const char* _cur;
+    const char* _end;
+    size_t _depth = 0;
+};
+
+}  // namespace
+
+std::string Json::toMsgPack() const {
+    std::string out;
+    Encode(out, *this);
+    return out;
+}
+
+Json Json::fromMsgPack(const std::string& data, std::string& errMsg) noexcept {
+    try {
+        MsgPackReader reader(data.data(), data.size());
+        return reader.parse();
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+        return Json(nullptr);
+    }
+}
+
+};  // ------------------- namespace zzjson
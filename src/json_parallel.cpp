@@ -0,0 +1,309 @@
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <deque>
+#include <thread>
+#include <vector>
+#include "json_parallel.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+namespace {
+
+using Member = Json::_obj::value_type;
+
+// 少于该数量子节点的容器 (例如 {"data": [...], "meta": {...}}) 继续向下寻找可以拆分的容器
+constexpr size_t kFewChildren = 8;
+constexpr int kMaxLevel = 4;
+
+/**
+ * 输出按顺序分成若干块，每块是以下之一：
+ *   kText      -> 规划时直接生成的文本 (括号、逗号、缩进、key 以及小的值)
+ *   kValue     -> 整个值
+ *   kElements  -> 数组中 [begin, end) 的元素，含前面的逗号和缩进
+ *   kMembers   -> 对象中 [begin, end) 的成员，含前面的逗号、缩进和 key
+ * 除 kText 外都在工作线程中序列化到 text 中.
+ */
+struct Piece {
+    enum Kind { kText, kValue, kElements, kMembers };
+
+    Kind kind = kText;
+    std::string text;
+    const Json* value = nullptr;
+    const std::vector<const Member*>* members = nullptr;
+    size_t begin = 0, end = 0;
+    size_t depth = 0;
+};
+
+class Planner {
+public:
+    Planner(const WriterOptions& opts, const ParallelOptions& popts, size_t chunks)
+        : _opts(opts), _minSplit(std::max<size_t>(popts.minSplit, 1)),
+          _chunks(chunks) {}
+
+    void plan(const Json& val, size_t depth, int level) {
+        JsonType type = val.getType();
+        bool container = type == JsonType::m_array || type == JsonType::m_obj;
+        size_t n = container ? val.size() : 0;
+        if (n == 0) {
+            val.serializeTo(text(), _opts, depth);
+        } else if (n >= _minSplit && !val.isPacked()) {
+            split(val, type, n, depth);
+        } else if (n <= kFewChildren && level < kMaxLevel && !val.isPacked()) {
+            descend(val, type, depth, level);
+        } else {
+            task(Piece::kValue, &val, nullptr, 0, 0, depth);
+        }
+    }
+
+    std::vector<Piece>& pieces() { return _pieces; }
+
+private:
+    /**
+     * 子节点分成 _chunks 块，每块作为一个任务
+     */
+    void split(const Json& val, JsonType type, size_t n, size_t depth) {
+        size_t step = std::max<size_t>((n + _chunks - 1) / _chunks, 1);
+        const std::vector<const Member*>* members = nullptr;
+        if (type == JsonType::m_obj) members = &sortedMembers(val);
+        text() += type == JsonType::m_array ? '[' : '{';
+        for (size_t b = 0; b < n; b += step) {
+            task(members ? Piece::kMembers : Piece::kElements, &val, members, b,
+                 std::min(b + step, n), depth);
+        }
+        close(type, depth);
+    }
+
+    /**
+     * 子节点很少：逐个继续规划
+     */
+    void descend(const Json& val, JsonType type, size_t depth, int level) {
+        if (type == JsonType::m_array) {
+            text() += '[';
+            auto& arr = val.toArray();
+            for (size_t i = 0; i != arr.size(); ++i) {
+                std::string& res = text();
+                if (i > 0) res += ',';
+                newLine(res, depth + 1);
+                plan(arr[i], depth + 1, level + 1);
+            }
+        } else {
+            text() += '{';
+            auto& members = sortedMembers(val);
+            for (size_t i = 0; i != members.size(); ++i) {
+                std::string& res = text();
+                if (i > 0) res += ',';
+                newLine(res, depth + 1);
+                key(res, members[i]->first);
+                plan(members[i]->second, depth + 1, level + 1);
+            }
+        }
+        close(type, depth);
+    }
+
+    void close(JsonType type, size_t depth) {
+        std::string& res = text();
+        newLine(res, depth);
+        res += type == JsonType::m_array ? ']' : '}';
+    }
+
+    /**
+     * 与 serialize() 相同的顺序：sortKeys 时按 key 排序，否则按遍历顺序
+     */
+    const std::vector<const Member*>& sortedMembers(const Json& val) {
+        auto& members = _members.emplace_back();
+        auto& obj = val.toObj();
+        members.reserve(obj.size());
+        for (auto& p : obj) members.push_back(&p);
+        if (_opts.sortKeys) {
+            std::sort(members.begin(), members.end(),
+                      [](auto lhs, auto rhs) { return lhs->first < rhs->first; });
+        }
+        return members;
+    }
+
+    void task(Piece::Kind kind, const Json* val,
+              const std::vector<const Member*>* members, size_t b, size_t e,
+              size_t depth) {
+        Piece& piece = _pieces.emplace_back();
+        piece.kind = kind;
+        piece.value = val;
+        piece.members = members;
+        piece.begin = b;
+        piece.end = e;
+        piece.depth = depth;
+    }
+
+    /**
+     * 当前的文本块，最后一块是任务时新建一块
+     */
+    std::string& text() {
+        if (_pieces.empty() || _pieces.back().kind != Piece::kText)
+            _pieces.emplace_back();
+        return _pieces.back().text;
+    }
+
+    void newLine(std::string& res, size_t depth) const {
+        if (!_opts.pretty) return;
+        res += '\n';
+        res.append(depth * _opts.indent, ' ');
+    }
+
+    void key(std::string& res, std::string_view key) const {
+        Json::writeString(res, key, _opts);
+        res += _opts.pretty ? ": " : ":";
+    }
+
+public:
+    /**
+     * 在工作线程中执行
+     */
+    void run(Piece& piece) const {
+        std::string& res = piece.text;
+        size_t depth = piece.depth;
+        switch (piece.kind) {
+            case Piece::kValue:
+                piece.value->serializeTo(res, _opts, depth);
+                break;
+            case Piece::kElements: {
+                auto& arr = piece.value->toArray();
+                for (size_t i = piece.begin; i != piece.end; ++i) {
+                    if (i > 0) res += ',';
+                    newLine(res, depth + 1);
+                    arr[i].serializeTo(res, _opts, depth + 1);
+                }
+                break;
+            }
+            case Piece::kMembers:
+                for (size_t i = piece.begin; i != piece.end; ++i) {
+                    const Member* m = (*piece.members)[i];
+                    if (i > 0) res += ',';
+                    newLine(res, depth + 1);
+                    key(res, m->first);
+                    m->second.serializeTo(res, _opts, depth + 1);
+                }
+                break;
+            case Piece::kText:
+                break;
+        }
+    }
+
+private:
+    const WriterOptions& _opts;
+    size_t _minSplit;
+    size_t _chunks;
+    std::vector<Piece> _pieces;
+    std::deque<std::vector<const Member*>> _members;    // 地址需要保持不变
+};
+
+unsigned ThreadCount(const ParallelOptions& popts) {
+    unsigned threads = popts.threads ? popts.threads : std::thread::hardware_concurrency();
+    return std::max(threads, 1u);
+}
+
+/**
+ * 规划并执行所有任务，调用者所在的线程也参与执行
+ * 各线程共享 opts，因此不在其中逐个值统计，只记录总字节数和耗时
+ */
+template <class F>
+void Serialize(const Json& json, const WriterOptions& options,
+               const ParallelOptions& popts, F&& consume) {
+    StatsScope<SerializeStats> stats(options.stats);
+    WriterOptions opts = options;
+    opts.stats = nullptr;
+    auto done = [&](std::vector<Piece>& pieces) {
+        if (stats) {
+            for (auto& piece : pieces) stats->bytes += piece.text.size();
+        }
+        consume(pieces);
+        stats.finish(&SerializeStats::serializeTime);
+    };
+    unsigned threads = ThreadCount(popts);
+    // 每个线程分到多块，避免各块大小不均时互相等待
+    Planner planner(opts, popts, threads == 1 ? 1 : threads * 4);
+    if (threads == 1) {
+        std::vector<Piece> pieces(1);
+        json.serializeTo(pieces[0].text, opts);
+        done(pieces);
+        return;
+    }
+    planner.plan(json, 0, 0);
+    auto& pieces = planner.pieces();
+
+    std::vector<Piece*> tasks;
+    for (auto& piece : pieces) {
+        if (piece.kind != Piece::kText) tasks.push_back(&piece);
+    }
+    std::atomic<size_t> next{0};
+    auto work = [&] {
+        for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < tasks.size();)
+            planner.run(*tasks[i]);
+    };
+    std::vector<std::thread> workers;
+    size_t extra = std::min<size_t>(threads, tasks.size());
+    for (size_t i = 1; i < extra; ++i) workers.emplace_back(work);
+    work();
+    for (auto& t : workers) t.join();
+    done(pieces);
+}
+
+};  // namespace
+
+std::string serializeParallel(const Json& json, const WriterOptions& opts,
+                              const ParallelOptions& popts) {
+    std::string res;
+    Serialize(json, opts, popts, [&](std::vector<Piece>& pieces) {
+        if (pieces.size() == 1) {
+            res = std::move(pieces[0].text);
+            return;
+        }
+        size_t total = 0;
+        for (auto& piece : pieces) total += piece.text.size();
+        res.reserve(total);
+        for (auto& piece : pieces) res += piece.text;
+    });
+    return res;
+}
+
+/**
+ * 各块直接用 writev 按顺序写出，不再拼接成一个字符串
+ */
+bool writeParallel(int fd, const Json& json, std::string& errMsg,
+                   const WriterOptions& opts, const ParallelOptions& popts) {
+    bool ok = true;
+    Serialize(json, opts, popts, [&](std::vector<Piece>& pieces) {
+        std::vector<iovec> iov;
+        for (auto& piece : pieces) {
+            if (!piece.text.empty())
+                iov.push_back({const_cast<char*>(piece.text.data()), piece.text.size()});
+        }
+        size_t cur = 0;
+        while (cur != iov.size()) {
+            int count = static_cast<int>(std::min<size_t>(iov.size() - cur, IOV_MAX));
+            ssize_t n = writev(fd, &iov[cur], count);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                errMsg = std::string("WRITE FAILED: ") + strerror(errno);
+                ok = false;
+                return;
+            }
+            // 处理部分写入
+            size_t written = static_cast<size_t>(n);
+            while (cur != iov.size() && written >= iov[cur].iov_len) {
+                written -= iov[cur].iov_len;
+                ++cur;
+            }
+            if (cur != iov.size()) {
+                iov[cur].iov_base = static_cast<char*>(iov[cur].iov_base) + written;
+                iov[cur].iov_len -= written;
+            }
+        }
+    });
+    return ok;
+}
+
+};                  // ------------------- namespace zzjson
@@ -0,0 +1,39 @@
+#ifndef JSON_PARALLEL_H__
+#define JSON_PARALLEL_H__
+
+#pragma once
+
+#include <string>
+#include "json.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * 并行序列化的选项
+ */
+struct ParallelOptions {
+    // 线程数 (含调用者)，0 表示 std::thread::hardware_concurrency()
+    unsigned threads = 0;
+    // 子节点数不少于该值的容器才会被拆分成多块
+    size_t minSplit = 1024;
+};
+
+/**
+ * 并行序列化：把大的数组 / 对象的子节点分块，在多个线程中分别序列化到
+ * 各自的缓冲区，再按顺序拼接 (或用 writev 直接写出，不拼接).
+ * 输出与 Json::serialize() 逐字节相同.
+ *
+ * serializeParallel()  -> 返回序列化结果
+ * writeParallel()      -> 写入文件描述符 fd，失败时返回 false 并写入 errMsg
+ * opts.stats 只记录 bytes 和耗时.
+ */
+std::string serializeParallel(const Json& json,
+                              const WriterOptions& opts = WriterOptions(),
+                              const ParallelOptions& popts = ParallelOptions());
+bool writeParallel(int fd, const Json& json, std::string& errMsg,
+                   const WriterOptions& opts = WriterOptions(),
+                   const ParallelOptions& popts = ParallelOptions());
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_PARALLEL_H__
@@ -0,0 +1,330 @@
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+#include "json_except.h"
+#include "json_patch.h"
+#include "json_path.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+namespace {
+
+[[noreturn]] void Error(const char* msg, std::string_view rest) {
+    throw JsonExcept(std::string(msg) + ": " + std::string(rest));
+}
+
+/**
+ * 生成 JSON Patch：_path 为当前节点的 JSON Pointer，进入子节点时追加，返回时截断
+ */
+class Differ {
+public:
+    explicit Differ(Json::_array& ops) : _ops(ops) {}
+
+    void diff(const Json& a, const Json& b) {
+        // 两边共享同一个节点时 O(1) 返回，哈希已缓存时不同的子树也是 O(1)
+        if (a.isShared() && b.isShared() && a == b) return;
+        if (a.getType() != b.getType()) return op("replace", &b);
+        switch (a.getType()) {
+            case JsonType::m_array:
+                return diffArray(a, b);
+            case JsonType::m_obj:
+                return diffObj(a, b);
+            default:
+                if (!(a == b)) op("replace", &b);
+        }
+    }
+
+private:
+    void diffObj(const Json& a, const Json& b) {
+        const Json::_obj& x = a.toObj();
+        const Json::_obj& y = b.toObj();
+        for (auto& [key, val] : x) {
+            size_t len = push(key);
+            auto it = y.find(key);
+            if (it == y.end()) {
+                op("remove", nullptr);
+            } else {
+                diff(val, it->second);
+            }
+            _path.resize(len);
+        }
+        for (auto& [key, val] : y) {
+            if (x.count(key)) continue;
+            size_t len = push(key);
+            op("add", &val);
+            _path.resize(len);
+        }
+    }
+
+    /**
+     * 去掉相同的首尾后，pos 为中间部分在 (已应用前面的 op 的) 数组中的下标：
+     * x[i] 不在 y 的剩余部分而 y[j] 在 x 的剩余部分 -> 删除 x[i]，反之插入 y[j]，
+     * 否则逐个比较；哈希碰撞只会影响 op 的选择，不影响结果的正确性.
+     */
+    void diffArray(const Json& a, const Json& b) {
+        const Json::_array& x = a.toArray();
+        const Json::_array& y = b.toArray();
+        size_t n = x.size(), m = y.size(), pre = 0, suf = 0;
+        while (pre != n && pre != m && x[pre] == y[pre]) ++pre;
+        while (suf != n - pre && suf != m - pre && x[n - 1 - suf] == y[m - 1 - suf]) ++suf;
+
+        std::vector<uint64_t> hx, hy;
+        std::unordered_map<uint64_t, size_t> restX, restY;
+        for (size_t i = pre; i != n - suf; ++i) {
+            hx.push_back(x[i].hash());
+            ++restX[hx.back()];
+        }
+        for (size_t j = pre; j != m - suf; ++j) {
+            hy.push_back(y[j].hash());
+            ++restY[hy.back()];
+        }
+
+        size_t i = 0, j = 0, pos = pre;
+        while (i != hx.size() && j != hy.size()) {
+            bool xKept = restY[hx[i]] != 0, yKept = restX[hy[j]] != 0;
+            size_t len = push(pos);
+            if (!xKept && yKept) {
+                op("remove", nullptr);
+                --restX[hx[i++]];
+            } else if (xKept && !yKept) {
+                op("add", &y[pre + j]);
+                --restY[hy[j++]];
+                ++pos;
+            } else {
+                diff(x[pre + i], y[pre + j]);
+                --restX[hx[i++]];
+                --restY[hy[j++]];
+                ++pos;
+            }
+            _path.resize(len);
+        }
+        for (; i != hx.size(); ++i) {
+            size_t len = push(pos);
+            op("remove", nullptr);
+            _path.resize(len);
+        }
+        for (; j != hy.size(); ++j, ++pos) {
+            size_t len = push(pos);
+            op("add", &y[pre + j]);
+            _path.resize(len);
+        }
+    }
+
+    /**
+     * 追加一个 token (RFC 6901：'~' -> "~0"，'/' -> "~1")，返回追加前的长度
+     */
+    size_t push(std::string_view key) {
+        size_t len = _path.size();
+        _path += '/';
+        for (char ch : key) {
+            if (ch == '~') {
+                _path += "~0";
+            } else if (ch == '/') {
+                _path += "~1";
+            } else {
+                _path += ch;
+            }
+        }
+        return len;
+    }
+    size_t push(size_t index) {
+        size_t len = _path.size();
+        _path += '/';
+        _path += std::to_string(index);
+        return len;
+    }
+
+    void op(const char* name, const Json* value) {
+        Json::_obj obj;
+        obj.emplace("op", Json(name));
+        obj.emplace("path", Json(_path));
+        if (value) obj.emplace("value", *value);
+        _ops.emplace_back(std::move(obj));
+    }
+
+private:
+    Json::_array& _ops;
+    std::string _path;
+};
+
+/**
+ * 应用 JSON Patch 的一个 op
+ * 路径上的节点通过 mutableArray() / mutableObj() 访问：共享的子树写时复制，
+ * 不在路径上的节点不受影响；只读的 op (test / copy 的 from) 不修改文档.
+ */
+class Patcher {
+public:
+    explicit Patcher(Json& doc) : _doc(doc) {}
+
+    void apply(Json& op) {
+        if (!op.isObject()) Error("INVALID PATCH", "op is not a object");
+        Json::_obj& fields = op.mutableObj();
+        std::string name(field(fields, "op").toString());
+        std::string path(field(fields, "path").toString());
+        if (name == "add") {
+            add(path, std::move(field(fields, "value")));
+        } else if (name == "remove") {
+            remove(path);
+        } else if (name == "replace") {
+            resolve(path) = std::move(field(fields, "value"));
+        } else if (name == "move") {
+            std::string from(field(fields, "from").toString());
+            if (from == path) return;
+            if (path.compare(0, from.size(), from) == 0 && path[from.size()] == '/')
+                Error("INVALID PATCH", "move into its own child: " + path);
+            add(path, remove(from));
+        } else if (name == "copy") {
+            add(path, Json(*find(std::string(field(fields, "from").toString()))));
+        } else if (name == "test") {
+            if (!(*find(path) == field(fields, "value")))
+                Error("PATCH TEST FAILED", path);
+        } else {
+            Error("INVALID PATCH", "unknown op " + name);
+        }
+    }
+
+private:
+    static Json& field(Json::_obj& fields, const char* name) {
+        auto it = fields.find(name);
+        if (it == fields.end()) Error("INVALID PATCH", std::string("missing ") + name);
+        return it->second;
+    }
+
+    static JsonPointer compile(const std::string& path) {
+        std::string errMsg;
+        auto ptr = JsonPointer::compile(path, errMsg);
+        if (!ptr) throw JsonExcept(errMsg);
+        return std::move(*ptr);
+    }
+
+    const Json* find(const std::string& path) const {
+        const Json* node = compile(path).find(static_cast<const Json&>(_doc));
+        if (!node) Error("PATCH PATH NOT FOUND", path);
+        return node;
+    }
+
+    /**
+     * 可修改地沿着 steps[0, end) 前进
+     */
+    Json& walk(const std::vector<PathStep>& steps, size_t end, const std::string& path) {
+        Json* cur = &_doc;
+        for (size_t k = 0; k != end; ++k) {
+            const PathStep& step = steps[k];
+            if (cur->isArray()) {
+                Json::_array& arr = cur->mutableArray();
+                if (step.index < 0 || static_cast<size_t>(step.index) >= arr.size())
+                    Error("PATCH PATH NOT FOUND", path);
+                cur = &arr[step.index];
+            } else if (cur->isObject()) {
+                Json::_obj& obj = cur->mutableObj();
+                auto it = obj.find(step.key);
+                if (it == obj.end()) Error("PATCH PATH NOT FOUND", path);
+                cur = &it->second;
+            } else {
+                Error("PATCH PATH NOT FOUND", path);
+            }
+        }
+        return *cur;
+    }
+
+    Json& resolve(const std::string& path) {
+        JsonPointer ptr = compile(path);
+        return walk(ptr.steps(), ptr.steps().size(), path);
+    }
+
+    void add(const std::string& path, Json value) {
+        JsonPointer ptr = compile(path);
+        auto& steps = ptr.steps();
+        if (steps.empty()) {
+            _doc = std::move(value);
+            return;
+        }
+        Json& parent = walk(steps, steps.size() - 1, path);
+        const PathStep& last = steps.back();
+        if (parent.isArray()) {
+            Json::_array& arr = parent.mutableArray();
+            if (last.key == "-") {
+                arr.push_back(std::move(value));
+            } else if (last.index >= 0 && static_cast<size_t>(last.index) <= arr.size()) {
+                arr.insert(arr.begin() + last.index, std::move(value));
+            } else {
+                Error("PATCH PATH NOT FOUND", path);
+            }
+        } else if (parent.isObject()) {
+            parent.mutableObj().insert_or_assign(last.key, std::move(value));
+        } else {
+            Error("PATCH PATH NOT FOUND", path);
+        }
+    }
+
+    Json remove(const std::string& path) {
+        JsonPointer ptr = compile(path);
+        auto& steps = ptr.steps();
+        if (steps.empty()) Error("INVALID PATCH", "cannot remove the root");
+        Json& parent = walk(steps, steps.size() - 1, path);
+        const PathStep& last = steps.back();
+        if (parent.isArray()) {
+            Json::_array& arr = parent.mutableArray();
+            if (last.index < 0 || static_cast<size_t>(last.index) >= arr.size())
+                Error("PATCH PATH NOT FOUND", path);
+            Json value = std::move(arr[last.index]);
+            arr.erase(arr.begin() + last.index);
+            return value;
+        }
+        if (parent.isObject()) {
+            Json::_obj& obj = parent.mutableObj();
+            auto it = obj.find(last.key);
+            if (it == obj.end()) Error("PATCH PATH NOT FOUND", path);
+            Json value = std::move(it->second);
+            obj.erase(it);
+            return value;
+        }
+        Error("PATCH PATH NOT FOUND", path);
+    }
+
+private:
+    Json& _doc;
+};
+
+};  // namespace
+
+Json diff(const Json& from, const Json& to) {
+    Json::_array ops;
+    Differ(ops).diff(from, to);
+    return Json(std::move(ops));
+}
+
+bool applyPatch(Json& doc, Json patch, std::string& errMsg) noexcept {
+    try {
+        if (!patch.isArray()) Error("INVALID PATCH", "patch is not a array");
+        Patcher patcher(doc);
+        for (Json& op : patch.mutableArray()) patcher.apply(op);
+        return true;
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+    }
+    return false;
+}
+
+/**
+ * RFC 7386：patch 不是对象时替换 doc；否则逐个成员合并，值为 null 的成员表示删除
+ */
+void mergePatch(Json& doc, Json patch) {
+    if (!patch.isObject()) {
+        doc = std::move(patch);
+        return;
+    }
+    if (!doc.isObject()) doc = Json(Json::_obj());
+    Json::_obj& obj = doc.mutableObj();
+    for (auto& [key, val] : patch.mutableObj()) {
+        if (val.isNull()) {
+            obj.erase(key);
+            continue;
+        }
+        auto it = obj.find(key);
+        if (it == obj.end()) it = obj.emplace(key, Json()).first;
+        mergePatch(it->second, std::move(val));
+    }
+}
+
+};                  // ------------------- namespace zzjson
@@ -0,0 +1,32 @@
+#ifndef JSON_PATCH_H__
+#define JSON_PATCH_H__
+
+#pragma once
+
+#include <string>
+#include "json.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * diff()       -> 生成把 from 变为 to 的 RFC 6902 JSON Patch (op 对象组成的数组)
+ *                 对象按 key 匹配；数组先去掉相同的首尾，中间部分按元素的哈希
+ *                 识别插入和删除，其余逐个比较；共享同一个节点 (dedup()) 的子树
+ *                 直接跳过，因此两份文档共享结构时，耗时与改动的大小成正比.
+ *                 对象成员的 op 顺序与 unordered_map 的遍历顺序一致.
+ */
+Json diff(const Json& from, const Json& to);
+
+/**
+ * applyPatch() -> 原地应用 RFC 6902 JSON Patch，value 从 patch 中移出，
+ *                 只有路径上的节点被修改 (共享的子树写时复制)
+ *                 失败时返回 false 并写入 errMsg，此前的 op 不会回滚；
+ *                 需要全部成功或全部失败时，先对副本应用.
+ * mergePatch() -> 原地应用 RFC 7386 JSON Merge Patch
+ */
+bool applyPatch(Json& doc, Json patch, std::string& errMsg) noexcept;
+void mergePatch(Json& doc, Json patch);
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_PATCH_H__
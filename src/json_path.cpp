@@ -0,0 +1,372 @@
+#include <cctype>
+#include <string>
+#include "json_except.h"
+#include "json_path.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+namespace {
+
+[[noreturn]] void Error(const char* msg, std::string_view rest) {
+    throw JsonExcept(std::string(msg) + ": " + std::string(rest));
+}
+
+/**
+ * 预先计算 key 的哈希，以及 token 作为数组下标时的值
+ * RFC 6901：下标只能是 "0" 或不以 0 开头的十进制数
+ */
+PathStep MakeChild(std::string key, bool asIndex) {
+    PathStep step;
+    step.kind = PathStep::kChild;
+    step.hash = snapshot::KeyHash(key);
+    if (asIndex && !key.empty() && key.size() <= 18 &&
+        (key[0] != '0' || key.size() == 1)) {
+        long long index = 0;
+        for (char ch : key) {
+            if (!isdigit(static_cast<unsigned char>(ch))) {
+                index = -1;
+                break;
+            }
+            index = index * 10 + (ch - '0');
+        }
+        step.index = index;
+    }
+    step.key = std::move(key);
+    return step;
+}
+
+/**
+ * 对单个节点执行 kChild，不存在时返回 nullptr
+ */
+const Json* Child(const Json& node, const PathStep& step) noexcept {
+    switch (node.getType()) {
+        case JsonType::m_obj: {
+            auto& obj = node.toObj();
+            auto it = obj.find(step.key);
+            return it == obj.end() ? nullptr : &it->second;
+        }
+        case JsonType::m_array: {
+            auto& arr = node.toArray();
+            if (step.index < 0 || static_cast<size_t>(step.index) >= arr.size())
+                return nullptr;
+            return &arr[step.index];
+        }
+        default:
+            return nullptr;
+    }
+}
+
+/**
+ * 按 Python 的切片规则计算 [start:end:step] 覆盖的下标
+ */
+template <class F>
+void ForEachSlice(const PathStep& step, long long n, F&& f) {
+    auto normalize = [n](long long i, long long lo, long long hi) {
+        if (i < 0) i += n;
+        return i < lo ? lo : (i > hi ? hi : i);
+    };
+    if (step.step > 0) {
+        long long begin = step.start ? normalize(*step.start, 0, n) : 0;
+        long long end = step.end ? normalize(*step.end, 0, n) : n;
+        for (long long i = begin; i < end; i += step.step) f(i);
+    } else {
+        long long begin = step.start ? normalize(*step.start, -1, n - 1) : n - 1;
+        long long end = step.end ? normalize(*step.end, -1, n - 1) : -1;
+        for (long long i = begin; i > end; i += step.step) f(i);
+    }
+}
+
+/**
+ * 对单个节点执行一步 JSONPath，结果追加到 out
+ */
+void Apply(const Json& node, const PathStep& step, std::vector<const Json*>& out) {
+    JsonType type = node.getType();
+    switch (step.kind) {
+        case PathStep::kChild:
+            if (type == JsonType::m_obj) {
+                if (const Json* child = Child(node, step)) out.push_back(child);
+            }
+            break;
+        case PathStep::kIndex:
+            if (type == JsonType::m_array) {
+                auto& arr = node.toArray();
+                long long n = static_cast<long long>(arr.size());
+                long long i = step.index < 0 ? step.index + n : step.index;
+                if (i >= 0 && i < n) out.push_back(&arr[i]);
+            }
+            break;
+        case PathStep::kWildcard:
+            if (type == JsonType::m_array) {
+                for (auto& val : node.toArray()) out.push_back(&val);
+            } else if (type == JsonType::m_obj) {
+                for (auto& kv : node.toObj()) out.push_back(&kv.second);
+            }
+            break;
+        case PathStep::kSlice:
+            if (type == JsonType::m_array) {
+                auto& arr = node.toArray();
+                ForEachSlice(step, static_cast<long long>(arr.size()),
+                             [&](long long i) { out.push_back(&arr[i]); });
+            }
+            break;
+    }
+}
+
+/**
+ * 展开为节点自身及其所有后代 (先序)，使用显式的栈避免深层嵌套时递归过深
+ */
+void Descendants(const Json& node, std::vector<const Json*>& out,
+                 std::vector<const Json*>& stack) {
+    stack.push_back(&node);
+    while (!stack.empty()) {
+        const Json* cur = stack.back();
+        stack.pop_back();
+        out.push_back(cur);
+        JsonType type = cur->getType();
+        if (type == JsonType::m_array) {
+            auto& arr = cur->toArray();
+            for (auto it = arr.rbegin(); it != arr.rend(); ++it) stack.push_back(&*it);
+        } else if (type == JsonType::m_obj) {
+            for (auto& kv : cur->toObj()) stack.push_back(&kv.second);
+        }
+    }
+}
+
+/**
+ * JSONPath 的词法分析
+ */
+class PathCompiler {
+public:
+    explicit PathCompiler(std::string_view text)
+        : _text(text), _cur(text.data()), _end(text.data() + text.size()) {}
+
+    std::vector<PathStep> compile() {
+        if (_cur == _end || *_cur != '$') Error("INVALID PATH", _text);
+        ++_cur;
+        std::vector<PathStep> steps;
+        while (_cur != _end) {
+            bool descend = false;
+            if (*_cur == '.') {
+                ++_cur;
+                if (_cur != _end && *_cur == '.') {
+                    ++_cur;
+                    descend = true;
+                }
+                if (_cur != _end && *_cur == '[') {
+                    if (!descend) error();
+                    steps.push_back(bracket());
+                } else {
+                    steps.push_back(dotName());
+                }
+            } else if (*_cur == '[') {
+                steps.push_back(bracket());
+            } else {
+                error();
+            }
+            steps.back().descend = descend;
+        }
+        return steps;
+    }
+
+private:
+    [[noreturn]] void error() const {
+        Error("INVALID PATH", std::string_view(_cur, _end - _cur));
+    }
+
+    PathStep dotName() {
+        if (_cur != _end && *_cur == '*') {
+            ++_cur;
+            PathStep step;
+            step.kind = PathStep::kWildcard;
+            return step;
+        }
+        auto begin = _cur;
+        while (_cur != _end && *_cur != '.' && *_cur != '[') ++_cur;
+        if (_cur == begin) error();
+        return MakeChild(std::string(begin, _cur), false);
+    }
+
+    PathStep bracket() {
+        ++_cur;     // '['
+        PathStep step;
+        if (_cur != _end && *_cur == '*') {
+            ++_cur;
+            step.kind = PathStep::kWildcard;
+        } else if (_cur != _end && (*_cur == '\'' || *_cur == '"')) {
+            step = MakeChild(quoted(), false);
+        } else {
+            std::optional<long long> first = integer();
+            if (_cur != _end && *_cur == ':') {
+                step.kind = PathStep::kSlice;
+                step.start = first;
+                ++_cur;
+                step.end = integer();
+                if (_cur != _end && *_cur == ':') {
+                    ++_cur;
+                    if (auto s = integer()) step.step = *s;
+                    if (step.step == 0) error();
+                }
+            } else {
+                if (!first) error();
+                step.kind = PathStep::kIndex;
+                step.index = *first;
+            }
+        }
+        if (_cur == _end || *_cur != ']') error();
+        ++_cur;
+        return step;
+    }
+
+    std::string quoted() {
+        char quote = *_cur++;
+        std::string key;
+        while (_cur != _end && *_cur != quote) {
+            if (*_cur == '\\') {
+                if (++_cur == _end) error();
+            }
+            key += *_cur++;
+        }
+        if (_cur == _end) error();
+        ++_cur;
+        return key;
+    }
+
+    std::optional<long long> integer() {
+        bool neg = false;
+        if (_cur != _end && *_cur == '-') {
+            neg = true;
+            ++_cur;
+        }
+        if (_cur == _end || !isdigit(static_cast<unsigned char>(*_cur))) {
+            if (neg) error();
+            return std::nullopt;
+        }
+        long long val = 0;
+        for (int n = 0; _cur != _end && isdigit(static_cast<unsigned char>(*_cur));
+             ++_cur) {
+            if (++n > 18) error();
+            val = val * 10 + (*_cur - '0');
+        }
+        return neg ? -val : val;
+    }
+
+private:
+    std::string_view _text;
+    const char* _cur;
+    const char* _end;
+};
+
+};  // namespace
+
+/**
+ * JsonPointer
+ */
+std::optional<JsonPointer> JsonPointer::compile(std::string_view text,
+                                                std::string& errMsg) noexcept {
+    try {
+        JsonPointer ptr;
+        if (text.empty()) return ptr;       // "" 表示整个文档
+        if (text[0] != '/') Error("INVALID POINTER", text);
+        size_t pos = 1;
+        while (true) {
+            size_t next = text.find('/', pos);
+            std::string_view token =
+                text.substr(pos, next == std::string_view::npos ? next : next - pos);
+            std::string key;
+            key.reserve(token.size());
+            for (size_t i = 0; i != token.size(); ++i) {
+                if (token[i] != '~') {
+                    key += token[i];
+                } else if (i + 1 != token.size() && token[i + 1] == '0') {
+                    key += '~', ++i;
+                } else if (i + 1 != token.size() && token[i + 1] == '1') {
+                    key += '/', ++i;
+                } else {
+                    Error("INVALID POINTER ESCAPE", text.substr(pos + i));
+                }
+            }
+            ptr._steps.push_back(MakeChild(std::move(key), true));
+            if (next == std::string_view::npos) break;
+            pos = next + 1;
+        }
+        return ptr;
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+    }
+    return std::nullopt;
+}
+
+const Json* JsonPointer::find(const Json& doc) const noexcept {
+    const Json* cur = &doc;
+    for (auto& step : _steps) {
+        cur = Child(*cur, step);
+        if (!cur) return nullptr;
+    }
+    return cur;
+}
+
+Json* JsonPointer::find(Json& doc) const noexcept {
+    return const_cast<Json*>(find(static_cast<const Json&>(doc)));
+}
+
+std::optional<SnapshotValue> JsonPointer::find(const SnapshotValue& doc) const noexcept {
+    SnapshotValue cur = doc;
+    for (auto& step : _steps) {
+        if (cur.isArray()) {
+            if (step.index < 0 || static_cast<size_t>(step.index) >= cur.size())
+                return std::nullopt;
+            cur = cur[step.index];
+        } else {
+            // 不是对象时 find() 返回 std::nullopt
+            auto next = cur.find(step.key, step.hash);
+            if (!next) return std::nullopt;
+            cur = *next;
+        }
+    }
+    return cur;
+}
+
+/**
+ * JsonPath
+ */
+std::optional<JsonPath> JsonPath::compile(std::string_view text,
+                                          std::string& errMsg) noexcept {
+    try {
+        JsonPath path;
+        path._steps = PathCompiler(text).compile();
+        return path;
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+    }
+    return std::nullopt;
+}
+
+void JsonPath::select(const Json& doc, std::vector<const Json*>& out) const {
+    std::vector<const Json*> cur{&doc}, next, expanded, stack;
+    for (auto& step : _steps) {
+        if (step.descend) {
+            expanded.clear();
+            for (const Json* node : cur) Descendants(*node, expanded, stack);
+            cur.swap(expanded);
+        }
+        next.clear();
+        for (const Json* node : cur) Apply(*node, step, next);
+        cur.swap(next);
+        if (cur.empty()) return;
+    }
+    out.insert(out.end(), cur.begin(), cur.end());
+}
+
+std::vector<const Json*> JsonPath::select(const Json& doc) const {
+    std::vector<const Json*> out;
+    select(doc, out);
+    return out;
+}
+
+const Json* JsonPath::first(const Json& doc) const {
+    std::vector<const Json*> out;
+    select(doc, out);
+    return out.empty() ? nullptr : out.front();
+}
+
+};                  // ------------------- namespace zzjson
@@ -0,0 +1,95 @@
+#ifndef JSON_PATH_H__
+#define JSON_PATH_H__
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "json.h"
+#include "json_snapshot.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * 编译后的路径中的一步
+ * key 和下标在编译时就准备好，查询时不再构造临时的 std::string；
+ * hash 与快照对象表中的哈希一致，查询 SnapshotValue 时直接使用.
+ */
+struct PathStep {
+    enum Kind {
+        kChild,         // key 或下标 (JSON Pointer 的 token 由节点类型决定)
+        kIndex,         // 下标，可以为负数 (从末尾数起)
+        kWildcard,      // 所有子节点
+        kSlice          // [start:end:step]
+    };
+
+    Kind kind = kChild;
+    bool descend = false;       // ".." 递归下降：先展开到所有后代 (含自身)
+    Json::_string key;         // 与对象的 key 类型相同，查找时不需要转换
+    uint32_t hash = 0;
+    long long index = -1;       // kChild 时为 -1 表示 token 不是合法的下标
+    std::optional<long long> start, end;
+    long long step = 1;
+};
+
+/**
+ * RFC 6901 JSON Pointer，例如 "/a/b/0"、"/a~1b/m~0n"
+ * 编译一次，可以对多个文档重复查询；查询不会抛出异常.
+ */
+class JsonPointer {
+public:
+    /**
+     * compile()    -> 编译路径，语法错误时返回 std::nullopt 并写入 errMsg
+     */
+    static std::optional<JsonPointer> compile(std::string_view text,
+                                              std::string& errMsg) noexcept;
+
+public:
+    /**
+     * find()       -> 不存在时返回 nullptr / std::nullopt
+     */
+    const Json* find(const Json& doc) const noexcept;
+    Json* find(Json& doc) const noexcept;
+    std::optional<SnapshotValue> find(const SnapshotValue& doc) const noexcept;
+
+    const std::vector<PathStep>& steps() const noexcept { return _steps; }
+
+private:
+    std::vector<PathStep> _steps;
+};
+
+/**
+ * JSONPath 的子集：
+ *   $                  根节点
+ *   .name  ['name']    子节点
+ *   [n]  [-n]          下标 (负数从末尾数起)
+ *   .*  [*]            所有子节点
+ *   [start:end:step]   切片
+ *   ..name  ..*  ..[n] 递归下降
+ */
+class JsonPath {
+public:
+    static std::optional<JsonPath> compile(std::string_view text,
+                                           std::string& errMsg) noexcept;
+
+public:
+    /**
+     * select()     -> 按文档顺序追加所有匹配的节点，out 可以在多次查询间复用
+     * first()      -> 第一个匹配的节点，不存在时返回 nullptr
+     */
+    void select(const Json& doc, std::vector<const Json*>& out) const;
+    std::vector<const Json*> select(const Json& doc) const;
+    const Json* first(const Json& doc) const;
+
+    const std::vector<PathStep>& steps() const noexcept { return _steps; }
+
+private:
+    std::vector<PathStep> _steps;
+};
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_PATH_H__
@@ -0,0 +1,59 @@
+#include "json_shared.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+SharedJson::Document SharedJson::share(Json doc) {
+    return Document(new Json(std::move(doc)), [](Json* json) {
+        Json::releaseAsync(std::move(*json));
+        delete json;
+    });
+}
+
+SharedJson::SharedJson(Json doc) : _current(share(std::move(doc))) {}
+
+/**
+ * 先替换指针再增加版本号：Reader 看到新的版本号时一定能 load() 到新的文档
+ */
+void SharedJson::Publish(Json&& doc) {
+    Document fresh = share(std::move(doc));
+    std::atomic_store(&_current, std::move(fresh));
+    _version.fetch_add(1, std::memory_order_release);
+}
+
+void SharedJson::store(Json doc) {
+    std::lock_guard<std::mutex> lock(_writer);
+    Publish(std::move(doc));
+}
+
+void SharedJson::update(const std::function<void(Json&)>& f) {
+    std::lock_guard<std::mutex> lock(_writer);
+    Json doc(*load());
+    f(doc);
+    Publish(std::move(doc));
+}
+
+/**
+ * 解析不持有写者的锁，只有发布时才串行
+ */
+bool SharedJson::reload(const std::string& content, std::string& errMsg,
+                        const ParseOptions& opts) {
+    std::string err;
+    Json doc = Json::parse(content, err, opts);
+    if (!err.empty()) {
+        errMsg = std::move(err);
+        return false;
+    }
+    store(std::move(doc));
+    return true;
+}
+
+std::future<std::string> SharedJson::reloadAsync(std::string content,
+                                                 const ParseOptions& opts) {
+    return std::async(std::launch::async, [this, content = std::move(content), opts] {
+        std::string errMsg;
+        reload(content, errMsg, opts);
+        return errMsg;
+    });
+}
+
+};                  // ------------------- namespace zzjson
@@ -0,0 +1,112 @@
+#ifndef JSON_SHARED_H__
+#define JSON_SHARED_H__
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "json.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * 多线程共享、可热更新的文档 (RCU)：发布的文档不再修改，读者拿到的是某个版本的
+ * 只读快照，更新时解析 / 构造新的文档再原子地替换指针，不阻塞读者.
+ * 旧的文档在最后一个引用释放时交给 Json::releaseAsync()，读者的线程不承担释放大文档的时间.
+ *
+ *   SharedJson config(Json::parse(text, errMsg));
+ *   // 读者线程：每个线程一个 Reader
+ *   SharedJson::Reader reader(config);
+ *   const Json& doc = reader.get();
+ *   // 更新线程
+ *   config.reload(newText, errMsg);
+ */
+class SharedJson {
+public:
+    using Document = std::shared_ptr<const Json>;
+
+    explicit SharedJson(Json doc = Json());
+
+    /**
+     * 把 doc 包装为只读的共享文档，最后一个引用释放时交给 Json::releaseAsync()；
+     * 引用可以在 main 返回之后释放 (命名空间作用域的 SharedJson / ParseCache)，此时直接释放
+     */
+    static Document share(Json doc);
+
+    /**
+     * 令其不可拷贝
+     */
+    SharedJson(const SharedJson&) = delete;
+    SharedJson& operator=(const SharedJson&) = delete;
+
+public:
+    /**
+     * load()       -> 当前的文档，持有期间不会被释放
+     * version()    -> 每次发布加 1，初始为 0
+     */
+    Document load() const noexcept { return std::atomic_load(&_current); }
+    uint64_t version() const noexcept { return _version.load(std::memory_order_acquire); }
+
+    /**
+     * 写者之间串行，读者不受影响：
+     * store()          -> 发布 doc
+     * update(f)        -> 在当前文档的副本上调用 f，再发布 (读 - 改 - 写不会丢失其他写者的修改)
+     * reload()         -> 在调用者的线程中解析 content 并发布；失败时返回 false 并写入 errMsg，
+     *                     当前的文档不变
+     * reloadAsync()    -> 在新的线程中 reload()，返回的 future 在完成时就绪，
+     *                     值为错误信息 (成功时为空)；future 析构时等待线程结束，
+     *                     丢弃返回值等同于同步调用，本对象必须比 future 活得久
+     */
+    void store(Json doc);
+    void update(const std::function<void(Json&)>& f);
+    bool reload(const std::string& content, std::string& errMsg,
+                const ParseOptions& opts = ParseOptions());
+    std::future<std::string> reloadAsync(std::string content,
+                                         const ParseOptions& opts = ParseOptions());
+
+public:
+    /**
+     * 读者的句柄，每个线程一个 (本身不是线程安全的)
+     * get() 只读取一次 version()：没有新的版本时直接返回缓存的文档，不写任何共享的内存，
+     * 因此不受读者数量的影响 (wait-free)；有新的版本时才 load() 一次.
+     * 返回的引用在下一次 get() 之前有效；读者很久不调用 get() 时会一直持有旧的文档.
+     */
+    class Reader {
+    public:
+        explicit Reader(const SharedJson& owner) noexcept
+            : _owner(owner), _version(owner.version()), _doc(owner.load()) {}
+
+        const Json& get() noexcept {
+            uint64_t version = _owner.version();
+            if (version != _version) {
+                // 先读版本再读指针：得到的文档不会比 version 旧
+                _doc = _owner.load();
+                _version = version;
+            }
+            return *_doc;
+        }
+        const Document& document() const noexcept { return _doc; }
+
+    private:
+        const SharedJson& _owner;
+        uint64_t _version;
+        Document _doc;
+    };
+
+private:
+    void Publish(Json&& doc);
+
+private:
+    Document _current;
+    std::atomic<uint64_t> _version{0};
+    std::mutex _writer;
+};
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_SHARED_H__
@@ -0,0 +1,130 @@
+#ifndef JSON_SIMD_H__
+#define JSON_SIMD_H__
+
+#pragma once
+
+#include <cstddef>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+namespace simd {
+
+/**
+ * 字符串扫描
+ * 返回从 p 开始、不需要特殊处理 (不是 '"'、'\\' 以及 < 0x20 的控制字符)
+ * 的连续字节数；nonAscii 表示这段字节中是否有 >= 0x80 的字节.
+ * 最多扫描到 end，不会越界读取.
+ */
+inline size_t ScanString(const char* p, const char* end, bool& nonAscii) noexcept {
+    const char* begin = p;
+    unsigned high = 0;
+#if defined(__AVX2__)
+    const __m256i quote32 = _mm256_set1_epi8('"');
+    const __m256i slash32 = _mm256_set1_epi8('\\');
+    const __m256i ctrl32  = _mm256_set1_epi8(0x1F);
+    for (; end - p >= 32; p += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        // min(x, 0x1F) == x  <=>  x <= 0x1F (无符号比较)
+        __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, quote32),
+                            _mm256_cmpeq_epi8(x, slash32)),
+            _mm256_cmpeq_epi8(_mm256_min_epu8(x, ctrl32), x));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+        unsigned hi   = static_cast<unsigned>(_mm256_movemask_epi8(x));
+        if (mask) {
+            unsigned n = __builtin_ctz(mask);
+            nonAscii = (high | (hi & ((1u << n) - 1))) != 0;
+            return p - begin + n;
+        }
+        high |= hi;
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i slash = _mm_set1_epi8('\\');
+    const __m128i ctrl  = _mm_set1_epi8(0x1F);
+    for (; end - p >= 16; p += 16) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, slash)),
+            _mm_cmpeq_epi8(_mm_min_epu8(x, ctrl), x));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+        unsigned hi   = static_cast<unsigned>(_mm_movemask_epi8(x));
+        if (mask) {
+            unsigned n = __builtin_ctz(mask);
+            nonAscii = (high | (hi & ((1u << n) - 1))) != 0;
+            return p - begin + n;
+        }
+        high |= hi;
+    }
+#endif
+    for (; p != end; ++p) {
+        auto ch = static_cast<unsigned char>(*p);
+        if (ch == '"' || ch == '\\' || ch < 0x20) break;
+        high |= ch & 0x80;
+    }
+    nonAscii = high != 0;
+    return p - begin;
+}
+
+/**
+ * UTF-8 校验
+ * 拒绝 overlong 编码、代理项 (U+D800 ~ U+DFFF) 以及大于 U+10FFFF 的码点.
+ * 详见：Unicode 标准 Table 3-7 (Well-Formed UTF-8 Byte Sequences)
+ */
+inline bool ValidUTF8(const char* s, size_t len) noexcept {
+    auto p = reinterpret_cast<const unsigned char*>(s);
+    auto end = p + len;
+    while (p != end) {
+#if defined(__SSE2__)
+        // 纯 ASCII 的部分每次跳过 16 个字节
+        if (end - p >= 16 &&
+            _mm_movemask_epi8(_mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(p))) == 0) {
+            p += 16;
+            continue;
+        }
+#endif
+        unsigned char ch = *p;
+        if (ch < 0x80) {
+            ++p;
+            continue;
+        }
+        // 第二个字节的合法范围随首字节变化
+        long n;
+        unsigned char lo = 0x80, hi = 0xBF;
+        if (ch >= 0xC2 && ch <= 0xDF) {
+            n = 2;
+        } else if (ch == 0xE0) {
+            n = 3, lo = 0xA0;           // overlong
+        } else if (ch == 0xED) {
+            n = 3, hi = 0x9F;           // surrogate
+        } else if (ch >= 0xE1 && ch <= 0xEF) {
+            n = 3;
+        } else if (ch == 0xF0) {
+            n = 4, lo = 0x90;           // overlong
+        } else if (ch >= 0xF1 && ch <= 0xF3) {
+            n = 4;
+        } else if (ch == 0xF4) {
+            n = 4, hi = 0x8F;           // > U+10FFFF
+        } else {
+            return false;               // 0x80 ~ 0xC1, 0xF5 ~ 0xFF
+        }
+        if (end - p < n || p[1] < lo || p[1] > hi) return false;
+        for (long i = 2; i != n; ++i) {
+            if ((p[i] & 0xC0) != 0x80) return false;
+        }
+        p += n;
+    }
+    return true;
+}
+
+};                  // namespace simd
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_SIMD_H__
@@ -0,0 +1,581 @@
+#include "json_snapshot.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+#include "json_except.h"
+#include "json_hash.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+namespace snapshot {
+
+/**
+ * Ref::tag
+ * 整数值且在 int32 范围内的数字直接存放在 Ref 中
+ */
+enum Tag : uint32_t {
+    kNull,
+    kFalse,
+    kTrue,
+    kInt,
+    kDouble,
+    kString,
+    kArray,
+    kObject
+};
+
+struct Header {
+    char magic[4];
+    uint32_t version;
+    uint32_t size;
+    uint32_t endian;    // 写入 kEndian，用于识别字节序不同的文件
+    Ref root;
+};
+
+constexpr char kMagic[4] = {'Z', 'Z', 'J', 'S'};
+constexpr uint32_t kVersion = 1;
+constexpr uint32_t kEndian = 0x01020304;
+
+uint32_t KeyHash(std::string_view key) noexcept {
+    return static_cast<uint32_t>(Fnv1a(key.data(), key.size()));
+}
+
+};  // namespace snapshot
+
+using namespace snapshot;
+
+namespace {
+
+template <class T>
+T Load(const char* base, size_t off) noexcept {
+    T val;
+    memcpy(&val, base + off, sizeof(T));
+    return val;
+}
+
+/**
+ * 快照的写入
+ * 容器先占好连续的表，再依次写入子节点，最后回填表项
+ */
+class SnapshotWriter {
+public:
+    std::string write(const Json& json) {
+        size_t header = Alloc(sizeof(Header));
+        Ref root = Write(json);
+        Header h;
+        memcpy(h.magic, kMagic, sizeof(kMagic));
+        h.version = kVersion;
+        h.size = static_cast<uint32_t>(_out.size());
+        h.endian = kEndian;
+        h.root = root;
+        Store(header, h);
+        return std::move(_out);
+    }
+
+private:
+    size_t Alloc(size_t n) {
+        size_t off = (_out.size() + 7) & ~size_t(7);
+        if (off + n > UINT32_MAX) throw JsonExcept("SNAPSHOT TOO LARGE");
+        _out.resize(off + n);
+        return off;
+    }
+
+    template <class T>
+    void Store(size_t off, const T& val) {
+        memcpy(&_out[off], &val, sizeof(T));
+    }
+
+    uint32_t WriteString(std::string_view str) {
+        auto it = _strings.find(str);
+        if (it != _strings.end()) return it->second;
+        size_t off = Alloc(sizeof(uint32_t) + str.size() + 1);
+        Store(off, static_cast<uint32_t>(str.size()));
+        memcpy(&_out[off + sizeof(uint32_t)], str.data(), str.size());
+        _strings.emplace(str, static_cast<uint32_t>(off));
+        return static_cast<uint32_t>(off);
+    }
+
+    Ref WriteNumber(double val) {
+        if (val == std::trunc(val) && val >= INT32_MIN && val <= INT32_MAX &&
+            !(val == 0 && std::signbit(val))) {
+            return {kInt, static_cast<uint32_t>(static_cast<int32_t>(val))};
+        }
+        size_t off = Alloc(sizeof(double));
+        Store(off, val);
+        return {kDouble, static_cast<uint32_t>(off)};
+    }
+
+    /**
+     * 紧凑数组直接从其存储写出，不生成 boxed 副本
+     */
+    Ref WritePacked(Span<const double> numbers, Span<const uint8_t> bools) {
+        size_t count = numbers.size() + bools.size();
+        size_t off = Alloc(8 + sizeof(Ref) * count);
+        Store(off, static_cast<uint32_t>(count));
+        for (size_t i = 0; i != numbers.size(); ++i) {
+            Ref ref = WriteNumber(numbers[i]);
+            Store(off + 8 + sizeof(Ref) * i, ref);
+        }
+        for (size_t i = 0; i != bools.size(); ++i) {
+            Store(off + 8 + sizeof(Ref) * i, Ref{bools[i] ? kTrue : kFalse, 0});
+        }
+        return {kArray, static_cast<uint32_t>(off)};
+    }
+
+    /**
+     * 不递归：打开的容器保存在显式的栈中，写入的顺序与逐层递归时相同；
+     * 数组的表在子节点之前分配，对象的表在所有成员写完后排序写入
+     */
+    Ref Write(const Json& root) {
+        std::vector<Frame> stack;
+        Ref ref;
+        bool done = Enter(root, stack, ref);    // ref 是否为刚写完的值
+        while (!stack.empty()) {
+            Frame& top = stack.back();
+            if (done) {
+                if (top.arr)
+                    Store(top.off + 8 + sizeof(Ref) * (top.pos - 1), ref);
+                else
+                    top.entries.back().first.value = ref;
+            }
+            if (top.arr && top.pos != top.arr->size()) {
+                done = Enter((*top.arr)[top.pos++], stack, ref);
+            } else if (top.obj && top.it != top.obj->end()) {
+                auto& p = *top.it++;
+                Entry e;
+                e.hash = KeyHash(p.first);
+                e.key = WriteString(p.first);
+                top.entries.push_back({e, &p.first});
+                done = Enter(p.second, stack, ref);
+            } else {
+                ref = top.arr ? Ref{kArray, static_cast<uint32_t>(top.off)}
+                              : WriteEntries(top.entries);
+                stack.pop_back();
+                done = true;
+            }
+        }
+        return ref;
+    }
+
+    struct Frame {
+        const Json::_array* arr;
+        const Json::_obj* obj;
+        size_t off;     // 数组的表
+        size_t pos;     // 数组中下一个元素的下标
+        Json::_obj::const_iterator it;
+        std::vector<std::pair<Entry, const Json::_string*>> entries;
+    };
+
+    /**
+     * 标量和紧凑数组直接写出到 ref 并返回 true；其他容器入栈
+     */
+    bool Enter(const Json& json, std::vector<Frame>& stack, Ref& ref) {
+        switch (json.getType()) {
+            case JsonType::m_nullptr:
+                ref = {kNull, 0};
+                return true;
+            case JsonType::m_bool:
+                ref = {json.toBool() ? kTrue : kFalse, 0};
+                return true;
+            case JsonType::m_number:
+                ref = WriteNumber(json.toDouble());
+                return true;
+            case JsonType::m_string:
+                ref = {kString, WriteString(json.toString())};
+                return true;
+            case JsonType::m_array: {
+                if (json.isPacked()) {
+                    ref = WritePacked(json.numbers(), json.bools());
+                    return true;
+                }
+                const Json::_array& arr = json.toArray();
+                size_t off = Alloc(8 + sizeof(Ref) * arr.size());
+                Store(off, static_cast<uint32_t>(arr.size()));
+                stack.push_back({&arr, nullptr, off, 0, {}, {}});
+                return false;
+            }
+            default: {
+                const Json::_obj& obj = json.toObj();
+                stack.push_back({nullptr, &obj, 0, 0, obj.begin(), {}});
+                stack.back().entries.reserve(obj.size());
+                return false;
+            }
+        }
+    }
+
+    Ref WriteEntries(std::vector<std::pair<Entry, const Json::_string*>>& entries) {
+        std::sort(entries.begin(), entries.end(),
+                  [](const auto& lhs, const auto& rhs) {
+                      if (lhs.first.hash != rhs.first.hash)
+                          return lhs.first.hash < rhs.first.hash;
+                      return *lhs.second < *rhs.second;
+                  });
+        size_t off = Alloc(8 + sizeof(Entry) * entries.size());
+        Store(off, static_cast<uint32_t>(entries.size()));
+        for (size_t i = 0; i != entries.size(); ++i) {
+            Store(off + 8 + sizeof(Entry) * i, entries[i].first);
+        }
+        return {kObject, static_cast<uint32_t>(off)};
+    }
+
+    std::string _out;
+    std::unordered_map<std::string_view, uint32_t> _strings;    // 已写入的字符串 -> 偏移量
+};
+
+/**
+ * 完整检查快照中的偏移量，防止损坏的文件导致越界访问
+ * 写入时每个数组 / 对象都是新分配的记录，只被引用一次：再次遇到同一个容器
+ * (环或共享的子节点) 说明文件是伪造的，因此检查的总量与文件大小成正比.
+ * 用显式的栈代替递归，并限制嵌套层数，通过检查的快照可以安全地递归 toJson().
+ */
+class SnapshotVerifier {
+public:
+    static constexpr size_t kMaxDepth = 1000;
+
+    SnapshotVerifier(const char* base, size_t size)
+        : _base(base), _size(size), _seen(size / 8 + 1) {}
+
+    void Check(Ref root) {
+        std::vector<std::pair<Ref, size_t>> stack{{root, 0}};
+        while (!stack.empty()) {
+            auto [ref, depth] = stack.back();
+            stack.pop_back();
+            switch (ref.tag) {
+                case kNull:
+                case kFalse:
+                case kTrue:
+                case kInt:
+                    break;
+                case kDouble:
+                    Range(ref.data, sizeof(double));
+                    break;
+                case kString:
+                    CheckString(ref.data);
+                    break;
+                case kArray: {
+                    uint32_t count = Enter(ref.data, sizeof(Ref), depth);
+                    for (uint32_t i = 0; i != count; ++i) {
+                        stack.push_back(
+                            {Load<Ref>(_base, ref.data + 8 + sizeof(Ref) * i), depth + 1});
+                    }
+                    break;
+                }
+                case kObject: {
+                    uint32_t count = Enter(ref.data, sizeof(Entry), depth);
+                    for (uint32_t i = 0; i != count; ++i) {
+                        auto e = Load<Entry>(_base, ref.data + 8 + sizeof(Entry) * i);
+                        CheckString(e.key);
+                        stack.push_back({e.value, depth + 1});
+                    }
+                    break;
+                }
+                default:
+                    Fail(ref.data);
+            }
+        }
+    }
+
+private:
+    [[noreturn]] void Fail(size_t off) const {
+        throw JsonExcept("INVALID SNAPSHOT: offset " + std::to_string(off));
+    }
+
+    void Range(size_t off, size_t len) const {
+        if (off % 8 != 0 || off > _size || len > _size - off) Fail(off);
+    }
+
+    void CheckString(size_t off) const {
+        Range(off, sizeof(uint32_t));
+        Range(off, sizeof(uint32_t) + size_t(Load<uint32_t>(_base, off)) + 1);
+    }
+
+    /**
+     * 检查容器的表并记录已访问，返回元素个数
+     */
+    uint32_t Enter(size_t off, size_t entrySize, size_t depth) {
+        Range(off, 8);
+        if (_seen[off / 8]) Fail(off);
+        _seen[off / 8] = true;
+        if (depth >= kMaxDepth)
+            throw JsonExcept("SNAPSHOT TOO DEEP: offset " + std::to_string(off));
+        uint32_t count = Load<uint32_t>(_base, off);
+        Range(off, 8 + entrySize * size_t(count));
+        return count;
+    }
+
+private:
+    const char* _base;
+    size_t _size;
+    std::vector<bool> _seen;    // 按 8 字节的槽记录已访问的容器
+};
+
+}  // namespace
+
+/**
+ * SnapshotValue
+ */
+JsonType SnapshotValue::getType() const noexcept {
+    switch (_ref.tag) {
+        case kNull:
+            return JsonType::m_nullptr;
+        case kFalse:
+        case kTrue:
+            return JsonType::m_bool;
+        case kInt:
+        case kDouble:
+            return JsonType::m_number;
+        case kString:
+            return JsonType::m_string;
+        case kArray:
+            return JsonType::m_array;
+        default:
+            return JsonType::m_obj;
+    }
+}
+
+bool SnapshotValue::toBool() const {
+    if (_ref.tag == kTrue) return true;
+    if (_ref.tag == kFalse) return false;
+    throw JsonExcept("Error! Not a bool!");
+}
+
+double SnapshotValue::toDouble() const {
+    if (_ref.tag == kInt) return static_cast<int32_t>(_ref.data);
+    if (_ref.tag == kDouble) return Load<double>(_base, _ref.data);
+    throw JsonExcept("Error! Not a double!");
+}
+
+std::string_view SnapshotValue::toString() const {
+    if (_ref.tag != kString) throw JsonExcept("Error! Not a string!");
+    return std::string_view(_base + _ref.data + sizeof(uint32_t),
+                            Load<uint32_t>(_base, _ref.data));
+}
+
+size_t SnapshotValue::size() const {
+    if (_ref.tag != kArray && _ref.tag != kObject)
+        throw JsonExcept("Error! Not a array or object!");
+    return Load<uint32_t>(_base, _ref.data);
+}
+
+SnapshotValue SnapshotValue::operator[](size_t pos) const {
+    if (_ref.tag != kArray) throw JsonExcept("Error! Not a array!");
+    if (pos >= Load<uint32_t>(_base, _ref.data))
+        throw JsonExcept("Error! Index out of range!");
+    return SnapshotValue(_base, Load<Ref>(_base, _ref.data + 8 + sizeof(Ref) * pos));
+}
+
+SnapshotValue SnapshotValue::operator[](std::string_view key) const {
+    if (_ref.tag != kObject) throw JsonExcept("Error! Not a object!");
+    auto val = find(key);
+    if (!val) throw JsonExcept("Error! Key not found!");
+    return *val;
+}
+
+std::optional<SnapshotValue> SnapshotValue::find(std::string_view key) const noexcept {
+    return find(key, KeyHash(key));
+}
+
+/**
+ * 先按哈希二分查找，哈希相同时再比较 key
+ */
+std::optional<SnapshotValue> SnapshotValue::find(std::string_view key,
+                                                 uint32_t hash) const noexcept {
+    if (_ref.tag != kObject) return std::nullopt;
+    size_t lo = 0, hi = Load<uint32_t>(_base, _ref.data);
+    const char* table = _base + _ref.data + 8;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (Load<uint32_t>(table, sizeof(Entry) * mid) < hash)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    size_t count = Load<uint32_t>(_base, _ref.data);
+    for (; lo != count; ++lo) {
+        auto e = Load<Entry>(table, sizeof(Entry) * lo);
+        if (e.hash != hash) break;
+        if (SnapshotValue(_base, {kString, e.key}).toString() == key)
+            return SnapshotValue(_base, e.value);
+    }
+    return std::nullopt;
+}
+
+std::string_view SnapshotValue::keyAt(size_t pos) const {
+    if (_ref.tag != kObject) throw JsonExcept("Error! Not a object!");
+    if (pos >= Load<uint32_t>(_base, _ref.data))
+        throw JsonExcept("Error! Index out of range!");
+    auto e = Load<Entry>(_base, _ref.data + 8 + sizeof(Entry) * pos);
+    return SnapshotValue(_base, {kString, e.key}).toString();
+}
+
+SnapshotValue SnapshotValue::valueAt(size_t pos) const {
+    if (_ref.tag != kObject) throw JsonExcept("Error! Not a object!");
+    if (pos >= Load<uint32_t>(_base, _ref.data))
+        throw JsonExcept("Error! Index out of range!");
+    auto e = Load<Entry>(_base, _ref.data + 8 + sizeof(Entry) * pos);
+    return SnapshotValue(_base, e.value);
+}
+
+Json SnapshotValue::toJson() const {
+    switch (getType()) {
+        case JsonType::m_nullptr:
+            return Json(nullptr);
+        case JsonType::m_bool:
+            return Json(toBool());
+        case JsonType::m_number:
+            return Json(toDouble());
+        case JsonType::m_string:
+            return Json(toString());
+        case JsonType::m_array: {
+            Json::_array arr;
+            arr.reserve(size());
+            for (size_t i = 0; i != size(); ++i) arr.push_back((*this)[i].toJson());
+            return Json(std::move(arr));
+        }
+        default: {
+            Json::_obj obj;
+            obj.reserve(size());
+            for (size_t i = 0; i != size(); ++i) {
+                obj.try_emplace(Json::_string(keyAt(i)), valueAt(i).toJson());
+            }
+            return Json(std::move(obj));
+        }
+    }
+}
+
+/**
+ * Snapshot
+ */
+std::string Snapshot::write(const Json& json) {
+    SnapshotWriter writer;
+    return writer.write(json);
+}
+
+std::optional<Snapshot> Snapshot::freeze(const Json& json,
+                                         std::string& errMsg) noexcept {
+    try {
+        std::string data = write(json);
+        data.shrink_to_fit();
+        return fromBuffer(std::move(data), errMsg);
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+    }
+    return std::nullopt;
+}
+
+bool Snapshot::save(const Json& json, const std::string& path,
+                    std::string& errMsg) noexcept {
+    try {
+        std::string data = write(json);
+        std::ofstream ofstrm(path, std::ios::binary | std::ios::trunc);
+        if (!ofstrm.write(data.data(), data.size())) {
+            errMsg = "SAVE SNAPSHOT FAILED: " + path;
+            return false;
+        }
+        return true;
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+        return false;
+    }
+}
+
+std::optional<Snapshot> Snapshot::open(const std::string& path,
+                                       std::string& errMsg,
+                                       bool verify) noexcept {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        errMsg = "OPEN SNAPSHOT FAILED: " + path + ": " + strerror(errno);
+        return std::nullopt;
+    }
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        errMsg = "OPEN SNAPSHOT FAILED: " + path + ": empty file";
+        ::close(fd);
+        return std::nullopt;
+    }
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        errMsg = "OPEN SNAPSHOT FAILED: " + path + ": " + strerror(errno);
+        return std::nullopt;
+    }
+    Snapshot snap;
+    snap._data = static_cast<const char*>(addr);
+    snap._size = st.st_size;
+    snap._mapped = true;
+    try {
+        snap.check(verify);
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+        return std::nullopt;
+    }
+    return std::optional<Snapshot>(std::move(snap));
+}
+
+std::optional<Snapshot> Snapshot::fromBuffer(std::string buffer,
+                                             std::string& errMsg,
+                                             bool verify) noexcept {
+    Snapshot snap;
+    snap._buffer = std::move(buffer);
+    snap._data = snap._buffer.data();
+    snap._size = snap._buffer.size();
+    try {
+        snap.check(verify);
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+        return std::nullopt;
+    }
+    return std::optional<Snapshot>(std::move(snap));
+}
+
+Snapshot::Snapshot(Snapshot&& rhs) noexcept { *this = std::move(rhs); }
+
+Snapshot& Snapshot::operator=(Snapshot&& rhs) noexcept {
+    if (this != &rhs) {
+        if (_mapped) munmap(const_cast<char*>(_data), _size);
+        _mapped = rhs._mapped;
+        _size = rhs._size;
+        _buffer = std::move(rhs._buffer);
+        // 缓冲区移动之后地址可能改变 (SSO)
+        _data = _mapped ? rhs._data : _buffer.data();
+        rhs._data = nullptr;
+        rhs._size = 0;
+        rhs._mapped = false;
+    }
+    return *this;
+}
+
+Snapshot::~Snapshot() {
+    if (_mapped) munmap(const_cast<char*>(_data), _size);
+}
+
+SnapshotValue Snapshot::root() const noexcept {
+    return SnapshotValue(_data, Load<Header>(_data, 0).root);
+}
+
+/**
+ * 检查文件头；verify 为 true 时检查全部偏移量
+ */
+void Snapshot::check(bool verify) const {
+    if (_size < sizeof(Header)) throw JsonExcept("INVALID SNAPSHOT: bad header");
+    auto h = Load<Header>(_data, 0);
+    if (memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion ||
+        h.endian != kEndian || h.size != _size)
+        throw JsonExcept("INVALID SNAPSHOT: bad header");
+    if (verify) {
+        SnapshotVerifier(_data, _size).Check(h.root);
+    } else if (h.root.tag > kObject ||
+               (h.root.tag >= kDouble && h.root.data >= _size)) {
+        throw JsonExcept("INVALID SNAPSHOT: bad root");
+    }
+}
+
+};                  // ------------------- namespace zzjson
@@ -0,0 +1,168 @@
+#ifndef JSON_SNAPSHOT_H__
+#define JSON_SNAPSHOT_H__
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include "json.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * 快照格式：由 Json 一次性写出，之后可以直接 mmap 并原地查询，不需要反序列化.
+ *
+ * 布局 (小端序，所有记录按 8 字节对齐)：
+ *   Header  { "ZZJS", version, size, 0, root }
+ *   Ref     { tag, data }               -> 8 字节，null/bool/int32 直接存放在 data 中，
+ *                                          其余类型的 data 为记录的偏移量
+ *   double  { value }
+ *   string  { len, bytes..., '\0' }
+ *   array   { count, 0, Ref[count] }    -> 连续存放
+ *   object  { count, 0, Entry[count] }  -> Entry { hash, key, Ref }，按 (hash, key) 排序
+ * 内容相同的字符串 (含 key) 只写入一次.
+ *
+ * 全部使用偏移量而不是指针，同一个文件可以在多个进程间通过 page cache 共享.
+ */
+namespace snapshot {
+
+struct Ref {
+    uint32_t tag;
+    uint32_t data;
+};
+
+struct Entry {
+    uint32_t hash;      // key 的 FNV-1a 哈希的低 32 位
+    uint32_t key;       // string 记录的偏移量
+    Ref value;
+};
+
+/**
+ * key 在对象中的哈希，与 Entry::hash 一致
+ */
+uint32_t KeyHash(std::string_view key) noexcept;
+
+};  // namespace snapshot
+
+/**
+ * 快照中某个值的只读视图，只包含指针和 8 字节的 Ref，可以随意拷贝
+ * 接口与 Json 相同，字符串以 string_view 的形式返回
+ */
+class SnapshotValue {
+public:
+    SnapshotValue(const char* base, snapshot::Ref ref) noexcept
+        : _base(base), _ref(ref) {}
+
+public:
+    /**
+     * 类型接口
+     */
+    JsonType getType() const noexcept;
+
+    bool isNull()   const noexcept { return getType() == JsonType::m_nullptr; }
+    bool isBool()   const noexcept { return getType() == JsonType::m_bool; }
+    bool isNumber() const noexcept { return getType() == JsonType::m_number; }
+    bool isString() const noexcept { return getType() == JsonType::m_string; }
+    bool isArray()  const noexcept { return getType() == JsonType::m_array; }
+    bool isObject() const noexcept { return getType() == JsonType::m_obj; }
+
+public:
+    /**
+     * 类型转换接口，类型不符时抛出 JsonExcept
+     */
+    bool toBool() const;
+    double toDouble() const;
+    std::string_view toString() const;
+
+public:
+    /**
+     * 访问 array / obj 的接口
+     * operator[] 越界或 key 不存在时抛出 JsonExcept；find() 不抛异常
+     * keyAt() / valueAt() 按存储顺序遍历对象
+     */
+    size_t size() const;
+    SnapshotValue operator[](size_t) const;
+    SnapshotValue operator[](std::string_view) const;
+    std::optional<SnapshotValue> find(std::string_view key) const noexcept;
+    std::optional<SnapshotValue> find(std::string_view key,
+                                      uint32_t hash) const noexcept;
+    std::string_view keyAt(size_t) const;
+    SnapshotValue valueAt(size_t) const;
+
+public:
+    /**
+     * 转换为 Json
+     */
+    Json toJson() const;
+
+private:
+    const char* _base;
+    snapshot::Ref _ref;
+};
+
+/**
+ * 快照本身，持有 mmap 的映射或内存中的缓冲区
+ */
+class Snapshot {
+public:
+    /**
+     * open()       -> mmap 快照文件，verify 为 true 时会完整检查一遍所有偏移量
+     *                 (不可信的文件应当检查)：拒绝越界、环和被多处引用的容器，
+     *                 嵌套超过 1000 层时报 SNAPSHOT TOO DEEP
+     * fromBuffer() -> 使用内存中的快照
+     * errMsg       -> 存储异常消息
+     */
+    static std::optional<Snapshot> open(const std::string& path,
+                                        std::string& errMsg,
+                                        bool verify = false) noexcept;
+    static std::optional<Snapshot> fromBuffer(std::string buffer,
+                                              std::string& errMsg,
+                                              bool verify = false) noexcept;
+
+    /**
+     * write()      -> 把 Json 写成快照
+     * save()       -> 把 Json 写成快照文件
+     */
+    static std::string write(const Json& json);
+    static bool save(const Json& json, const std::string& path,
+                     std::string& errMsg) noexcept;
+
+    /**
+     * freeze()     -> 把 Json 转换为内存中的快照，作为长期缓存的只读文档：
+     *                 扁平有序的对象、去重的字符串、没有多余的容量，
+     *                 通常比 Json::compact() 之后的 memoryUsage() 小得多
+     */
+    static std::optional<Snapshot> freeze(const Json& json,
+                                          std::string& errMsg) noexcept;
+
+public:
+    Snapshot(Snapshot&&) noexcept;
+    Snapshot& operator=(Snapshot&&) noexcept;
+    ~Snapshot();
+
+    /**
+     * 令其不可拷贝
+     */
+    Snapshot(const Snapshot&) = delete;
+    Snapshot& operator=(const Snapshot&) = delete;
+
+public:
+    SnapshotValue root() const noexcept;
+    size_t byteSize() const noexcept { return _size; }
+
+private:
+    Snapshot() = default;
+    void check(bool verify) const;
+
+private:
+    const char* _data = nullptr;
+    size_t _size = 0;
+    bool _mapped = false;       // true 时 _data 来自 mmap
+    std::string _buffer;
+};
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_SNAPSHOT_H__
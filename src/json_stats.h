@@ -0,0 +1,120 @@
+#ifndef JSON_STATS_H__
+#define JSON_STATS_H__
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * 一次解析的统计 (ParseOptions::stats)
+ * 每次解析开始时清零 (onFinish 保留)，结束时 (包括失败) 调用 onFinish，
+ * 可以直接接入监控系统；只对需要采样的请求设置即可.
+ * 编译时定义 ZZJSON_DISABLE_STATS 则不产生任何统计代码，stats 被忽略.
+ */
+struct ParseStats {
+    size_t bytes = 0;           // 输入的字节数
+
+    // 各类型的值的数量 (紧凑数组中的元素也计入 numbers / bools)
+    size_t nulls = 0;
+    size_t bools = 0;
+    size_t numbers = 0;
+    size_t strings = 0;
+    size_t arrays = 0;
+    size_t objects = 0;
+    size_t keys = 0;
+
+    size_t maxDepth = 0;        // 最大嵌套层数，标量为 0，[] 为 1
+    size_t escapedStrings = 0;  // 含转义序列的字符串和 key
+    size_t bytesCopied = 0;     // 写入字符串和 key 的字节数
+    size_t allocations = 0;     // 构造 Json 时的分配次数：节点、容器扩容和字符串缓冲区
+
+    std::chrono::nanoseconds parseTime{0};
+    bool ok = false;
+
+    std::function<void(const ParseStats&)> onFinish;
+
+    size_t values() const noexcept {
+        return nulls + bools + numbers + strings + arrays + objects;
+    }
+    void reset() noexcept {
+        auto callback = std::move(onFinish);
+        *this = ParseStats();
+        onFinish = std::move(callback);
+    }
+};
+
+/**
+ * 一次序列化的统计 (WriterOptions::stats)，用法与 ParseStats 相同
+ * 只统计 serialize() (以及 serializeParallel() / writeParallel() 的
+ * bytes 和耗时)，serializeTo() 只累加计数，不清零也不计时.
+ */
+struct SerializeStats {
+    size_t bytes = 0;           // 输出的字节数
+    size_t values = 0;          // 输出的值的数量 (含紧凑数组中的元素)
+    size_t maxDepth = 0;
+    size_t escapedStrings = 0;  // 输出时需要转义的字符串和 key
+
+    std::chrono::nanoseconds serializeTime{0};
+
+    std::function<void(const SerializeStats&)> onFinish;
+
+    void reset() noexcept {
+        auto callback = std::move(onFinish);
+        *this = SerializeStats();
+        onFinish = std::move(callback);
+    }
+};
+
+/**
+ * 统计一次调用：构造时清零并开始计时，finish() 时记录耗时并调用 onFinish
+ * stats 为空 (或定义了 ZZJSON_DISABLE_STATS) 时什么都不做
+ */
+template <class Stats>
+class StatsScope {
+public:
+#ifndef ZZJSON_DISABLE_STATS
+    explicit StatsScope(Stats* stats) noexcept : _stats(stats) {
+        if (_stats) {
+            _stats->reset();
+            _begin = std::chrono::steady_clock::now();
+        }
+    }
+#else
+    explicit StatsScope(Stats*) noexcept : _stats(nullptr) {}
+#endif
+
+    /**
+     * 令其不可拷贝
+     */
+    StatsScope(const StatsScope&) = delete;
+    StatsScope& operator=(const StatsScope&) = delete;
+
+    Stats* operator->() const noexcept { return _stats; }
+    explicit operator bool() const noexcept { return _stats != nullptr; }
+
+    /**
+     * elapsed -> 对应的耗时字段
+     */
+    void finish(std::chrono::nanoseconds Stats::*elapsed) {
+#ifndef ZZJSON_DISABLE_STATS
+        if (!_stats) return;
+        _stats->*elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - _begin);
+        if (_stats->onFinish) _stats->onFinish(*_stats);
+#else
+        (void)elapsed;
+#endif
+    }
+
+private:
+    Stats* _stats;
+    std::chrono::steady_clock::time_point _begin;
+};
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_STATS_H__
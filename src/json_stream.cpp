@@ -0,0 +1,283 @@
+#include <algorithm>
+#include <string>
+#include "json_except.h"
+#include "json_stream.h"
+#include "parse.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+namespace {
+
+bool SameStep(const PathStep& a, const PathStep& b) noexcept {
+    return a.kind == b.kind && a.key == b.key && a.index == b.index &&
+           a.start == b.start && a.end == b.end && a.step == b.step;
+}
+
+bool MatchKey(const PathStep& step, std::string_view key) noexcept {
+    return step.kind == PathStep::kWildcard ||
+           (step.kind == PathStep::kChild && step.key == key);
+}
+
+/**
+ * 切片在添加时已经限制为非负数，不需要知道数组的长度
+ */
+bool MatchIndex(const PathStep& step, long long i) noexcept {
+    switch (step.kind) {
+        case PathStep::kChild:
+        case PathStep::kIndex:
+            return step.index == i;
+        case PathStep::kWildcard:
+            return true;
+        case PathStep::kSlice: {
+            long long start = step.start ? *step.start : 0;
+            return i >= start && (!step.end || i < *step.end) &&
+                   (i - start) % step.step == 0;
+        }
+    }
+    return false;
+}
+
+};  // namespace
+
+/**
+ * 对一个文档 (或 NDJSON 中的一条记录) 执行提取
+ * _levels[depth] 为当前深度上处于活动状态的前缀树节点
+ */
+class StreamWalker {
+public:
+    StreamWalker(const std::vector<StreamExtractor::Node>& nodes, Parser& parser,
+                 const StreamExtractor::Callback& onMatch)
+        : _nodes(nodes), _p(parser), _onMatch(onMatch), _levels(1) {}
+
+    void root() {
+        _levels[0].assign(1, 0);
+        value(0);
+    }
+
+private:
+    void value(size_t depth) {
+        bool terminal = false, inner = false;
+        for (size_t n : _levels[depth]) {
+            terminal |= !_nodes[n].paths.empty();
+            inner |= !_nodes[n].children.empty();
+        }
+        if (terminal) {
+            // 有路径在此结束：解码整个值，更深的路径直接在解码后的值上查找
+            Json val = _p.readValue();
+            _matches.clear();
+            for (size_t n : _levels[depth]) collect(n, val);
+            emit(val);
+            return;
+        }
+        switch (inner ? _p.peek() : '\0') {
+            case '{':
+                object(depth);
+                break;
+            case '[':
+                array(depth);
+                break;
+            default:
+                _p.skipValue();
+                break;
+        }
+    }
+
+    void object(size_t depth) {
+        _p.consume('{');
+        if (_p.consume('}')) return;
+        if (_levels.size() < depth + 2) _levels.resize(depth + 2);
+        do {
+            std::string_view key = _p.readKey(_scratch);
+            _p.expect(':', "MISS COLON");
+            auto& next = _levels[depth + 1];
+            next.clear();
+            for (size_t n : _levels[depth]) {
+                for (auto& child : _nodes[n].children) {
+                    if (MatchKey(child.first, key)) next.push_back(child.second);
+                }
+            }
+            if (next.empty())
+                _p.skipValue();
+            else
+                value(depth + 1);
+        } while (_p.consume(','));
+        _p.expect('}', "MISS COMMA OR CURLY BRACKET");
+    }
+
+    void array(size_t depth) {
+        _p.consume('[');
+        if (_p.consume(']')) return;
+        if (_levels.size() < depth + 2) _levels.resize(depth + 2);
+        long long i = 0;
+        do {
+            auto& next = _levels[depth + 1];
+            next.clear();
+            for (size_t n : _levels[depth]) {
+                for (auto& child : _nodes[n].children) {
+                    if (MatchIndex(child.first, i)) next.push_back(child.second);
+                }
+            }
+            if (next.empty())
+                _p.skipValue();
+            else
+                value(depth + 1);
+            ++i;
+        } while (_p.consume(','));
+        _p.expect(']', "MISS COMMA OR SQUARE BRACKET");
+    }
+
+    /**
+     * 在已经解码的值上继续匹配前缀树
+     */
+    void collect(size_t n, const Json& val) {
+        for (size_t path : _nodes[n].paths) _matches.push_back({path, &val});
+        for (auto& child : _nodes[n].children) {
+            const PathStep& step = child.first;
+            switch (val.getType()) {
+                case JsonType::m_obj:
+                    for (auto& kv : val.toObj()) {
+                        if (MatchKey(step, kv.first)) collect(child.second, kv.second);
+                    }
+                    break;
+                case JsonType::m_array: {
+                    auto& arr = val.toArray();
+                    for (size_t i = 0; i != arr.size(); ++i) {
+                        if (MatchIndex(step, static_cast<long long>(i)))
+                            collect(child.second, arr[i]);
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+    }
+
+    /**
+     * 只有一个匹配且就是解码出的值本身时直接交给回调，否则逐个拷贝
+     */
+    void emit(Json& val) {
+        if (_matches.size() == 1 && _matches[0].second == &val) {
+            _onMatch(_matches[0].first, val);
+            return;
+        }
+        for (auto& match : _matches) {
+            Json copy(*match.second);
+            _onMatch(match.first, copy);
+        }
+    }
+
+private:
+    const std::vector<StreamExtractor::Node>& _nodes;
+    Parser& _p;
+    const StreamExtractor::Callback& _onMatch;
+    std::vector<std::vector<size_t>> _levels;
+    std::vector<std::pair<size_t, const Json*>> _matches;
+    std::string _scratch;
+};
+
+/**
+ * StreamExtractor
+ */
+StreamExtractor::StreamExtractor() : _nodes(1) {}
+
+size_t StreamExtractor::insert(const std::vector<PathStep>& steps) {
+    size_t cur = 0;
+    for (auto& step : steps) {
+        size_t next = 0;
+        for (auto& child : _nodes[cur].children) {
+            if (SameStep(child.first, step)) next = child.second;
+        }
+        if (next == 0) {
+            next = _nodes.size();
+            _nodes[cur].children.push_back({step, next});
+            _nodes.emplace_back();
+        }
+        cur = next;
+    }
+    _nodes[cur].paths.push_back(_paths);
+    return _paths++;
+}
+
+size_t StreamExtractor::add(const JsonPointer& ptr) {
+    return insert(ptr.steps());
+}
+
+/**
+ * 流式处理时不知道数组的长度，也不会回头查找，
+ * 因此不支持递归下降和负数的下标/切片
+ */
+std::optional<size_t> StreamExtractor::add(const JsonPath& path,
+                                           std::string& errMsg) {
+    for (auto& step : path.steps()) {
+        if (step.descend) {
+            errMsg = "UNSUPPORTED PATH: recursive descent";
+            return std::nullopt;
+        }
+        if ((step.kind == PathStep::kIndex && step.index < 0) ||
+            (step.kind == PathStep::kSlice &&
+             ((step.start && *step.start < 0) || (step.end && *step.end < 0) ||
+              step.step < 0))) {
+            errMsg = "UNSUPPORTED PATH: negative index";
+            return std::nullopt;
+        }
+    }
+    return insert(path.steps());
+}
+
+bool StreamExtractor::extract(const std::string& content, const Callback& onMatch,
+                              std::string& errMsg) const {
+    try {
+        Parser parser(content);
+        StreamWalker(_nodes, parser, onMatch).root();
+        parser.finish();
+        return true;
+    } catch (JsonExcept& e) {
+        errMsg = e.what();
+    }
+    return false;
+}
+
+bool StreamExtractor::extract(const std::string& content, Slots& slots,
+                              std::string& errMsg) const {
+    slots.assign(_paths, std::nullopt);
+    return extract(content, [&](size_t path, Json& val) {
+        if (!slots[path]) slots[path] = std::move(val);
+    }, errMsg);
+}
+
+bool StreamExtractor::extractLines(const std::string& content,
+                                   const Callback& onMatch,
+                                   const RecordCallback& onRecord,
+                                   std::string& errMsg) const {
+    size_t record = 0;
+    try {
+        Parser parser(content);
+        StreamWalker walker(_nodes, parser, onMatch);
+        while (parser.peek() != '\0') {
+            walker.root();
+            onRecord(record++);
+        }
+        return true;
+    } catch (JsonExcept& e) {
+        // 只保留出错的那一行，附上记录的编号
+        std::string msg = e.what();
+        msg.resize(std::min(msg.size(), msg.find('\n')));
+        errMsg = msg + " (record " + std::to_string(record) + ")";
+    }
+    return false;
+}
+
+bool StreamExtractor::extractLines(const std::string& content, Slots& slots,
+                                   const RecordCallback& onRecord,
+                                   std::string& errMsg) const {
+    slots.assign(_paths, std::nullopt);
+    return extractLines(content, [&](size_t path, Json& val) {
+        if (!slots[path]) slots[path] = std::move(val);
+    }, [&](size_t record) {
+        onRecord(record);
+        for (auto& slot : slots) slot.reset();
+    }, errMsg);
+}
+
+};                  // ------------------- namespace zzjson
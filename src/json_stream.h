@@ -0,0 +1,85 @@
+#ifndef JSON_STREAM_H__
+#define JSON_STREAM_H__
+
+#pragma once
+
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "json.h"
+#include "json_path.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+class StreamWalker;
+
+/**
+ * 流式提取：不构造整棵 Json 树，只解码路径匹配到的值，
+ * 其余部分直接跳过 (与 validate() 相同的速度).
+ * 所有路径合并为一棵前缀树，输入只扫描一遍.
+ *
+ * 支持 JsonPointer，以及不含递归下降、负数下标的 JsonPath.
+ * 提取不修改内部状态，同一个 StreamExtractor 可以在多个线程中同时使用.
+ */
+class StreamExtractor {
+public:
+    /**
+     * onMatch(path, value)     -> path 为路径的编号，value 可以被移走
+     * onRecord(record)         -> NDJSON 中一条记录处理完毕
+     * Slots                    -> slots[i] 为第 i 条路径的第一个匹配，未匹配时为空
+     */
+    using Callback = std::function<void(size_t path, Json& value)>;
+    using RecordCallback = std::function<void(size_t record)>;
+    using Slots = std::vector<std::optional<Json>>;
+
+public:
+    StreamExtractor();
+
+    /**
+     * add()    -> 添加路径，返回路径的编号 (按添加顺序从 0 开始)
+     *             JsonPath 含有不支持的步骤时返回 std::nullopt 并写入 errMsg
+     */
+    size_t add(const JsonPointer& ptr);
+    std::optional<size_t> add(const JsonPath& path, std::string& errMsg);
+    size_t size() const noexcept { return _paths; }
+
+public:
+    /**
+     * extract()        -> 处理单个文档
+     * extractLines()   -> 处理 NDJSON，记录之间以空白分隔，
+     *                     slots 在每条记录开始时清空
+     * 语法错误时返回 false 并写入 errMsg；回调抛出的异常不会被捕获
+     */
+    bool extract(const std::string& content, const Callback& onMatch,
+                 std::string& errMsg) const;
+    bool extract(const std::string& content, Slots& slots,
+                 std::string& errMsg) const;
+    bool extractLines(const std::string& content, const Callback& onMatch,
+                      const RecordCallback& onRecord, std::string& errMsg) const;
+    bool extractLines(const std::string& content, Slots& slots,
+                      const RecordCallback& onRecord, std::string& errMsg) const;
+
+private:
+    friend class StreamWalker;
+
+    /**
+     * 前缀树的节点，_nodes[0] 为根节点
+     * children 中每一项为 (步骤, 子节点的下标)；paths 为在此结束的路径
+     */
+    struct Node {
+        std::vector<std::pair<PathStep, size_t>> children;
+        std::vector<size_t> paths;
+    };
+
+    size_t insert(const std::vector<PathStep>& steps);
+
+private:
+    std::vector<Node> _nodes;
+    size_t _paths = 0;
+};
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_STREAM_H__
@@ -1,5 +1,7 @@
 #include "json_val.h"   
 // #include <variant> -> since C++17
+#include <cstdlib>
+#include <thread>
 #include "json_except.h"
 
 namespace zzjson {  // ------------------- namespace zzjson
@@ -7,24 +9,18 @@ namespace zzjson {  // ------------------- namespace zzjson
 
 /**
  * 数据类型接口
+ * 按 variant 的下标查表，代替逐个 std::holds_alternative
  */
 JsonType JsonValue::getType() const noexcept {
-    // variant 是 C++17 所提供的变体类型.
-    // variant<X, Y, Z> 是可存放 X, Y, Z 这三种类型数据的变体类型.
-    // std::holds_alternative<T>(v) 可查询变体类型 v 是否存放了 T 类型的数据.
-    if (std::holds_alternative<std::nullptr_t>(_val)) {
-        return JsonType::m_nullptr;
-    } else if (std::holds_alternative<bool>(_val)) {
-        return JsonType::m_bool;
-    } else if (std::holds_alternative<double>(_val)) {
-        return JsonType::m_number;
-    } else if (std::holds_alternative<std::string>(_val)) {
-        return JsonType::m_string;
-    } else if (std::holds_alternative<Json::_array>(_val)) {
-        return JsonType::m_array;
-    } else {
-        return JsonType::m_obj;
-    }
+    static constexpr JsonType kTypes[] = {
+        JsonType::m_nullptr, JsonType::m_bool, JsonType::m_number, JsonType::m_string,
+        JsonType::m_array,   JsonType::m_obj,
+        JsonType::m_array,   // 紧凑存储的数组
+        JsonType::m_number,  // 延迟转换的数字
+    };
+    size_t index = _val.index();
+    if (index < sizeof(kTypes) / sizeof(kTypes[0])) return kTypes[index];
+    return shared()->json.getType();
 }
 
 /**
@@ -35,6 +31,10 @@ size_t JsonValue::size() const {
         return std::get<Json::_array>(_val).size();
     } else if (std::holds_alternative<Json::_obj>(_val)) {
         return std::get<Json::_obj>(_val).size();
+    } else if (auto node = shared()) {
+        return node->json.size();
+    } else if (auto packed = this->packed()) {
+        return packed->size();
     } else {
         throw JsonExcept("Error! Not a array or object!");
     }
@@ -46,6 +46,10 @@ size_t JsonValue::size() const {
 const Json& JsonValue::operator[](size_t pos) const {
     if (std::holds_alternative<Json::_array>(_val)) {
         return std::get<Json::_array>(_val)[pos];
+    } else if (auto node = shared()) {
+        return node->json[pos];
+    } else if (auto packed = this->packed()) {
+        return packed->boxed()[pos];
     } else {
         throw JsonExcept("Error! Not a array!");
     }
@@ -61,83 +65,250 @@ const Json& JsonValue::operator[](size_t pos) const {
  * > reinterpreter_cast: 不同类型的指针类型转换.
  */
 Json& JsonValue::operator[](size_t pos) {
-    return const_cast<Json&>(static_cast<const JsonValue&>(*this)[pos]);
+    // 元素可能被修改，紧凑存储的数组先转换回普通的数组，共享的子树先拷贝
+    Json::_array& arr = mutableArray();
+    if (pos >= arr.size()) throw JsonExcept("Error! Out of range!");
+    return arr[pos];
 }
 
 /**
  * O(1)访问 array
  */
-const Json& JsonValue::operator[](const std::string& key) const {
+const Json& JsonValue::operator[](std::string_view key) const {
     if (std::holds_alternative<Json::_obj>(_val)) {
-        return std::get<Json::_obj>(_val).at(key);
+        return std::get<Json::_obj>(_val).at(MemberKey(key));
+    } else if (auto node = shared()) {
+        return node->json[key];
     } else {
         throw JsonExcept("Error! Not a object!");
     }
 }
 
-Json& JsonValue::operator[](const std::string& key) {
-    return const_cast<Json&>(static_cast<const JsonValue&>(*this)[key]);
+/**
+ * key 不存在时插入 null
+ */
+Json& JsonValue::operator[](std::string_view key) {
+    Json::_obj& obj = makeObj();
+    auto it = obj.find(MemberKey(key));
+    if (it != obj.end()) return it->second;
+    return obj.try_emplace(Json::_string(key, _resource), nullptr).first->second;
+}
+
+Json::_array& JsonValue::mutableArray() {
+    unshare();
+    if (auto packed = std::get_if<PackedPtr>(&_val)) {
+        _val = (*packed)->unpack();
+    }
+    return const_cast<Json::_array&>(toArray());
+}
+
+Json::_obj& JsonValue::mutableObj() {
+    unshare();
+    return const_cast<Json::_obj&>(toObj());
+}
+
+Json::_array& JsonValue::makeArray() {
+    if (std::holds_alternative<std::nullptr_t>(_val)) return _val.emplace<Json::_array>(_resource);
+    return mutableArray();
+}
+
+Json::_obj& JsonValue::makeObj() {
+    if (std::holds_alternative<std::nullptr_t>(_val)) return _val.emplace<Json::_obj>(_resource);
+    return mutableObj();
+}
+
+void JsonValue::reserve(size_t n) {
+    unshare();
+    if (auto arr = std::get_if<Json::_array>(&_val)) {
+        arr->reserve(n);
+    } else if (auto obj = std::get_if<Json::_obj>(&_val)) {
+        obj->reserve(n);
+    } else if (auto packed = std::get_if<PackedPtr>(&_val)) {
+        _val = (*packed)->unpack();
+        std::get<Json::_array>(_val).reserve(n);
+    } else {
+        throw JsonExcept("Error! Not a array or object!");
+    }
 }
 
 /**
  * 转换接口
+ * std::get 在类型不符时抛出 std::bad_variant_access，这里改用 std::get_if：
+ * 类型相符时不进入异常处理，不符时才抛出 JsonExcept
  */
 std::nullptr_t JsonValue::toNull() const {
-    try {
-        return std::get<std::nullptr_t>(_val);
-    }
-    // class bad_variant_access : public std::exception (sice C++17)
-    // ----------------------------------------------------------------
-    // std::bad_variant_access 是下列情形中抛出的异常类型：
-    // 以不匹配当前活跃可选项的下标或类型调用 std::get(std::variant).
-    // 调用 std::visit 观览因异常无值 (valueless_by_exception) 的 variant.
-    catch (const std::bad_variant_access&) {
-        throw JsonExcept("Error! Not a null!");
-    }
+    if (auto node = shared()) return node->json._jsonVal->toNull();
+    if (!std::holds_alternative<std::nullptr_t>(_val)) throw JsonExcept("Error! Not a null!");
+    return nullptr;
 }
 
 bool JsonValue::toBool() const {
-    try {
-        return std::get<bool>(_val);
-    } catch (const std::bad_variant_access&) {
-        throw JsonExcept("Error! Not a bool!");
-    }
+    if (auto val = std::get_if<bool>(&_val)) return *val;
+    if (auto node = shared()) return node->json.toBool();
+    throw JsonExcept("Error! Not a bool!");
 }
 
 double JsonValue::toDouble() const {
-    try {
-        return std::get<double>(_val);
-    } catch (const std::bad_variant_access&) {
-        throw JsonExcept("Error! Not a double!");
-    }
+    if (auto val = std::get_if<double>(&_val)) return *val;
+    if (auto raw = std::get_if<RawNumber>(&_val)) return raw->value();
+    if (auto node = shared()) return node->json.toDouble();
+    throw JsonExcept("Error! Not a double!");
 }
 
-const std::string& JsonValue::toString() const {
-    try {
-        return std::get<std::string>(_val);
-    }
-    catch (const std::bad_variant_access&) {
-        throw JsonExcept("Error! Not a string!");
-    }
+const Json::_string& JsonValue::toString() const {
+    if (auto val = std::get_if<Json::_string>(&_val)) return *val;
+    if (auto node = shared()) return node->json._jsonVal->toString();
+    throw JsonExcept("Error! Not a string!");
 }
 
 const Json::_array& JsonValue::toArray() const {
-    try {
-        return std::get<Json::_array>(_val);
-    }
-    catch (const std::bad_variant_access&) {
-        throw JsonExcept("Error! Not a array!");
-    }
+    if (auto val = std::get_if<Json::_array>(&_val)) return *val;
+    if (auto node = shared()) return node->json.toArray();
+    if (auto packed = this->packed()) return packed->boxed();
+    throw JsonExcept("Error! Not a array!");
 }
 
 const Json::_obj& JsonValue::toObj() const {
-    try {
-        return std::get<Json::_obj>(_val);
+    if (auto val = std::get_if<Json::_obj>(&_val)) return *val;
+    if (auto node = shared()) return node->json.toObj();
+    throw JsonExcept("Error! Not a object!");
+}
+
+const PackedArray* JsonValue::packed() const noexcept {
+    if (auto node = shared()) return node->json._jsonVal->packed();
+    auto packed = std::get_if<PackedPtr>(&_val);
+    return packed ? packed->get() : nullptr;
+}
+
+PackedArray* JsonValue::mutablePacked() noexcept {
+    auto packed = std::get_if<PackedPtr>(&_val);
+    return packed ? packed->get() : nullptr;
+}
+
+/**
+ * 共享的子树
+ */
+const SharedNode* JsonValue::shared() const noexcept {
+    auto node = std::get_if<SharedPtr>(&_val);
+    return node ? node->get() : nullptr;
+}
+
+/**
+ * 只拷贝顶层：子节点中共享的部分拷贝后仍然共享
+ */
+void JsonValue::unshare() {
+    auto node = shared();
+    if (!node) return;
+    Json copy(node->json, Alloc(_resource));
+    _val = std::move(copy._jsonVal->_val);
+}
+
+/**
+ * 原地复用
+ */
+Json::_string& JsonValue::reuseString() {
+    if (auto str = std::get_if<Json::_string>(&_val)) return *str;
+    return _val.emplace<Json::_string>(_resource);
+}
+
+void JsonValue::assignRaw(std::string_view text) {
+    if (auto raw = std::get_if<RawNumber>(&_val)) return raw->reset(text);
+    _val.emplace<RawNumber>(text, _resource);
+}
+
+Json::_array& JsonValue::reuseArray() {
+    if (auto arr = std::get_if<Json::_array>(&_val)) return *arr;
+    return _val.emplace<Json::_array>(_resource);
+}
+
+Json::_obj& JsonValue::reuseObj() {
+    if (auto obj = std::get_if<Json::_obj>(&_val)) return *obj;
+    return _val.emplace<Json::_obj>(_resource);
+}
+
+std::pmr::vector<double>* JsonValue::reusePackedNumbers() noexcept {
+    auto packed = std::get_if<PackedPtr>(&_val);
+    if (!packed || (*packed)->isBool()) return nullptr;
+    return &(*packed)->reuseNumbers();
+}
+
+std::pmr::vector<uint8_t>* JsonValue::reusePackedBools() noexcept {
+    auto packed = std::get_if<PackedPtr>(&_val);
+    if (!packed || !(*packed)->isBool()) return nullptr;
+    return &(*packed)->reuseBools();
+}
+
+/**
+ * RawNumber
+ * 原文已经在解析时校验过 (包括 NUMBER TOO BIG)，strtod 不会失败；
+ * CAS 成功的线程负责转换，其余的线程等待其发布结果.
+ */
+const double& RawNumber::value() const noexcept {
+    uint8_t state = _state.load(std::memory_order_acquire);
+    if (state == kReady) return _value;
+    if (state == kPending &&
+        _state.compare_exchange_strong(state, kConverting, std::memory_order_acquire)) {
+        _value = strtod(_text.c_str(), nullptr);
+        _state.store(kReady, std::memory_order_release);
+        return _value;
     }
-    catch (const std::bad_variant_access&) {
-        throw JsonExcept("Error! Not a object!");
+    while (_state.load(std::memory_order_acquire) != kReady) std::this_thread::yield();
+    return _value;
+}
+
+/**
+ * PackedArray
+ */
+Json::_array PackedArray::box() const {
+    Json::_array arr(resource());
+    arr.reserve(size());
+    if (_isBool) {
+        for (uint8_t val : _bools) arr.emplace_back(val != 0);
+    } else {
+        for (double val : _numbers) arr.emplace_back(val);
     }
+    return arr;
+}
+
+/**
+ * 同时生成 boxed 副本的线程中只有一个 CAS 成功，其余的丢弃自己的副本
+ */
+const Json::_array& PackedArray::boxed() const {
+    Json::_array* boxed = _boxed.load(std::memory_order_acquire);
+    if (boxed) return *boxed;
+    Json::_array* fresh = NewIn<Json::_array>(resource(), box());
+    if (_boxed.compare_exchange_strong(boxed, fresh,
+                                       std::memory_order_acq_rel,
+                                       std::memory_order_acquire)) {
+        return *fresh;
+    }
+    DeleteIn(resource(), fresh);
+    return *boxed;
+}
+
+std::pmr::vector<double>& PackedArray::reuseNumbers() noexcept {
+    DeleteIn(resource(), _boxed.exchange(nullptr, std::memory_order_acq_rel));
+    _numbers.clear();
+    return _numbers;
+}
+
+std::pmr::vector<uint8_t>& PackedArray::reuseBools() noexcept {
+    DeleteIn(resource(), _boxed.exchange(nullptr, std::memory_order_acq_rel));
+    _bools.clear();
+    return _bools;
+}
+
+void PackedArray::compact() {
+    DeleteIn(resource(), _boxed.exchange(nullptr, std::memory_order_acq_rel));
+    _numbers.shrink_to_fit();
+    _bools.shrink_to_fit();
+}
+
+Json::_array PackedArray::unpack() {
+    if (Json::_array* boxed = _boxed.load(std::memory_order_acquire))
+        return std::move(*boxed);
+    return box();
 }
 
 
-};      // ------------------- namespace zzjson
\ No newline at end of file
+};      // ------------------- namespace zzjson
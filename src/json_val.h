@@ -3,12 +3,164 @@
 
 #pragma once
 
+#include <atomic>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
 #include <variant>  // since C++17
 #include "json.h"
 #include "json_except.h"
 
 namespace zzjson {  // ------------------- namespace zzjson
 
+/**
+ * 在 resource 中构造 / 销毁单个对象，代替 new / delete
+ */
+template <class T, class... Args>
+T* NewIn(std::pmr::memory_resource* resource, Args&&... args) {
+    void* ptr = resource->allocate(sizeof(T), alignof(T));
+    try {
+        return new (ptr) T(std::forward<Args>(args)...);
+    } catch (...) {
+        resource->deallocate(ptr, sizeof(T), alignof(T));
+        throw;
+    }
+}
+
+template <class T>
+void DeleteIn(std::pmr::memory_resource* resource, T* ptr) noexcept {
+    if (!ptr) return;
+    ptr->~T();
+    resource->deallocate(ptr, sizeof(T), alignof(T));
+}
+
+/**
+ * 紧凑存储的数组：元素全部为数字 (double) 或全部为 bool (uint8_t)
+ * 需要 Json 形式的元素时 (operator[] / toArray()) 才生成一份 boxed 副本；
+ * 多个线程同时只读访问时通过 CAS 发布，最终只保留一份.
+ * 存储和 boxed 副本都分配在 numbers / bools 的 memory_resource 中.
+ */
+class PackedArray {
+public:
+    explicit PackedArray(std::pmr::vector<double>&& numbers)
+        : _numbers(std::move(numbers)), _bools(_numbers.get_allocator()),
+          _isBool(false) {}
+    explicit PackedArray(std::pmr::vector<uint8_t>&& bools)
+        : _numbers(bools.get_allocator()), _bools(std::move(bools)),
+          _isBool(true) {}
+
+    // 只拷贝紧凑的数据，boxed 副本按需重新生成
+    PackedArray(const PackedArray& rhs, std::pmr::memory_resource* resource)
+        : _numbers(rhs._numbers, resource), _bools(rhs._bools, resource),
+          _isBool(rhs._isBool) {}
+    PackedArray& operator=(const PackedArray&) = delete;
+    ~PackedArray() { DeleteIn(resource(), _boxed.load(std::memory_order_acquire)); }
+
+public:
+    bool isBool() const noexcept { return _isBool; }
+    size_t size() const noexcept {
+        return _isBool ? _bools.size() : _numbers.size();
+    }
+    const std::pmr::vector<double>& numbers() const noexcept { return _numbers; }
+    const std::pmr::vector<uint8_t>& bools() const noexcept { return _bools; }
+    std::pmr::memory_resource* resource() const noexcept {
+        return _numbers.get_allocator().resource();
+    }
+
+    /**
+     * boxed()  -> Json 形式的元素，第一次调用时生成
+     * unpack() -> 转换为普通的数组，之后不再使用本对象
+     */
+    const Json::_array& boxed() const;
+    Json::_array unpack();
+
+    /**
+     * 原地复用 (ParseContext)：清空并返回存储 (保留容量)，丢弃 boxed 副本
+     */
+    std::pmr::vector<double>& reuseNumbers() noexcept;
+    std::pmr::vector<uint8_t>& reuseBools() noexcept;
+
+    /**
+     * compact()    -> 去掉存储中多余的容量，丢弃 boxed 副本
+     * boxedIfAny() -> 已经生成的 boxed 副本，没有时返回 nullptr
+     */
+    void compact();
+    const Json::_array* boxedIfAny() const noexcept {
+        return _boxed.load(std::memory_order_acquire);
+    }
+
+private:
+    Json::_array box() const;
+
+private:
+    std::pmr::vector<double> _numbers;
+    std::pmr::vector<uint8_t> _bools;
+    bool _isBool;
+    mutable std::atomic<Json::_array*> _boxed{nullptr};
+};
+
+struct PackedDeleter {
+    void operator()(PackedArray* packed) const noexcept {
+        if (packed) DeleteIn(packed->resource(), packed);
+    }
+};
+
+using PackedPtr = std::unique_ptr<PackedArray, PackedDeleter>;
+
+/**
+ * 延迟转换的数字 (ParseOptions::lazyNumbers)：保存解析时校验过的原文，
+ * 第一次读取数值时才调用 strtod 并缓存结果；序列化时原样输出原文.
+ * 多个线程同时只读访问时只有一个线程转换，其他线程等待其完成.
+ */
+class RawNumber {
+public:
+    RawNumber(std::string_view text, std::pmr::memory_resource* resource)
+        : _text(text, resource) {}
+
+    // 原文使用构造时的 resource (移动时随原文转移)，拷贝通过 JsonValue::assignRaw() 进行；
+    // 赋值只拷贝原文，数值按需重新转换
+    RawNumber(RawNumber&& rhs) noexcept : _text(std::move(rhs._text)) {}
+    RawNumber& operator=(const RawNumber& rhs) {
+        reset(rhs._text);
+        return *this;
+    }
+
+public:
+    const Json::_string& text() const noexcept { return _text; }
+    const double& value() const noexcept;
+
+    /**
+     * 原地复用 (ParseContext)：替换原文 (保留容量)，清除缓存的数值
+     */
+    void reset(std::string_view text) {
+        _text.assign(text.data(), text.size());
+        _state.store(kPending, std::memory_order_relaxed);
+    }
+
+private:
+    enum : uint8_t { kPending, kConverting, kReady };
+
+    Json::_string _text;
+    mutable std::atomic<uint8_t> _state{kPending};
+    mutable double _value = 0;
+};
+
+/**
+ * Json::dedup() 之后多处共享的只读子树，同时缓存其哈希值 (子树不再改变)
+ * 分配在子树所在的 memory_resource 中；通过非 const 的接口修改时先拷贝一份.
+ */
+struct SharedNode {
+    explicit SharedNode(Json&& val) noexcept : json(std::move(val)) {}
+
+    Json json;
+    mutable std::atomic<uint64_t> hash{0};      // 0 表示尚未计算
+};
+
+using SharedPtr = std::shared_ptr<const SharedNode>;
+
+/**
+ * 每个节点记录自己所在的 memory_resource，数组和对象的元素使用同一个 resource
+ */
 class JsonValue {
 public:
     /**
@@ -16,20 +168,45 @@ public:
      * 
      * tips: explicit -> 禁用只有一个参数的构造函数的隐式调用
      */
-    explicit JsonValue(std::nullptr_t)          : _val(nullptr) {}
-    explicit JsonValue(bool val)                : _val(val) {}
-    explicit JsonValue(double val)              : _val(val) {}
-    explicit JsonValue(const std::string& val)  : _val(val) {}
-    explicit JsonValue(const Json::_array& val) : _val(val) {}
-    explicit JsonValue(const Json::_obj& val)   : _val(val) {}
+    using Alloc = Json::allocator_type;
+
+    explicit JsonValue(std::nullptr_t, const Alloc& alloc)
+        : _val(nullptr), _resource(alloc.resource()) {}
+    explicit JsonValue(bool val, const Alloc& alloc)
+        : _val(val), _resource(alloc.resource()) {}
+    explicit JsonValue(double val, const Alloc& alloc)
+        : _val(val), _resource(alloc.resource()) {}
+    explicit JsonValue(std::string_view val, const Alloc& alloc)
+        : _val(std::in_place_type<Json::_string>, val, alloc), _resource(alloc.resource()) {}
+    explicit JsonValue(const Json::_array& val, const Alloc& alloc)
+        : _val(std::in_place_type<Json::_array>, val, alloc),
+          _resource(alloc.resource()) {}
+    explicit JsonValue(const Json::_obj& val, const Alloc& alloc)
+        : _val(std::in_place_type<Json::_obj>, val, alloc),
+          _resource(alloc.resource()) {}
 
 public:
     /**
      * 移动构造函数
+     * resource 相同时直接接管，否则逐个元素拷贝到 alloc 中
      */
-    explicit JsonValue(std::string  && val)      : _val(std::move(val)) {}
-    explicit JsonValue(Json::_array && val)      : _val(std::move(val)) {}
-    explicit JsonValue(Json::_obj   && val)      : _val(std::move(val)) {}
+    explicit JsonValue(Json::_string&& val, const Alloc& alloc)
+        : _val(std::in_place_type<Json::_string>, std::move(val), alloc),
+          _resource(alloc.resource()) {}
+    explicit JsonValue(Json::_array&& val, const Alloc& alloc)
+        : _val(std::in_place_type<Json::_array>, std::move(val), alloc),
+          _resource(alloc.resource()) {}
+    explicit JsonValue(Json::_obj&& val, const Alloc& alloc)
+        : _val(std::in_place_type<Json::_obj>, std::move(val), alloc),
+          _resource(alloc.resource()) {}
+    explicit JsonValue(PackedPtr&& val)
+        : _val(std::move(val)), _resource(std::get<PackedPtr>(_val)->resource()) {}
+    explicit JsonValue(const SharedPtr& val, const Alloc& alloc)
+        : _val(val), _resource(alloc.resource()) {}
+    explicit JsonValue(std::in_place_type_t<RawNumber>, std::string_view text,
+                       const Alloc& alloc)
+        : _val(std::in_place_type<RawNumber>, text, alloc.resource()),
+          _resource(alloc.resource()) {}
 
 public:
     /**
@@ -43,20 +220,41 @@ public:
      */
     JsonType getType() const noexcept;
 
+    /**
+     * 按 variant 的下标只分派一次，穿过共享的节点：以 std::nullptr_t / bool / double /
+     * const Json::_string& / const Json::_array& / const Json::_obj& / const PackedArray& /
+     * const RawNumber& 调用 f，返回类型与 f(nullptr) 相同
+     */
+    template <class F>
+    auto visit(F&& f) const -> decltype(f(nullptr)) {
+        return std::visit(
+            [&](const auto& val) -> decltype(f(nullptr)) {
+                using T = std::decay_t<decltype(val)>;
+                if constexpr (std::is_same_v<T, PackedPtr>) {
+                    return f(*val);
+                } else if constexpr (std::is_same_v<T, SharedPtr>) {
+                    return val->json._jsonVal->visit(f);
+                } else {
+                    return f(val);
+                }
+            },
+            _val);
+    }
+
 public:
     size_t size() const;
 
     /**
-     * 访问 array
+     * 访问 array，非 const 版本在 pos 越界时抛出 JsonExcept
      */
     Json& operator[] (size_t);
     const Json& operator[] (size_t) const;
 
     /**
-     * 访问 obj
+     * 访问 obj，非 const 版本在 key 不存在时插入 null (null 先变为空的对象)
      */
-    Json& operator[] (const std::string&);
-    const Json& operator[] (const std::string&) const;
+    Json& operator[] (std::string_view);
+    const Json& operator[] (std::string_view) const;
 
 public:
     /**
@@ -66,14 +264,80 @@ public:
     std::nullptr_t toNull() const;
     bool toBool() const;
     double toDouble() const;
-    const std::string& toString() const;
+    const Json::_string& toString() const;
     const Json::_array& toArray() const;
     const Json::_obj& toObj() const;
 
+    /**
+     * 可修改的 array / obj：共享的子树先拷贝，紧凑数组先转换回普通的数组
+     * make*()  -> 同上，null 先变为空的数组 / 对象 (供构建接口使用)
+     */
+    Json::_array& mutableArray();
+    Json::_obj& mutableObj();
+    Json::_array& makeArray();
+    Json::_obj& makeObj();
+    void reserve(size_t n);
+
+    /**
+     * 紧凑存储的数组，不是时返回 nullptr
+     * mutablePacked() 不穿过共享的节点 (供 Json::compact() 使用)
+     */
+    const PackedArray* packed() const noexcept;
+    PackedArray* mutablePacked() noexcept;
+
+    /**
+     * 延迟转换的数字 (ParseOptions::lazyNumbers)，不是时返回 nullptr
+     */
+    const RawNumber* rawNumber() const noexcept { return std::get_if<RawNumber>(&_val); }
+
+    /**
+     * 节点自己的数组 / 对象，不穿过共享的节点，也不转换紧凑数组；不是时返回 nullptr
+     * (供 Json 的析构逐层摘下子节点)
+     */
+    Json::_array* ownedArray() noexcept { return std::get_if<Json::_array>(&_val); }
+    Json::_obj* ownedObj() noexcept { return std::get_if<Json::_obj>(&_val); }
+
+    /**
+     * 共享的子树 (Json::dedup())
+     * shared()     -> 共享的节点，不是时返回 nullptr；以上只读接口都会穿过它
+     * share()      -> 替换为对 node 的引用
+     * unshare()    -> 拷贝一份共享的子树的顶层，之后可以修改
+     */
+    const SharedNode* shared() const noexcept;
+    SharedPtr sharedPtr() const noexcept {
+        auto node = std::get_if<SharedPtr>(&_val);
+        return node ? *node : nullptr;
+    }
+    void share(SharedPtr node) noexcept { _val = std::move(node); }
+    void unshare();
+
+public:
+    /**
+     * 原地复用 (ParseContext)：
+     * assign()         -> 替换为标量
+     * assignRaw()      -> 替换为延迟转换的数字，原来就是时复用其缓冲区
+     * reuse*()         -> 切换为对应的类型并返回可修改的引用；已经是该类型时
+     *                     保留原有的内容和容量，由调用者覆盖
+     * reusePacked*()   -> 已经是同类的紧凑数组时清空并返回其存储，否则返回 nullptr
+     */
+    void assign(std::nullptr_t) noexcept { _val.emplace<std::nullptr_t>(); }
+    void assign(bool val) noexcept { _val.emplace<bool>(val); }
+    void assign(double val) noexcept { _val.emplace<double>(val); }
+    void assignRaw(std::string_view text);
+    Json::_string& reuseString();
+    Json::_array& reuseArray();
+    Json::_obj& reuseObj();
+    std::pmr::vector<double>* reusePackedNumbers() noexcept;
+    std::pmr::vector<uint8_t>* reusePackedBools() noexcept;
+
+    std::pmr::memory_resource* resource() const noexcept { return _resource; }
+
 private:
     std::variant<std::nullptr_t, bool, double, 
-                 std::string, Json::_array, Json::_obj>
+                 Json::_string, Json::_array, Json::_obj,
+                 PackedPtr, RawNumber, SharedPtr>
         _val;
+    std::pmr::memory_resource* _resource;
 
     /**
      * Notes:
@@ -89,6 +353,44 @@ private:
      */
 };
 
+/**
+ * Json::get_if() / Json::visit()：与 JsonValue::visit() 是同一次分派
+ * 紧凑数组以 Span 交给 f，不生成 boxed 副本；延迟转换的数字先转换 (结果缓存)
+ */
+template <class T>
+const T* Json::get_if() const {
+    static_assert(std::is_same_v<T, std::nullptr_t> || std::is_same_v<T, bool> ||
+                      std::is_same_v<T, double> || std::is_same_v<T, _string> ||
+                      std::is_same_v<T, _array> || std::is_same_v<T, _obj>,
+                  "not a Json value type");
+    return _jsonVal->visit([](const auto& val) -> const T* {
+        using V = std::decay_t<decltype(val)>;
+        if constexpr (std::is_same_v<V, T>) {
+            return &val;
+        } else if constexpr (std::is_same_v<V, RawNumber> && std::is_same_v<T, double>) {
+            return &val.value();
+        } else {
+            return nullptr;
+        }
+    });
+}
+
+template <class F>
+decltype(auto) Json::visit(F&& f) const {
+    return _jsonVal->visit([&](const auto& val) -> decltype(f(nullptr)) {
+        using V = std::decay_t<decltype(val)>;
+        if constexpr (std::is_same_v<V, PackedArray>) {
+            if (val.isBool())
+                return f(Span<const uint8_t>(val.bools().data(), val.bools().size()));
+            return f(Span<const double>(val.numbers().data(), val.numbers().size()));
+        } else if constexpr (std::is_same_v<V, RawNumber>) {
+            return f(val.value());
+        } else {
+            return f(val);
+        }
+    });
+}
+
 };                  // ------------------- namespace zzjson
 
 
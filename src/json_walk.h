@@ -0,0 +1,248 @@
+#ifndef JSON_WALK_H__
+#define JSON_WALK_H__
+
+#pragma once
+
+#include <memory_resource>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "json.h"
+
+namespace zzjson {  // ------------------- namespace zzjson
+
+/**
+ * 深度优先遍历的事件
+ */
+enum class WalkKind {
+    kValue,     // 标量
+    kEnter,     // 进入数组 / 对象 (先序)
+    kLeave      // 离开数组 / 对象 (后序)，其子节点已经全部访问过
+};
+
+/**
+ * 不递归的深度优先遍历：用显式的栈代替调用栈，文档的深度只影响栈的大小
+ *
+ *   JsonCursor cur(json);
+ *   while (cur.next()) { cur.kind(); cur.value(); cur.path(); ... }
+ *
+ * 数组的元素按下标，对象的成员按 unordered_map 的遍历顺序；穿过共享的子树.
+ * 紧凑数组的元素为其 boxed 副本，第一次读取其元素时才生成：kEnter 时 skip() 的紧凑数组
+ * 不分配内存，可以通过 value().numbers() / bools() 直接读取.
+ * MutableJsonCursor 通过 mutableArray() / mutableObj() 进入容器 (共享的子树写时复制)：
+ * kValue / kLeave 时可以修改或替换 value()；kEnter 时修改容器本身之前先 skip().
+ */
+template <class J>
+class BasicJsonCursor {
+    static constexpr bool kConst = std::is_const_v<J>;
+    using Array = std::conditional_t<kConst, const Json::_array, Json::_array>;
+    using Obj = std::conditional_t<kConst, const Json::_obj, Json::_obj>;
+    using ObjIter = std::conditional_t<kConst, Json::_obj::const_iterator,
+                                       Json::_obj::iterator>;
+
+public:
+    /**
+     * resource -> 栈所使用的 memory_resource
+     */
+    explicit BasicJsonCursor(J& root, std::pmr::memory_resource* resource =
+                                          std::pmr::get_default_resource())
+        : _stack(resource), _cur(&root) {}
+
+    /**
+     * next()   -> 前进到下一个事件，遍历结束时返回 false
+     * skip()   -> kEnter 时调用：不进入当前的容器，也不产生它的 kLeave
+     */
+    bool next() {
+        if (!_started) {
+            _started = true;
+            arrive(*_cur, nullptr, 0);
+            return true;
+        }
+        if (_stack.empty()) return false;
+        Frame& top = _stack.back();
+        if (!top.arr && !top.obj) top.arr = ArrayOf(*top.node);
+        if (top.arr && top.pos != top.arr->size()) {
+            size_t index = top.pos++;
+            arrive((*top.arr)[index], nullptr, index);
+        } else if (top.obj && top.it != top.obj->end()) {
+            auto it = top.it++;
+            arrive(it->second, &it->first, 0);
+        } else {
+            _kind = WalkKind::kLeave;
+            _cur = top.node;
+            _key = top.key;
+            _index = top.index;
+            _stack.pop_back();
+        }
+        return true;
+    }
+
+    void skip() {
+        if (_kind == WalkKind::kEnter) _stack.pop_back();
+    }
+
+public:
+    /**
+     * 当前事件
+     * key()    -> 对象成员的 key，不是对象的成员时为 nullptr
+     * index()  -> 数组元素的下标，不是数组的元素时为 0
+     * depth()  -> 根节点为 0
+     * path()   -> 当前值的 JSON Pointer，按需生成
+     */
+    WalkKind kind() const noexcept { return _kind; }
+    J& value() const noexcept { return *_cur; }
+    const Json::_string* key() const noexcept { return _key; }
+    size_t index() const noexcept { return _index; }
+    size_t depth() const noexcept {
+        return _kind == WalkKind::kEnter ? _stack.size() - 1 : _stack.size();
+    }
+
+    std::string path() const {
+        std::string res;
+        size_t ancestors = _kind == WalkKind::kEnter ? _stack.size() - 1 : _stack.size();
+        for (size_t i = 1; i < ancestors; ++i) AppendToken(res, _stack[i].key, _stack[i].index);
+        if (depth() != 0) AppendToken(res, _key, _index);
+        return res;
+    }
+
+private:
+    /**
+     * 每个进入的容器一帧：key / index 为容器本身在父节点中的位置
+     * 紧凑数组的 arr 和 obj 都为 nullptr，第一次读取元素时才取得 arr
+     */
+    struct Frame {
+        J* node;
+        Array* arr;
+        Obj* obj;
+        size_t pos;
+        ObjIter it;
+        const Json::_string* key;
+        size_t index;
+    };
+
+    void arrive(J& val, const Json::_string* key, size_t index) {
+        _cur = &val;
+        _key = key;
+        _index = index;
+        if (val.isArray()) {
+            _kind = WalkKind::kEnter;
+            Array* arr = val.isPacked() ? nullptr : ArrayOf(val);
+            _stack.push_back({&val, arr, nullptr, 0, ObjIter(), key, index});
+        } else if (val.isObject()) {
+            _kind = WalkKind::kEnter;
+            Obj* obj;
+            if constexpr (kConst) {
+                obj = &val.toObj();
+            } else {
+                obj = &val.mutableObj();
+            }
+            _stack.push_back({&val, nullptr, obj, 0, obj->begin(), key, index});
+        } else {
+            _kind = WalkKind::kValue;
+        }
+    }
+
+    static Array* ArrayOf(J& val) {
+        if constexpr (kConst) {
+            return &val.toArray();
+        } else {
+            return &val.mutableArray();
+        }
+    }
+
+    static void AppendToken(std::string& res, const Json::_string* key, size_t index) {
+        res += '/';
+        if (!key) {
+            res += std::to_string(index);
+            return;
+        }
+        for (char ch : *key) {
+            if (ch == '~') {
+                res += "~0";
+            } else if (ch == '/') {
+                res += "~1";
+            } else {
+                res += ch;
+            }
+        }
+    }
+
+private:
+    std::pmr::vector<Frame> _stack;
+    J* _cur;
+    const Json::_string* _key = nullptr;
+    size_t _index = 0;
+    WalkKind _kind = WalkKind::kValue;
+    bool _started = false;
+};
+
+using JsonCursor = BasicJsonCursor<const Json>;
+using MutableJsonCursor = BasicJsonCursor<Json>;
+
+/**
+ * 先序 / 后序遍历的范围，元素为当前位置的游标：
+ *
+ *   for (auto& cur : preOrder(json)) use(cur.path(), cur.value());
+ *
+ * 先序产生 kValue 和 kEnter，后序产生 kValue 和 kLeave；
+ * mutablePostOrder() 使用 MutableJsonCursor，每个值在其子节点之后访问，可以直接修改
+ */
+template <class J>
+class JsonWalk {
+public:
+    class iterator {
+    public:
+        iterator() = default;
+        iterator(J& root, WalkKind skipped)
+            : _cur(std::in_place, root), _skipped(skipped), _done(false) {
+            advance();
+        }
+
+        const BasicJsonCursor<J>& operator*() const noexcept { return *_cur; }
+        const BasicJsonCursor<J>* operator->() const noexcept { return &*_cur; }
+        iterator& operator++() {
+            advance();
+            return *this;
+        }
+        bool operator==(const iterator& rhs) const noexcept { return _done == rhs._done; }
+        bool operator!=(const iterator& rhs) const noexcept { return _done != rhs._done; }
+
+    private:
+        void advance() {
+            do {
+                if (!_cur->next()) {
+                    _done = true;
+                    return;
+                }
+            } while (_cur->kind() == _skipped);
+        }
+
+        std::optional<BasicJsonCursor<J>> _cur;
+        WalkKind _skipped = WalkKind::kValue;
+        bool _done = true;
+    };
+
+    JsonWalk(J& root, WalkKind skipped) : _root(root), _skipped(skipped) {}
+
+    iterator begin() const { return iterator(_root, _skipped); }
+    iterator end() const { return iterator(); }
+
+private:
+    J& _root;
+    WalkKind _skipped;
+};
+
+inline JsonWalk<const Json> preOrder(const Json& root) {
+    return JsonWalk<const Json>(root, WalkKind::kLeave);
+}
+inline JsonWalk<const Json> postOrder(const Json& root) {
+    return JsonWalk<const Json>(root, WalkKind::kEnter);
+}
+inline JsonWalk<Json> mutablePostOrder(Json& root) {
+    return JsonWalk<Json>(root, WalkKind::kEnter);
+}
+
+};                  // ------------------- namespace zzjson
+
+#endif  // JSON_WALK_H__
@@ -1,5 +1,9 @@
 #include "parse.h"
+#include "json_simd.h"
+#include "json_val.h"
+#include <algorithm>  // find_if
 #include <cassert>    // assert
+#include <cerrno>     // errno
 #include <cmath>      // Huge_Val
 #include <cstdlib>    // strtod
 #include <cstring>    // strncmp
@@ -64,13 +68,27 @@ std::string Parser::EncoddeUTF8(unsigned u) noexcept {
 /**
  * 转义序列的解析
  */
-std::string Parser::ParserRowString() {
-    std::string str;
+template <class String>
+void Parser::ParserRowString(String& str) {
+    str.clear();
+    size_t capacity = str.capacity();
+    bool escaped = false;
     while (true) {
+        // 不需要转义处理的字节整段拷贝，只有非 ASCII 的片段才做 UTF-8 校验
+        bool nonAscii = false;
+        size_t n = simd::ScanString(_cur + 1, _end, nonAscii);
+        if (n != 0) {
+            if (nonAscii && _opts.validateUtf8 &&
+                !simd::ValidUTF8(_cur + 1, n))
+                error("INVALID UTF8");
+            str.append(_cur + 1, n);
+            _cur += n;
+        }
         switch (*++_cur) {
             case '\"':
                 _start = ++_cur;
-                return str;
+                StatsString(str.size(), str.capacity() != capacity, escaped);
+                return;
             case '\0':
                 error("MISS QUOTATION MARK");
             default:
@@ -79,6 +97,7 @@ std::string Parser::ParserRowString() {
                 str.push_back(*_cur);
                 break;
             case '\\':
+                escaped = true;
                 switch (*++_cur) {
                     case '\"':
                         str.push_back('\"');
@@ -120,6 +139,10 @@ std::string Parser::ParserRowString() {
                                 error("INVALID UNICODE SURROGATE");
                             u1 = (((u1 - 0xd800) << 10) | (u2 - 0xdc00)) +
                                  0x10000;
+                        } else if (_opts.validateUtf8 && u1 >= 0xdc00 &&
+                                   u1 <= 0xdfff) {
+                            // 单独的低代理项无法编码为合法的 UTF-8
+                            error("INVALID UNICODE SURROGATE");
                         }
                         str += EncoddeUTF8(u1);
                     } break;
@@ -135,10 +158,14 @@ std::string Parser::ParserRowString() {
  * throw 错误的位置
  */
 void Parser::error(const std::string& msg) const {
-    throw JsonExcept(msg + ": " + _start);
+    // 输入不一定以 '\0' 结尾, 只截取到 _end 或第一个 '\0'
+    auto nul = static_cast<const char*>(memchr(_start, '\0', _end - _start));
+    throw JsonExcept(msg + ": " + std::string(_start, nul ? nul : _end));
 }
 
 Json Parser::ParserValue() {
+    StatsValue(*_cur);
+    StatsAlloc();   // 节点
     switch (*_cur) {
         case 'n':
             return ParserLiteral("null");
@@ -170,11 +197,11 @@ Json Parser::ParserLiteral(const std::string& literal) {
     _start = _cur;
     switch (literal[0]) {
         case 't':
-            return Json(true);
+            return Json(true, _alloc);
         case 'f':
-            return Json(false);
+            return Json(false, _alloc);
         default:
-            return Json(nullptr);
+            return Json(nullptr, _alloc);
     }
 }
 
@@ -184,6 +211,13 @@ Json Parser::ParserLiteral(const std::string& literal) {
  * https://github.com/miloyip/json-tutorial/blob/master/tutorial02/images/number.png
  */
 Json Parser::ParserNumber() {
+    if (!_opts.lazyNumbers) return Json(ParserDouble(), _alloc);
+    const char* begin = _start;
+    SkipNumber();
+    return Json::LazyNumber(std::string_view(begin, _cur - begin), _alloc);
+}
+
+double Parser::ParserDouble() {
     // 负号直接跳过.
     if (*_cur == '-') {
         ++_cur;
@@ -232,64 +266,345 @@ Json Parser::ParserNumber() {
         error("NUMBER TOO BIG");
     }
     _start = _cur;
-    return Json(val);
+    return val;
 }
 
-Json Parser::ParserString() { return Json(ParserRowString()); }
+Json Parser::ParserString() {
+    Json::_string str(_alloc);
+    ParserRowString(str);
+    return Json(std::move(str), _alloc);
+}
 
 /**
  * 解析数组
  */
 Json Parser::ParserArray() {
-    Json::_array arr;
+    DepthGuard guard(*this);
+    Json::_array arr(_alloc);
     ++_cur;  // 跳过 '['
     ParserSpace();
     if (*_cur == ']') {
         _start = ++_cur;
-        return Json(arr);
+        return Json(std::move(arr), _alloc);
+    }
+    if (_opts.packArrays) {
+        // 先按紧凑数组读取，遇到其他类型的元素时把已读取的部分转换为 Json
+        if (*_cur == '-' || ISDIGIT(*_cur)) {
+            std::pmr::vector<double> numbers(_alloc);
+            if (ParserPackedNumbers(numbers)) {
+                StatsAlloc();   // PackedArray
+                return Json::PackNumbers(std::move(numbers));
+            }
+            arr.assign(numbers.begin(), numbers.end());
+            StatsAlloc(numbers.size() + 1);
+        } else if (*_cur == 't' || *_cur == 'f') {
+            std::pmr::vector<uint8_t> bools(_alloc);
+            if (ParserPackedBools(bools)) {
+                StatsAlloc();   // PackedArray
+                return Json::PackBools(std::move(bools));
+            }
+            for (uint8_t val : bools) {
+                size_t capacity = arr.capacity();
+                arr.emplace_back(val != 0);
+                StatsGrow(capacity, arr.capacity());
+            }
+            StatsAlloc(bools.size());
+        }
     }
     while (true) {
         ParserSpace();
+        size_t capacity = arr.capacity();
         arr.push_back(ParserValue());  // recursive
+        StatsGrow(capacity, arr.capacity());
         ParserSpace();
         if (*_cur == ',')
             ++_cur;
         else if (*_cur == ']') {
             _start = ++_cur;
-            return Json(arr);
+            return Json(std::move(arr), _alloc);
         } else
             error("MISS COMMA OR SQUARE BRACKET");
     }
 }
 
+/**
+ * 紧凑数组：连续读取同类型的元素
+ * 数组结束时返回 true；遇到其他类型的元素时返回 false，_cur 停在该元素上
+ */
+bool Parser::ParserPackedNumbers(std::pmr::vector<double>& numbers) {
+    while (true) {
+        StatsValue('0');
+        size_t capacity = numbers.capacity();
+        numbers.push_back(ParserDouble());
+        StatsGrow(capacity, numbers.capacity());
+        ParserSpace();
+        if (*_cur == ',') {
+            ++_cur;
+            ParserSpace();
+            if (*_cur != '-' && !ISDIGIT(*_cur)) return false;
+        } else if (*_cur == ']') {
+            _start = ++_cur;
+            return true;
+        } else {
+            error("MISS COMMA OR SQUARE BRACKET");
+        }
+    }
+}
+
+bool Parser::ParserPackedBools(std::pmr::vector<uint8_t>& bools) {
+    while (true) {
+        StatsValue('t');
+        size_t capacity = bools.capacity();
+        if (strncmp(_cur, "true", 4) == 0) {
+            bools.push_back(1);
+            _cur += 4;
+        } else if (strncmp(_cur, "false", 5) == 0) {
+            bools.push_back(0);
+            _cur += 5;
+        } else {
+            error("INVALID VALUE");
+        }
+        StatsGrow(capacity, bools.capacity());
+        _start = _cur;
+        ParserSpace();
+        if (*_cur == ',') {
+            ++_cur;
+            ParserSpace();
+            if (*_cur != 't' && *_cur != 'f') return false;
+        } else if (*_cur == ']') {
+            _start = ++_cur;
+            return true;
+        } else {
+            error("MISS COMMA OR SQUARE BRACKET");
+        }
+    }
+}
+
 Json Parser::ParserObj() {
-    Json::_obj obj;
+    DepthGuard guard(*this);
+    Json::_obj obj(_alloc);
     ++_cur;
     ParserSpace();
     if (*_cur == '}') {
         _start = ++_cur;
-        return Json(obj);
+        return Json(std::move(obj), _alloc);
     }
     while (true) {
         ParserSpace();
         if (*_cur != '"') error("MISS KEY");
-        std::string key = ParserRowString();
+        Json::_string key(_alloc);
+        ParserRowString(key);
+        StatsKey();
         ParserSpace();
         if (*_cur++ != ':') error("MISS COLON");
         ParserSpace();
         Json val = ParserValue();
-        obj.insert({key, val});
+        size_t buckets = obj.bucket_count();
+        obj.emplace(std::move(key), std::move(val));
+        StatsGrow(buckets, obj.bucket_count());
+        StatsAlloc();   // 成员节点
         ParserSpace();
         if (*_cur == ',')
             ++_cur;
         else if (*_cur == '}') {
             _start = ++_cur;
-            return Json(obj);
+            return Json(std::move(obj), _alloc);
         } else
             error("MISS COMMA OR CURLY BRACKET");
     }
 }
 
+/**
+ * 原地解析：
+ * 标量和字符串直接覆盖 (字符串保留容量)；数组逐个覆盖原有的元素，
+ * 多出的元素放回 pool；对象中 key 相同的成员原地复用，
+ * 新的 key 优先使用 pool 中的成员节点.
+ * 结构与上一次相同时整个过程不分配内存.
+ */
+namespace {
+
+Json& NextElement(Json::_array& arr, size_t i, ParsePool& pool) {
+    if (i < arr.size()) return arr[i];
+    if (!pool.values.empty()) {
+        arr.push_back(std::move(pool.values.back()));
+        pool.values.pop_back();
+    } else {
+        arr.emplace_back();
+    }
+    return arr.back();
+}
+
+void TrimElements(Json::_array& arr, size_t size, ParsePool& pool) {
+    while (arr.size() > size) {
+        pool.values.push_back(std::move(arr.back()));
+        arr.pop_back();
+    }
+}
+
+};  // namespace
+
+void Parser::ParserValueInto(Json& out, ParsePool& pool, size_t depth) {
+    StatsValue(*_cur);
+    if (!out._jsonVal) StatsAlloc();    // Reuse() 新建节点
+    switch (*_cur) {
+        case 'n':
+        case 't':
+        case 'f': {
+            const char* literal = *_cur == 'n' ? "null" : *_cur == 't' ? "true" : "false";
+            size_t len = strlen(literal);
+            if (strncmp(_cur, literal, len) != 0) error("INVALID VALUE");
+            _cur += len;
+            _start = _cur;
+            if (*literal == 'n')
+                out.Reuse(_alloc).assign(nullptr);
+            else
+                out.Reuse(_alloc).assign(*literal == 't');
+            break;
+        }
+        case '\"':
+            ParserRowString(out.Reuse(_alloc).reuseString());
+            break;
+        case '[':
+            ParserArrayInto(out, pool, depth);
+            break;
+        case '{':
+            ParserObjInto(out, pool, depth);
+            break;
+        case '\0':
+            error("EXPECT VALUE");
+        default:
+            if (_opts.lazyNumbers) {
+                const char* begin = _start;
+                SkipNumber();
+                out.Reuse(_alloc).assignRaw(std::string_view(begin, _cur - begin));
+            } else {
+                out.Reuse(_alloc).assign(ParserDouble());
+            }
+            break;
+    }
+}
+
+void Parser::ParserArrayInto(Json& out, ParsePool& pool, size_t depth) {
+    StatsDepth(depth + 1);
+    JsonValue& val = out.Reuse(_alloc);
+    ++_cur;  // 跳过 '['
+    ParserSpace();
+    if (*_cur == ']') {
+        _start = ++_cur;
+        TrimElements(val.reuseArray(), 0, pool);
+        return;
+    }
+    size_t n = 0;
+    if (_opts.packArrays) {
+        // 已经是同类的紧凑数组时直接读入其存储，否则先读入 pool 中
+        if (*_cur == '-' || ISDIGIT(*_cur)) {
+            std::pmr::vector<double>* numbers = val.reusePackedNumbers();
+            if (!numbers) (numbers = &pool.numbers)->clear();
+            if (ParserPackedNumbers(*numbers)) {
+                if (numbers == &pool.numbers) {
+                    out = Json::PackNumbers({numbers->begin(), numbers->end(), _alloc});
+                    StatsAlloc(3);  // 节点、PackedArray 和存储
+                }
+                return;
+            }
+            if (numbers != &pool.numbers)
+                pool.numbers.assign(numbers->begin(), numbers->end());
+            Json::_array& arr = val.reuseArray();
+            for (double num : pool.numbers)
+                NextElement(arr, n++, pool).Reuse(_alloc).assign(num);
+        } else if (*_cur == 't' || *_cur == 'f') {
+            std::pmr::vector<uint8_t>* bools = val.reusePackedBools();
+            if (!bools) (bools = &pool.bools)->clear();
+            if (ParserPackedBools(*bools)) {
+                if (bools == &pool.bools) {
+                    out = Json::PackBools({bools->begin(), bools->end(), _alloc});
+                    StatsAlloc(3);
+                }
+                return;
+            }
+            if (bools != &pool.bools)
+                pool.bools.assign(bools->begin(), bools->end());
+            Json::_array& arr = val.reuseArray();
+            for (uint8_t b : pool.bools)
+                NextElement(arr, n++, pool).Reuse(_alloc).assign(b != 0);
+        }
+    }
+    Json::_array& arr = val.reuseArray();
+    while (true) {
+        ParserSpace();
+        size_t capacity = arr.capacity();
+        Json& elem = NextElement(arr, n++, pool);
+        StatsGrow(capacity, arr.capacity());
+        ParserValueInto(elem, pool, depth + 1);
+        ParserSpace();
+        if (*_cur == ',')
+            ++_cur;
+        else if (*_cur == ']') {
+            _start = ++_cur;
+            break;
+        } else
+            error("MISS COMMA OR SQUARE BRACKET");
+    }
+    TrimElements(arr, n, pool);
+}
+
+/**
+ * 解析过的成员先取出放在 pool.levels[depth] 中，结束时剩下的 (不再出现的) 成员
+ * 放回 pool，再把解析过的成员按顺序放回 obj；重复的 key 只保留第一个.
+ */
+void Parser::ParserObjInto(Json& out, ParsePool& pool, size_t depth) {
+    StatsDepth(depth + 1);
+    Json::_obj& obj = out.Reuse(_alloc).reuseObj();
+    while (pool.levels.size() <= depth) pool.levels.emplace_back(pool.resource());
+    pool.levels[depth].clear();
+    ++_cur;
+    ParserSpace();
+    if (*_cur != '}') {
+        while (true) {
+            ParserSpace();
+            if (*_cur != '"') error("MISS KEY");
+            ParserRowString(pool.key);
+            StatsKey();
+            Json::_obj::node_type member;
+            auto it = obj.find(pool.key);
+            if (it != obj.end()) {
+                member = obj.extract(it);
+            } else if (!pool.members.empty() &&
+                       pool.members.back().get_allocator() == obj.get_allocator()) {
+                member = std::move(pool.members.back());
+                pool.members.pop_back();
+                size_t capacity = member.key().capacity();
+                member.key() = pool.key;
+                StatsGrow(capacity, member.key().capacity());
+            } else {
+                member = obj.extract(obj.emplace(pool.key, nullptr).first);
+                StatsAlloc(pool.key.size() < Json::_string().capacity() ? 2 : 3);
+            }
+            ParserSpace();
+            if (*_cur++ != ':') error("MISS COLON");
+            ParserSpace();
+            ParserValueInto(member.mapped(), pool, depth + 1);
+            pool.levels[depth].push_back(std::move(member));   // 递归可能使 levels 扩容
+            ParserSpace();
+            if (*_cur == ',')
+                ++_cur;
+            else if (*_cur == '}') {
+                break;
+            } else
+                error("MISS COMMA OR CURLY BRACKET");
+        }
+    }
+    _start = ++_cur;
+    while (!obj.empty()) pool.members.push_back(obj.extract(obj.begin()));
+    for (auto& member : pool.levels[depth]) {
+        size_t buckets = obj.bucket_count();
+        auto res = obj.insert(std::move(member));
+        StatsGrow(buckets, obj.bucket_count());
+        if (!res.inserted) pool.members.push_back(std::move(res.node));
+    }
+    pool.levels[depth].clear();
+}
+
 /**
  * 公共调用的接口
  */
@@ -303,4 +618,385 @@ Json Parser::parse() {
     return json;
 }
 
-};              // ------------------- namespace zzjson
\ No newline at end of file
+void Parser::parseInto(Json& out, ParsePool& pool) {
+    ParserSpace();
+    ParserValueInto(out, pool, 0);
+    ParserSpace();
+    if (*_cur) error("ROOT NOT SINGULAR");
+}
+
+/**
+ * 只校验语法：以下 Skip* 与上面的 Parser* 一一对应，
+ * 报错的类型和位置 (_start) 与 parse() 保持一致.
+ */
+void Parser::SkipSpace() noexcept {
+    while (_cur < _end && (*_cur == ' ' || *_cur == '\t' || *_cur == '\r' ||
+                           *_cur == '\n')) {
+        ++_cur;
+    }
+    _start = _cur;
+}
+
+unsigned Parser::Skip4Hex() {
+    unsigned u = 0;
+    for (int i = 0; i != 4; ++i) {
+        auto ch = static_cast<unsigned>(toupper(Next()));
+        u <<= 4;
+        if (ch >= '0' && ch <= '9') {
+            u |= (ch - '0');
+        } else if (ch >= 'A' && ch <= 'F') {
+            u |= ch - 'A' + 10;
+        } else {
+            error("INVALID UNICODE HEX");
+        }
+    }
+    return u;
+}
+
+void Parser::SkipString() {
+    while (true) {
+        bool nonAscii = false;
+        size_t n = simd::ScanString(_cur + 1, _end, nonAscii);
+        if (nonAscii && _opts.validateUtf8 && !simd::ValidUTF8(_cur + 1, n))
+            error("INVALID UTF8");
+        _cur += n;
+        switch (Next()) {
+            case '\"':
+                _start = ++_cur;
+                return;
+            case '\0':
+                error("MISS QUOTATION MARK");
+            default:
+                if (static_cast<unsigned char>(*_cur) < 0x20)
+                    error("INVALID STRING CHAR");
+                break;
+            case '\\':
+                switch (Next()) {
+                    case '\"':
+                    case '\\':
+                    case '/':
+                    case 'b':
+                    case 'f':
+                    case 'n':
+                    case 't':
+                    case 'r':
+                        break;
+                    case 'u': {
+                        unsigned u1 = Skip4Hex();
+                        if (u1 >= 0xd800 && u1 <= 0xdbff) {  // high surrogate
+                            if (Next() != '\\')
+                                error("INVALID UNICODE SURROGATE");
+                            if (Next() != 'u')
+                                error("INVALID UNICODE SURROGATE");
+                            unsigned u2 = Skip4Hex();  // low surrogate
+                            if (u2 < 0xdc00 || u2 > 0xdfff)
+                                error("INVALID UNICODE SURROGATE");
+                        } else if (_opts.validateUtf8 && u1 >= 0xdc00 &&
+                                   u1 <= 0xdfff) {
+                            error("INVALID UNICODE SURROGATE");
+                        }
+                    } break;
+                    default:
+                        error("INVALID STRING ESCAPE");
+                }
+                break;
+        }
+    }
+}
+
+void Parser::SkipValue() {
+    switch (Peek()) {
+        case 'n':
+            return SkipLiteral("null", 4);
+        case 't':
+            return SkipLiteral("true", 4);
+        case 'f':
+            return SkipLiteral("false", 5);
+        case '\"':
+            return SkipString();
+        case '[':
+            return SkipArray();
+        case '{':
+            return SkipObj();
+        case '\0':
+            error("EXPECT VALUE");
+        default:
+            return SkipNumber();
+    }
+}
+
+void Parser::SkipLiteral(const char* literal, size_t len) {
+    if (static_cast<size_t>(_end - _cur) < len ||
+        memcmp(_cur, literal, len) != 0)
+        error("INVALID VALUE");
+    _cur += len;
+    _start = _cur;
+}
+
+/**
+ * 不调用 strtod，而是根据首位有效数字的数量级判断是否溢出：
+ * 数量级 < 308 一定不溢出，> 308 一定溢出，
+ * 只有恰好等于 308 时才需要 strtod 精确判断.
+ */
+void Parser::SkipNumber() {
+    if (Peek() == '-') {
+        ++_cur;
+    }
+
+    long long mag = 0;      // 首位有效数字的十进制数量级
+    bool nonzero = false;   // 是否出现过非零数字
+    if (Peek() == '0')
+        ++_cur;
+    else {
+        if (!ISDIGIT1TO9(Peek())) error("INVALID VALUE");
+        const char* first = _cur;
+        while (ISDIGIT(Next()))
+            ;
+        nonzero = true;
+        mag = _cur - first - 1;
+    }
+
+    if (Peek() == '.') {
+        if (!ISDIGIT(Next())) error("INVALID VALUE");
+        long long frac = 0;
+        do {
+            ++frac;
+            if (!nonzero && *_cur != '0') {
+                nonzero = true;
+                mag = -frac;
+            }
+        } while (ISDIGIT(Next()));
+    }
+
+    long long exp = 0;
+    if (toupper(Peek()) == 'E') {
+        ++_cur;
+        bool neg = false;
+        if (Peek() == '-' || Peek() == '+') {
+            neg = (Peek() == '-');
+            ++_cur;
+        }
+        if (!ISDIGIT(Peek())) {
+            error("INVALID VALUE");
+        }
+        do {
+            if (exp < 1000000000000LL) exp = exp * 10 + (*_cur - '0');
+        } while (ISDIGIT(Next()));
+        if (neg) exp = -exp;
+    }
+
+    if (nonzero && mag + exp >= 308) {
+        if (mag + exp > 308) error("NUMBER TOO BIG");
+        // 临界情况：数字很少会这么长，用栈上的缓冲区避免分配
+        char buf[64];
+        size_t len = _cur - _start;
+        std::string big;
+        const char* text = buf;
+        if (len < sizeof(buf)) {
+            memcpy(buf, _start, len);
+            buf[len] = '\0';
+        } else {
+            big.assign(_start, _cur);
+            text = big.c_str();
+        }
+        if (fabs(strtod(text, nullptr)) == HUGE_VAL) error("NUMBER TOO BIG");
+    }
+    _start = _cur;
+}
+
+void Parser::SkipArray() {
+    ++_cur;  // 跳过 '['
+    SkipSpace();
+    if (Peek() == ']') {
+        _start = ++_cur;
+        return;
+    }
+    while (true) {
+        SkipSpace();
+        SkipValue();
+        SkipSpace();
+        if (Peek() == ',')
+            ++_cur;
+        else if (Peek() == ']') {
+            _start = ++_cur;
+            return;
+        } else
+            error("MISS COMMA OR SQUARE BRACKET");
+    }
+}
+
+void Parser::SkipObj() {
+    ++_cur;
+    SkipSpace();
+    if (Peek() == '}') {
+        _start = ++_cur;
+        return;
+    }
+    while (true) {
+        SkipSpace();
+        if (Peek() != '"') error("MISS KEY");
+        SkipString();
+        SkipSpace();
+        if (Peek() != ':') error("MISS COLON");
+        ++_cur;
+        SkipSpace();
+        SkipValue();
+        SkipSpace();
+        if (Peek() == ',')
+            ++_cur;
+        else if (Peek() == '}') {
+            _start = ++_cur;
+            return;
+        } else
+            error("MISS COMMA OR CURLY BRACKET");
+    }
+}
+
+/**
+ * 只校验、不构造的接口
+ */
+void Parser::validate() {
+    SkipSpace();
+    SkipValue();
+    SkipSpace();
+    if (Peek())
+        error("ROOT NOT SINGULAR");
+}
+
+/**
+ * 逐个 token 读取的接口
+ */
+bool Parser::consume(char ch) noexcept {
+    ParserSpace();
+    if (*_cur != ch) return false;
+    _start = ++_cur;
+    return true;
+}
+
+void Parser::expect(char ch, const char* msg) {
+    if (!consume(ch)) error(msg);
+}
+
+bool Parser::readBool() {
+    switch (peek()) {
+        case 't':
+            SkipLiteral("true", 4);
+            return true;
+        case 'f':
+            SkipLiteral("false", 5);
+            return false;
+        default:
+            error("TYPE MISMATCH");
+    }
+}
+
+double Parser::readNumber() {
+    char ch = peek();
+    if (ch != '-' && !ISDIGIT(ch)) error("TYPE MISMATCH");
+    return ParserDouble();
+}
+
+/**
+ * 不含小数和指数部分的整数用 strtoll 读取，保证 int64 范围内精确
+ * 成功时返回 nullptr，否则返回错误的类型；两种情况下数字都已被读取
+ */
+const char* Parser::ParserInteger(long long& res) {
+    const char* begin = _cur;
+    double val = ParserDouble();
+    if (std::find_if(begin, _cur, [](char c) {
+            return c == '.' || c == 'e' || c == 'E';
+        }) == _cur) {
+        errno = 0;
+        res = strtoll(begin, nullptr, 10);
+        return errno == ERANGE ? "NUMBER TOO BIG" : nullptr;
+    }
+    if (val != std::trunc(val)) return "TYPE MISMATCH";
+    if (fabs(val) >= 9223372036854775808.0) return "NUMBER TOO BIG";
+    res = static_cast<long long>(val);
+    return nullptr;
+}
+
+/**
+ * 与 ParserInteger 相同，范围为 uint64：负数 (-0 除外) 报 NUMBER TOO BIG
+ */
+const char* Parser::ParserUnsigned(unsigned long long& res) {
+    const char* begin = _cur;
+    double val = ParserDouble();
+    if (std::find_if(begin, _cur, [](char c) {
+            return c == '.' || c == 'e' || c == 'E';
+        }) == _cur) {
+        if (*begin == '-') {
+            res = 0;
+            return val == 0 ? nullptr : "NUMBER TOO BIG";
+        }
+        errno = 0;
+        res = strtoull(begin, nullptr, 10);
+        return errno == ERANGE ? "NUMBER TOO BIG" : nullptr;
+    }
+    if (val != std::trunc(val)) return "TYPE MISMATCH";
+    if (val < 0 || val >= 18446744073709551616.0) return "NUMBER TOO BIG";
+    res = static_cast<unsigned long long>(val);
+    return nullptr;
+}
+
+long long Parser::readInteger() {
+    char ch = peek();
+    if (ch != '-' && !ISDIGIT(ch)) error("TYPE MISMATCH");
+    long long res;
+    if (const char* msg = ParserInteger(res)) error(msg);
+    return res;
+}
+
+unsigned long long Parser::readUnsigned() {
+    char ch = peek();
+    if (ch != '-' && !ISDIGIT(ch)) error("TYPE MISMATCH");
+    unsigned long long res;
+    if (const char* msg = ParserUnsigned(res)) error(msg);
+    return res;
+}
+
+bool Parser::tryReadInteger(long long& val) {
+    char ch = peek();
+    if (ch != '-' && !ISDIGIT(ch)) error("TYPE MISMATCH");
+    return ParserInteger(val) == nullptr;
+}
+
+void Parser::readString(std::string& str) {
+    if (peek() != '"') error("TYPE MISMATCH");
+    ParserRowString(str);
+}
+
+/**
+ * 不含转义的 key 直接返回指向输入的 string_view，不做拷贝
+ */
+std::string_view Parser::readKey(std::string& scratch) {
+    if (peek() != '"') error("MISS KEY");
+    bool nonAscii = false;
+    size_t n = simd::ScanString(_cur + 1, _end, nonAscii);
+    if (_cur[n + 1] == '"' &&
+        !(nonAscii && _opts.validateUtf8 && !simd::ValidUTF8(_cur + 1, n))) {
+        std::string_view key(_cur + 1, n);
+        _cur += n + 2;
+        _start = _cur;
+        return key;
+    }
+    ParserRowString(scratch);
+    return scratch;
+}
+
+Json Parser::readValue() {
+    ParserSpace();
+    return ParserValue();
+}
+
+void Parser::skipValue() {
+    ParserSpace();
+    SkipValue();
+}
+
+void Parser::finish() {
+    ParserSpace();
+    if (*_cur) error("ROOT NOT SINGULAR");
+}
+
+};              // ------------------- namespace zzjson
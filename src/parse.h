@@ -3,6 +3,9 @@
 
 #pragma once
 
+#include <cstring>
+#include <string_view>
+#include <vector>
 #include "json.h"
 #include "json_except.h"
 
@@ -16,15 +19,89 @@ constexpr bool ISDIGIT(char ch) {
     return ch >= '0' && ch <= '9';
 }
 
+/**
+ * 从 memory_resource 分配的 allocator，但不做 uses-allocator 构造：
+ * 用于保存 node_type 这类自带 allocator、不能放进 std::pmr 容器的元素
+ */
+template <class T>
+struct ResourceAllocator {
+    using value_type = T;
+
+    ResourceAllocator(std::pmr::memory_resource* resource) noexcept : resource(resource) {}
+    template <class U>
+    ResourceAllocator(const ResourceAllocator<U>& rhs) noexcept : resource(rhs.resource) {}
+
+    T* allocate(size_t n) {
+        return static_cast<T*>(resource->allocate(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* ptr, size_t n) noexcept {
+        resource->deallocate(ptr, n * sizeof(T), alignof(T));
+    }
+
+    template <class U>
+    bool operator==(const ResourceAllocator<U>& rhs) const noexcept {
+        return resource == rhs.resource;
+    }
+    template <class U>
+    bool operator!=(const ResourceAllocator<U>& rhs) const noexcept {
+        return resource != rhs.resource;
+    }
+
+    std::pmr::memory_resource* resource;
+};
+
+/**
+ * ParseContext 在多次解析之间保留的节点和缓冲区，全部分配在文档的 resource 中
+ */
+struct ParsePool {
+    using Members = std::vector<Json::_obj::node_type,
+                                ResourceAllocator<Json::_obj::node_type>>;
+
+    explicit ParsePool(std::pmr::memory_resource* resource =
+                           std::pmr::get_default_resource())
+        : values(resource), members(resource), levels(resource), key(resource),
+          numbers(resource), bools(resource) {}
+
+    std::pmr::memory_resource* resource() const noexcept { return key.get_allocator().resource(); }
+
+    std::pmr::vector<Json> values;                              // 数组变短时多出的元素
+    Members members;                                            // 对象中不再出现的成员
+    std::vector<Members, ResourceAllocator<Members>> levels;    // 每一层正在解析的对象成员
+    Json::_string key;
+    std::pmr::vector<double> numbers;
+    std::pmr::vector<uint8_t> bools;
+};
+
 class Parser {
 public:
     /**
      * 构造函数
      */
-    explicit Parser(const char* cstr) noexcept : _start(cstr), _cur(cstr) {}
+    explicit Parser(const char* cstr,
+                    const ParseOptions& opts = ParseOptions(),
+                    std::pmr::memory_resource* resource =
+                        std::pmr::get_default_resource()) noexcept
+                         : _start(cstr), _cur(cstr), _end(cstr + strlen(cstr)),
+                           _opts(opts), _alloc(resource) {}
 
-    explicit Parser(const std::string& content) noexcept
-                         : _start(content.c_str()), _cur(content.c_str()) {}
+    /**
+     * resource -> 解析得到的 Json 所使用的 memory_resource
+     */
+    explicit Parser(const std::string& content,
+                    const ParseOptions& opts = ParseOptions(),
+                    std::pmr::memory_resource* resource =
+                        std::pmr::get_default_resource()) noexcept
+                         : _start(content.c_str()), _cur(content.c_str()),
+                           _end(content.c_str() + content.size()), _opts(opts),
+                           _alloc(resource) {}
+
+    /**
+     * 不要求以 '\0' 结尾的输入，用于 validate()
+     */
+    Parser(const char* data, size_t len,
+           const ParseOptions& opts = ParseOptions()) noexcept
+                         : _start(data), _cur(data), _end(data + len),
+                           _opts(opts), _alloc(std::pmr::get_default_resource()) {}
 
 public:
     /**
@@ -40,12 +117,16 @@ private:
     void ParserSpace() noexcept;
     unsigned Parser4Hex();
     std::string EncoddeUTF8(unsigned u) noexcept;
-    std::string ParserRowString();
+    template <class String>
+    void ParserRowString(String& str);          // std::string 或 Json::_string
+    double ParserDouble();
+    const char* ParserInteger(long long& res);
+    const char* ParserUnsigned(unsigned long long& res);
 
     /**
      * throw 错误的位置
      */
-    void error(const std::string& msg) const;
+    [[noreturn]] void error(const std::string& msg) const;
 
 private:
     /**
@@ -56,13 +137,96 @@ private:
     Json ParserNumber();
     Json ParserString();
     Json ParserArray();
+    bool ParserPackedNumbers(std::pmr::vector<double>& numbers);
+    bool ParserPackedBools(std::pmr::vector<uint8_t>& bools);
     Json ParserObj();
 
+    /**
+     * 原地解析 (ParseContext)：覆盖 out 中原有的值，尽量复用其中的节点和容量
+     */
+    void ParserValueInto(Json& out, ParsePool& pool, size_t depth);
+    void ParserArrayInto(Json& out, ParsePool& pool, size_t depth);
+    void ParserObjInto(Json& out, ParsePool& pool, size_t depth);
+
+private:
+    /**
+     * 只校验语法的处理函数
+     * 与 Parser* 系列的检查和报错完全一致，但不构造 Json、不转换数字，
+     * 且所有读取都不会越过 _end.
+     */
+    char Peek() const noexcept { return _cur < _end ? *_cur : '\0'; }
+    char Next() noexcept {
+        if (_cur < _end) ++_cur;
+        return Peek();
+    }
+
+    void SkipSpace() noexcept;
+    unsigned Skip4Hex();
+    void SkipString();
+    void SkipValue();
+    void SkipLiteral(const char* literal, size_t len);
+    void SkipNumber();
+    void SkipArray();
+    void SkipObj();
+
 public:
     /**
      * 公共调用的接口
      */
     Json parse();
+    void parseInto(Json& out, ParsePool& pool);
+    void validate();
+
+public:
+    /**
+     * 逐个 token 读取的接口，供 json_bind.h 直接解析到 C++ 类型
+     * 除 fail() 外，每个接口都会先跳过空白；类型不符时报 TYPE MISMATCH
+     */
+    char peek() noexcept {
+        ParserSpace();
+        return *_cur;
+    }
+    bool consume(char ch) noexcept;
+    void expect(char ch, const char* msg);
+    bool readBool();
+    double readNumber();
+    long long readInteger();
+    unsigned long long readUnsigned();
+    bool tryReadInteger(long long& val);    // 不是 int64 范围内的整数时返回 false
+    void readString(std::string& str);
+    std::string_view readKey(std::string& scratch);
+    Json readValue();
+    void skipValue();
+    void finish();
+    [[noreturn]] void fail(const std::string& msg) const { error(msg); }
+
+private:
+    /**
+     * 统计 (ParseOptions::stats)
+     * 定义 ZZJSON_DISABLE_STATS 时都是空函数，连同传给它们的参数一起被编译器消除
+     * StatsValue()  -> 按值的首字符计数
+     * StatsGrow()   -> 容量 (或 bucket 数) 变化时计一次分配
+     * StatsString() -> 字符串或 key 读取完成
+     */
+    void StatsValue(char first) noexcept;
+    void StatsKey() noexcept;
+    void StatsAlloc(size_t count = 1) noexcept;
+    void StatsGrow(size_t before, size_t after) noexcept { if (before != after) StatsAlloc(); }
+    void StatsDepth(size_t depth) noexcept;
+    void StatsString(size_t size, bool grew, bool escaped) noexcept;
+
+    /**
+     * 数组 / 对象的嵌套层数，只用于统计 maxDepth
+     */
+    struct DepthGuard {
+#ifndef ZZJSON_DISABLE_STATS
+        explicit DepthGuard(Parser& p) noexcept : _p(p) { _p.StatsDepth(++_p._depth); }
+        ~DepthGuard() { --_p._depth; }
+        Parser& _p;
+#else
+        explicit DepthGuard(Parser&) noexcept {}
+#endif
+    };
 
 private:
     /**
@@ -70,8 +234,70 @@ private:
      */
     const char* _start;
     const char* _cur;
+    const char* _end;
+
+    ParseOptions _opts;
+    Json::allocator_type _alloc;
+#ifndef ZZJSON_DISABLE_STATS
+    ParseStats* _stats = _opts.stats;
+#endif
+    size_t _depth = 0;
 };
 
+#ifndef ZZJSON_DISABLE_STATS
+inline void Parser::StatsValue(char first) noexcept {
+    if (!_stats) return;
+    switch (first) {
+        case 'n':
+            ++_stats->nulls;
+            break;
+        case 't':
+        case 'f':
+            ++_stats->bools;
+            break;
+        case '\"':
+            ++_stats->strings;
+            break;
+        case '[':
+            ++_stats->arrays;
+            break;
+        case '{':
+            ++_stats->objects;
+            break;
+        case '\0':     // EXPECT VALUE
+            break;
+        default:
+            ++_stats->numbers;
+            break;
+    }
+}
+
+inline void Parser::StatsKey() noexcept {
+    if (_stats) ++_stats->keys;
+}
+
+inline void Parser::StatsAlloc(size_t count) noexcept {
+    if (_stats) _stats->allocations += count;
+}
+
+inline void Parser::StatsDepth(size_t depth) noexcept {
+    if (_stats && depth > _stats->maxDepth) _stats->maxDepth = depth;
+}
+
+inline void Parser::StatsString(size_t size, bool grew, bool escaped) noexcept {
+    if (!_stats) return;
+    _stats->bytesCopied += size;
+    _stats->escapedStrings += escaped;
+    if (grew) ++_stats->allocations;
+}
+#else
+inline void Parser::StatsValue(char) noexcept {}
+inline void Parser::StatsKey() noexcept {}
+inline void Parser::StatsAlloc(size_t) noexcept {}
+inline void Parser::StatsDepth(size_t) noexcept {}
+inline void Parser::StatsString(size_t, bool, bool) noexcept {}
+#endif
+
 
 };              // ------------------- namespace zzjson
 
@@ -0,0 +1,845 @@
+/**
+ * 简单的性能测试
+ * 建议使用 Release 构建：cmake -DCMAKE_BUILD_TYPE=Release ..
+ */
+#include <malloc.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "json.h"
+#include "json_bind.h"
+#include "json_cache.h"
+#include "json_columns.h"
+#include "json_context.h"
+#include "json_parallel.h"
+#include "json_patch.h"
+#include "json_path.h"
+#include "json_shared.h"
+#include "json_snapshot.h"
+#include "json_stream.h"
+
+using namespace zzjson;
+
+/**
+ * 生成测试数据：由对象组成的数组，包含数字、字符串、转义和嵌套数组
+ */
+std::string makeCorpus(size_t records) {
+    std::ostringstream os;
+    os << "[";
+    for (size_t i = 0; i != records; ++i) {
+        if (i > 0) os << ",";
+        os << "{\"id\":" << i << ",\"name\":\"user_" << i
+           << "\",\"score\":" << i * 0.25 - 1000.5
+           << ",\"active\":" << (i % 2 ? "true" : "false")
+           << ",\"tags\":[\"a\",\"b\\n\",\"\\u00e9\"],\"ratio\":1.5e-3"
+           << ",\"nested\":{\"x\":" << i % 97 << ",\"y\":null}}";
+    }
+    os << "]";
+    return os.str();
+}
+
+/**
+ * 同一段数组内容重复 times 次，用于 dedup() 相关的测试
+ */
+std::string makeRepeated(const std::string& arr, size_t times) {
+    std::string body = arr.substr(1, arr.size() - 2);
+    std::string res = "[";
+    for (size_t i = 0; i != times; ++i) {
+        if (i) res += ',';
+        res += body;
+    }
+    return res + "]";
+}
+
+bool loadFile(const std::string& filename, std::string& content) {
+    std::ifstream ifstrm(filename);
+    if (!ifstrm.is_open()) return false;
+    std::stringstream ss;
+    ss << ifstrm.rdbuf();
+    content = ss.str();
+    return true;
+}
+
+/**
+ * 重复执行 f 至少 minSeconds 秒，返回平均每次的耗时 (秒)
+ */
+template <class F>
+double timeIt(F&& f, double minSeconds = 0.3) {
+    using clock = std::chrono::steady_clock;
+    size_t iters = 0;
+    auto begin = clock::now();
+    double elapsed = 0;
+    do {
+        f();
+        ++iters;
+        elapsed = std::chrono::duration<double>(clock::now() - begin).count();
+    } while (elapsed < minSeconds);
+    return elapsed / iters;
+}
+
+void report(const std::string& name, size_t bytes, double seconds) {
+    std::cout << std::left << std::setw(36) << name << std::right
+              << std::setw(10) << std::fixed << std::setprecision(1)
+              << bytes / seconds / (1024 * 1024) << " MB/s" << std::setw(12)
+              << std::setprecision(3) << seconds * 1e3 << " ms" << std::endl;
+}
+
+/**
+ * parse() 与 validate() 的对比
+ */
+void benchValidate(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    double parseTime = timeIt([&] { Json::parse(doc, errMsg); });
+    double validateTime = timeIt([&] { Json::validate(doc, errMsg); });
+    report(name + " parse", doc.size(), parseTime);
+    report(name + " validate", doc.size(), validateTime);
+    std::cout << std::left << std::setw(36) << (name + " speedup") << std::right
+              << std::setw(10) << std::setprecision(2)
+              << parseTime / validateTime << " x" << std::endl;
+}
+
+/**
+ * UTF-8 校验的额外开销
+ */
+void benchUtf8(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    ParseOptions opts;
+    opts.validateUtf8 = true;
+    report(name + " parse", doc.size(),
+           timeIt([&] { Json::parse(doc, errMsg); }));
+    report(name + " parse utf8", doc.size(),
+           timeIt([&] { Json::parse(doc, errMsg, opts); }));
+    report(name + " validate", doc.size(),
+           timeIt([&] { Json::validate(doc, errMsg); }));
+    report(name + " validate utf8", doc.size(),
+           timeIt([&] { Json::validate(doc, errMsg, opts); }));
+}
+
+std::string makeStrings(size_t count, const std::string& text) {
+    std::string doc = "[";
+    for (size_t i = 0; i != count; ++i) {
+        if (i > 0) doc += ",";
+        doc += "\"" + text + "\"";
+    }
+    return doc + "]";
+}
+
+/**
+ * 各种输出模式下的输出字节数和吞吐量 (按输出字节计)
+ */
+void benchSerialize(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    Json json = Json::parse(doc, errMsg);
+    WriterOptions compact, pretty, ascii;
+    pretty.pretty = true;
+    ascii.asciiOnly = true;
+    std::pair<const char*, WriterOptions> modes[] = {
+        {" compact", compact}, {" pretty", pretty}, {" ascii", ascii}};
+    for (auto&& mode : modes) {
+        size_t bytes = json.serialize(mode.second).size();
+        std::cout << std::left << std::setw(36) << (name + mode.first + " bytes")
+                  << std::right << std::setw(10) << bytes << std::endl;
+        report(name + mode.first + " serialize", bytes,
+               timeIt([&] { json.serialize(mode.second); }));
+    }
+}
+
+/**
+ * 与 makeCorpus() 中的记录对应的结构体
+ */
+struct Nested {
+    double x = 0;
+    std::optional<double> y;
+};
+ZZJSON_BIND(Nested, x, y)
+
+struct Record {
+    long long id = 0;
+    std::string name;
+    double score = 0;
+    bool active = false;
+    std::vector<std::string> tags;
+    double ratio = 0;
+    Nested nested;
+};
+ZZJSON_BIND(Record, id, name, score, active, tags, ratio, nested)
+
+/**
+ * 直接解析到结构体 与 先 parse 再逐个字段拷贝 的对比
+ */
+void benchBind(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    std::vector<Record> records;
+    double domTime = timeIt([&] {
+        Json json = Json::parse(doc, errMsg);
+        records.clear();
+        for (size_t i = 0; i != json.size(); ++i) {
+            const Json& r = json[i];
+            Record rec;
+            rec.id = static_cast<long long>(r["id"].toDouble());
+            rec.name = r["name"].toString();
+            rec.score = r["score"].toDouble();
+            rec.active = r["active"].toBool();
+            for (size_t j = 0; j != r["tags"].size(); ++j)
+                rec.tags.emplace_back(r["tags"][j].toString());
+            rec.ratio = r["ratio"].toDouble();
+            rec.nested.x = r["nested"]["x"].toDouble();
+            records.push_back(std::move(rec));
+        }
+    });
+    double bindTime = timeIt([&] { fromJson(doc, records, errMsg); });
+    report(name + " parse + copy", doc.size(), domTime);
+    report(name + " fromJson", doc.size(), bindTime);
+    report(name + " toJson", toJson(records).size(),
+           timeIt([&] { toJson(records); }));
+}
+
+/**
+ * MessagePack 与文本格式的大小和编解码速度对比 (按各自的字节数计)
+ */
+void benchMsgPack(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    Json json = Json::parse(doc, errMsg);
+    std::string text = json.serialize();
+    std::string packed = json.toMsgPack();
+    std::cout << std::left << std::setw(36) << (name + " text bytes")
+              << std::right << std::setw(10) << text.size() << std::endl;
+    std::cout << std::left << std::setw(36) << (name + " msgpack bytes")
+              << std::right << std::setw(10) << packed.size() << std::endl;
+    report(name + " serialize", text.size(), timeIt([&] { json.serialize(); }));
+    report(name + " toMsgPack", packed.size(), timeIt([&] { json.toMsgPack(); }));
+    report(name + " parse", text.size(),
+           timeIt([&] { Json::parse(text, errMsg); }));
+    report(name + " fromMsgPack", packed.size(),
+           timeIt([&] { Json::fromMsgPack(packed, errMsg); }));
+}
+
+/**
+ * 快照：mmap 打开 与 parse 的启动耗时对比，以及查询速度
+ */
+void benchSnapshot(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    Json json = Json::parse(doc, errMsg);
+    std::string path = "/tmp/zzjson_bench_snapshot.bin";
+    if (!Snapshot::save(json, path, errMsg)) {
+        std::cout << errMsg << std::endl;
+        return;
+    }
+    report(name + " parse", doc.size(), timeIt([&] { Json::parse(doc, errMsg); }));
+    report(name + " snapshot open", doc.size(),
+           timeIt([&] { Snapshot::open(path, errMsg); }));
+    report(name + " snapshot open+verify", doc.size(),
+           timeIt([&] { Snapshot::open(path, errMsg, true); }));
+
+    auto snap = Snapshot::open(path, errMsg);
+    size_t n = json.size();
+    double sum = 0;
+    double domTime = timeIt([&] {
+        for (size_t i = 0; i != n; ++i) sum += json[i]["nested"]["x"].toDouble();
+    });
+    double snapTime = timeIt([&] {
+        SnapshotValue root = snap->root();
+        for (size_t i = 0; i != n; ++i) sum += root[i]["nested"]["x"].toDouble();
+    });
+    std::cout << std::left << std::setw(36) << (name + " Json lookup") << std::right
+              << std::setw(10) << std::setprecision(1) << domTime / n * 1e9
+              << " ns" << std::endl;
+    std::cout << std::left << std::setw(36) << (name + " snapshot lookup")
+              << std::right << std::setw(10) << snapTime / n * 1e9 << " ns"
+              << std::endl;
+    unlink(path.c_str());
+}
+
+/**
+ * 编译后的路径 与 每次构造 key 的 operator[] 链的对比
+ */
+void benchPath(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    Json json = Json::parse(doc, errMsg);
+    auto ptr = JsonPointer::compile("/nested/x", errMsg);
+    auto path = JsonPath::compile("$[*].nested.x", errMsg);
+    auto snap = Snapshot::fromBuffer(Snapshot::write(json), errMsg);
+    size_t n = json.size();
+    double sum = 0;
+    std::vector<const Json*> out;
+    std::pair<const char*, double> results[] = {
+        {" operator[] lookup", timeIt([&] {
+             for (size_t i = 0; i != n; ++i)
+                 sum += json[i]["nested"]["x"].toDouble();
+         })},
+        {" pointer lookup", timeIt([&] {
+             for (size_t i = 0; i != n; ++i) sum += ptr->find(json[i])->toDouble();
+         })},
+        {" path select", timeIt([&] {
+             out.clear();
+             path->select(json, out);
+             for (const Json* val : out) sum += val->toDouble();
+         })},
+        {" snapshot operator[] lookup", timeIt([&] {
+             SnapshotValue root = snap->root();
+             for (size_t i = 0; i != n; ++i)
+                 sum += root[i]["nested"]["x"].toDouble();
+         })},
+        {" snapshot pointer lookup", timeIt([&] {
+             SnapshotValue root = snap->root();
+             for (size_t i = 0; i != n; ++i) sum += ptr->find(root[i])->toDouble();
+         })},
+    };
+    for (auto&& res : results) {
+        std::cout << std::left << std::setw(36) << (name + res.first) << std::right
+                  << std::setw(10) << std::setprecision(1) << res.second / n * 1e9
+                  << " ns" << std::endl;
+    }
+}
+
+/**
+ * 生成 NDJSON 格式的日志：每条记录约 1KB，只有少数字段会被提取
+ */
+std::string makeLogLines(size_t records) {
+    std::ostringstream os;
+    for (size_t i = 0; i != records; ++i) {
+        os << "{\"time\":\"2024-01-01T00:00:" << i % 60 << "Z\",\"request\":{"
+           << "\"method\":\"GET\",\"path\":\"/api/v1/items/" << i << "\","
+           << "\"headers\":{";
+        for (int h = 0; h != 12; ++h) {
+            if (h > 0) os << ",";
+            os << "\"x-header-" << h << "\":\"value " << h << " for request "
+               << i << "\"";
+        }
+        os << "},\"user\":{\"id\":" << i % 1000 << ",\"name\":\"user_" << i
+           << "\",\"roles\":[\"a\",\"b\"]}},\"status\":200,"
+           << "\"latency_ms\":" << i % 250 + 0.5 << ",\"trace\":[";
+        for (int t = 0; t != 8; ++t) os << (t ? "," : "") << t * 1.25;
+        os << "]}\n";
+    }
+    return os.str();
+}
+
+/**
+ * 流式提取 与 逐行 parse 再查找 的对比，以只跳过不提取的速度为基准
+ */
+void benchStream(const std::string& name, const std::string& lines) {
+    std::string errMsg;
+    StreamExtractor scan, ex;
+    ex.add(*JsonPath::compile("$.request.user.id", errMsg), errMsg);
+    ex.add(*JsonPath::compile("$.latency_ms", errMsg), errMsg);
+    auto user = JsonPointer::compile("/request/user/id", errMsg);
+    auto latency = JsonPointer::compile("/latency_ms", errMsg);
+    StreamExtractor::Slots slots;
+    double sum = 0;
+    report(name + " scan only", lines.size(), timeIt([&] {
+        scan.extractLines(lines, slots, [](size_t) {}, errMsg);
+    }));
+    report(name + " stream extract", lines.size(), timeIt([&] {
+        ex.extractLines(lines, slots, [&](size_t) {
+            sum += slots[0]->toDouble() + slots[1]->toDouble();
+        }, errMsg);
+    }));
+    report(name + " parse + pointer", lines.size(), timeIt([&] {
+        size_t pos = 0;
+        while (pos < lines.size()) {
+            size_t end = lines.find('\n', pos);
+            Json json = Json::parse(lines.substr(pos, end - pos), errMsg);
+            sum += user->find(json)->toDouble() + latency->find(json)->toDouble();
+            pos = end + 1;
+        }
+    }));
+}
+
+/**
+ * 按列提取：逐个元素 operator[] 与 ColumnReader 的对比
+ */
+void benchColumns(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    Json json = Json::parse(doc, errMsg);
+    const Json& records = json;
+    size_t n = records.size();
+    ColumnReader reader({{"id", ColumnType::kInt64},
+                         {"name", ColumnType::kString},
+                         {"score", ColumnType::kDouble},
+                         {"active", ColumnType::kBool}});
+    ColumnTable table;
+    std::vector<int64_t> ids;
+    std::vector<std::string> names;
+    std::vector<double> scores;
+    std::vector<uint8_t> actives;
+    double loopTime = timeIt([&] {
+        ids.clear(), names.clear(), scores.clear(), actives.clear();
+        for (size_t i = 0; i != n; ++i) {
+            const Json& r = records[i];
+            ids.push_back(static_cast<int64_t>(r["id"].toDouble()));
+            names.emplace_back(r["name"].toString());
+            scores.push_back(r["score"].toDouble());
+            actives.push_back(r["active"].toBool());
+        }
+    });
+    double readTime = timeIt([&] { reader.read(records, table, errMsg); });
+    std::cout << std::left << std::setw(36) << (name + " operator[] loop") << std::right
+              << std::setw(10) << std::setprecision(1) << loopTime / n * 1e9
+              << " ns/row" << std::endl;
+    std::cout << std::left << std::setw(36) << (name + " columns from Json")
+              << std::right << std::setw(10) << readTime / n * 1e9 << " ns/row"
+              << std::endl;
+    report(name + " parse + operator[] loop", doc.size(),
+           timeIt([&] { Json::parse(doc, errMsg); }) + loopTime);
+    report(name + " columns from text", doc.size(),
+           timeIt([&] { reader.parse(doc, table, errMsg); }));
+}
+
+/**
+ * 当前堆上已分配的字节数 (glibc)
+ */
+size_t heapInUse() {
+    return mallinfo2().uordblks;
+}
+
+/**
+ * 紧凑数组 与 普通数组 的内存占用、解析和遍历速度对比
+ */
+void benchPacked(const std::string& name, size_t count) {
+    std::ostringstream os;
+    os << "[";
+    for (size_t i = 0; i != count; ++i) os << (i ? "," : "") << i * 0.001 - 500;
+    os << "]";
+    std::string doc = os.str();
+
+    std::string errMsg;
+    ParseOptions packed;
+    packed.packArrays = true;
+    std::pair<const char*, ParseOptions> modes[] = {{" boxed", ParseOptions()},
+                                                    {" packed", packed}};
+    for (auto&& mode : modes) {
+        size_t before = heapInUse();
+        const Json json = Json::parse(doc, errMsg, mode.second);
+        size_t bytes = heapInUse() - before;
+        std::cout << std::left << std::setw(36) << (name + mode.first + " bytes/elem")
+                  << std::right << std::setw(10) << std::setprecision(1)
+                  << 1.0 * bytes / count << std::endl;
+        report(name + mode.first + " parse", doc.size(),
+               timeIt([&] { Json::parse(doc, errMsg, mode.second); }));
+        volatile double sink = 0;     // 防止求和被优化掉
+        report(name + mode.first + " sum operator[]", count * sizeof(double),
+               timeIt([&] {
+                   double sum = 0;
+                   for (size_t i = 0; i != count; ++i) sum += json[i].toDouble();
+                   sink = sum;
+               }));
+        if (json.isPacked()) {
+            report(name + mode.first + " sum numbers()", count * sizeof(double),
+                   timeIt([&] {
+                       double sum = 0;
+                       for (double val : json.numbers()) sum += val;
+                       sink = sum;
+                   }));
+        }
+    }
+}
+
+/**
+ * 立即转换 与 延迟转换 (ParseOptions::lazyNumbers) 的数字：
+ * 只解析、解析后原样转发 (序列化) 和解析后读取全部数字
+ */
+void benchLazy(const std::string& name, size_t count) {
+    std::ostringstream os;
+    os << std::setprecision(17) << "[";
+    for (size_t i = 0; i != count; ++i) os << (i ? "," : "") << i * 0.001 - 500;
+    os << "]";
+    std::string doc = os.str();
+
+    std::string errMsg;
+    ParseOptions lazy;
+    lazy.lazyNumbers = true;
+    std::pair<const char*, ParseOptions> modes[] = {{" eager", ParseOptions()},
+                                                    {" lazy", lazy}};
+    for (auto&& mode : modes) {
+        report(name + mode.first + " parse", doc.size(),
+               timeIt([&] { Json::parse(doc, errMsg, mode.second); }));
+        report(name + mode.first + " parse+serialize", doc.size(),
+               timeIt([&] { Json::parse(doc, errMsg, mode.second).serialize(); }));
+        volatile double sink = 0;
+        report(name + mode.first + " parse+sum", doc.size(), timeIt([&] {
+                   const Json json = Json::parse(doc, errMsg, mode.second);
+                   double sum = 0;
+                   for (size_t i = 0; i != count; ++i) sum += json[i].toDouble();
+                   sink = sum;
+               }));
+    }
+}
+
+/**
+ * 读取共享文档的开销：全局互斥锁下拷贝 shared_ptr、SharedJson::load() 与 Reader::get()
+ * 后台同时每 10ms 发布一个新版本
+ */
+void benchShared(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    SharedJson store(Json::parse(doc, errMsg));
+    std::mutex mutex;
+    SharedJson::Document guarded = store.load();
+    std::atomic<bool> stop{false};
+    std::thread writer([&] {
+        while (!stop) {
+            store.reload(doc, errMsg);
+            std::lock_guard<std::mutex> lock(mutex);
+            guarded = store.load();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    });
+    volatile size_t sink = 0;
+    auto perRead = [&](auto read) {
+        return timeIt([&] {
+                   for (int i = 0; i != 1000; ++i) sink = read();
+               }) / 1000;
+    };
+    SharedJson::Reader reader(store);
+    double mutexTime = perRead([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        SharedJson::Document snap = guarded;
+        return snap->size();
+    });
+    double loadTime = perRead([&] { return store.load()->size(); });
+    double readerTime = perRead([&] { return reader.get().size(); });
+    stop = true;
+    writer.join();
+    for (auto&& item : {std::make_pair(" mutex + copy", mutexTime),
+                        std::make_pair(" SharedJson::load()", loadTime),
+                        std::make_pair(" Reader::get()", readerTime)}) {
+        std::cout << std::left << std::setw(36) << (name + item.first) << std::right
+                  << std::setw(10) << std::setprecision(1) << item.second * 1e9
+                  << " ns/read" << std::endl;
+    }
+}
+
+/**
+ * 重复的输入：每次 Json::parse() 与经过 ParseCache (全部命中) 的对比
+ */
+void benchCache(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    ParseCache cache;
+    report(name + " Json::parse", doc.size(), timeIt([&] { Json::parse(doc, errMsg); }));
+    report(name + " ParseCache hit", doc.size(), timeIt([&] { cache.parse(doc, errMsg); }));
+    CacheStats stats = cache.stats();
+    std::cout << std::left << std::setw(36) << (name + " hits / misses") << std::right
+              << std::setw(10) << stats.hits << " / " << stats.misses << std::endl;
+}
+
+/**
+ * 反复解析小文档：Json::parse() 与复用的 ParseContext 的对比
+ */
+void benchContext(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    ParseContext ctx;
+    double parseTime = timeIt([&] { Json::parse(doc, errMsg); });
+    double ctxTime = timeIt([&] { ctx.parse(doc, errMsg); });
+    for (auto&& item : {std::make_pair(" Json::parse", parseTime),
+                        std::make_pair(" ParseContext", ctxTime)}) {
+        std::cout << std::left << std::setw(36) << (name + item.first) << std::right
+                  << std::setw(10) << std::setprecision(1) << item.second * 1e9
+                  << " ns/doc" << std::endl;
+    }
+}
+
+/**
+ * 默认的堆分配 与 monotonic_buffer_resource 的对比 (解析 + 析构)
+ */
+void benchPmr(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    report(name + " parse (new/delete)", doc.size(),
+           timeIt([&] { Json::parse(doc, errMsg); }));
+    std::pmr::monotonic_buffer_resource arena;
+    report(name + " parse (monotonic)", doc.size(), timeIt([&] {
+               Json::parse(doc, errMsg, ParseOptions(), &arena);
+               arena.release();
+           }));
+}
+
+/**
+ * 不统计 与 开启 ParseStats / SerializeStats 的对比
+ * (定义 ZZJSON_DISABLE_STATS 时两者相同)
+ */
+void benchStats(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    ParseStats parseStats;
+    ParseOptions popts;
+    popts.stats = &parseStats;
+    report(name + " parse", doc.size(), timeIt([&] { Json::parse(doc, errMsg); }));
+    report(name + " parse (stats)", doc.size(),
+           timeIt([&] { Json::parse(doc, errMsg, popts); }));
+
+    Json json = Json::parse(doc, errMsg);
+    SerializeStats writeStats;
+    WriterOptions wopts;
+    wopts.stats = &writeStats;
+    size_t bytes = json.serialize().size();
+    report(name + " serialize", bytes, timeIt([&] { json.serialize(); }));
+    report(name + " serialize (stats)", bytes, timeIt([&] { json.serialize(wopts); }));
+}
+
+/**
+ * 解析后、compact() 后与 Snapshot::freeze() 后占用的内存
+ */
+void benchMemory(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    Json json = Json::parse(doc, errMsg);
+    size_t parsed = json.memoryUsage().total();
+    json.compact();
+    size_t compacted = json.memoryUsage().total();
+    auto frozen = Snapshot::freeze(json, errMsg);
+    for (auto&& item : {std::make_pair(" parsed", parsed),
+                        std::make_pair(" compact()", compacted),
+                        std::make_pair(" freeze()", frozen->byteSize())}) {
+        std::cout << std::left << std::setw(36) << (name + item.first) << std::right
+                  << std::setw(10) << item.second / 1024 << " KB" << std::endl;
+    }
+}
+
+/**
+ * dedup() 前后的内存占用，以及两份相同文档的 operator== 耗时
+ */
+void benchDedup(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    Json json = Json::parse(doc, errMsg);
+    Json other = Json::parse(doc, errMsg);
+    size_t before = json.memoryUsage().total();
+    double eqTime = timeIt([&] { (void)(json == other); });
+    double dedupTime = timeIt([&] {
+        Json copy = Json::parse(doc, errMsg);
+        copy.dedup();
+    });
+    json.dedup();
+    other.dedup();
+    double sharedEqTime = timeIt([&] { (void)(json == other); });
+    std::cout << std::left << std::setw(36) << (name + " memory") << std::right
+              << std::setw(10) << before / 1024 << " KB -> "
+              << json.memoryUsage().total() / 1024 << " KB" << std::endl;
+    report(name + " parse + dedup()", doc.size(), dedupTime);
+    report(name + " operator==", doc.size(), eqTime);
+    report(name + " operator== (deduped)", doc.size(), sharedEqTime);
+}
+
+/**
+ * 遍历整个文档累加数字：getType() + toXxx() 与 visit() 只分派一次的对比
+ */
+double sumByType(const Json& json) {
+    switch (json.getType()) {
+        case JsonType::m_number:
+            return json.toDouble();
+        case JsonType::m_array: {
+            double sum = 0;
+            for (auto& val : json.toArray()) sum += sumByType(val);
+            return sum;
+        }
+        case JsonType::m_obj: {
+            double sum = 0;
+            for (auto& p : json.toObj()) sum += sumByType(p.second);
+            return sum;
+        }
+        default:
+            return 0;
+    }
+}
+
+double sumByVisit(const Json& json) {
+    return json.visit(Overloaded{
+        [](double val) { return val; },
+        [](Span<const double> nums) {
+            return std::accumulate(nums.begin(), nums.end(), 0.0);
+        },
+        [](const Json::_array& arr) {
+            double sum = 0;
+            for (auto& val : arr) sum += sumByVisit(val);
+            return sum;
+        },
+        [](const Json::_obj& obj) {
+            double sum = 0;
+            for (auto& p : obj) sum += sumByVisit(p.second);
+            return sum;
+        },
+        [](const auto&) { return 0.0; },
+    });
+}
+
+void benchVisit(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    Json json = Json::parse(doc, errMsg);
+    volatile double sink = 0;
+    report(name + " traverse (getType)", doc.size(), timeIt([&] { sink = sumByType(json); }));
+    report(name + " traverse (visit)", doc.size(), timeIt([&] { sink = sumByVisit(json); }));
+    (void)sink;
+}
+
+/**
+ * 调用者看到的释放耗时：直接析构与交给后台线程 (releaseAsync()) 的对比
+ */
+void benchRelease(const std::string& name, const std::string& doc) {
+    using clock = std::chrono::steady_clock;
+    std::string errMsg;
+    auto measure = [&](auto release) {
+        double total = 0;
+        for (int i = 0; i != 5; ++i) {
+            Json json = Json::parse(doc, errMsg);
+            auto begin = clock::now();
+            release(json);
+            total += std::chrono::duration<double>(clock::now() - begin).count();
+        }
+        return total / 5;
+    };
+    report(name + " release", doc.size(), measure([](Json& json) { json = Json(); }));
+    report(name + " releaseAsync()", doc.size(),
+           measure([](Json& json) { Json::releaseAsync(std::move(json)); }));
+}
+
+/**
+ * 构建与 makeCorpus() 相同的文档：先填充临时的 vector / unordered_map 再拷贝进 Json，
+ * 与用构建接口直接在文档中构造 (可选地放在 monotonic_buffer_resource 中) 对比
+ */
+void benchBuild(const std::string& name, size_t records) {
+    auto viaTemporaries = [&] {
+        std::vector<Json> items;
+        for (size_t i = 0; i != records; ++i) {
+            std::unordered_map<std::string, Json> item;
+            item["id"] = Json(static_cast<double>(i));
+            item["name"] = Json("user_" + std::to_string(i));
+            item["score"] = Json(i * 0.25 - 1000.5);
+            item["active"] = Json(i % 2 == 1);
+            item["tags"] = Json(std::vector<Json>{Json("a"), Json("b\n"), Json("\u00e9")});
+            item["ratio"] = Json(1.5e-3);
+            item["nested"] = Json(std::unordered_map<std::string, Json>{
+                {"x", Json(static_cast<double>(i % 97))}, {"y", Json(nullptr)}});
+            items.push_back(Json(item));
+        }
+        return Json(items);
+    };
+    auto inPlace = [&](std::pmr::memory_resource* resource) {
+        Json doc(Json::_array(), resource);
+        doc.reserve(records);
+        for (size_t i = 0; i != records; ++i) {
+            Json& item = doc.emplace_back(Json::_obj());
+            item.reserve(7);
+            item.emplace("id", static_cast<double>(i));
+            item.emplace("name", "user_" + std::to_string(i));
+            item.emplace("score", i * 0.25 - 1000.5);
+            item.emplace("active", i % 2 == 1);
+            Json& tags = item.emplace("tags", Json::_array()).first;
+            tags.reserve(3);
+            tags.emplace_back("a");
+            tags.emplace_back("b\n");
+            tags.emplace_back("\u00e9");
+            item.emplace("ratio", 1.5e-3);
+            Json& nested = item.emplace("nested", Json::_obj()).first;
+            nested.emplace("x", static_cast<double>(i % 97));
+            nested.emplace("y", nullptr);
+        }
+        return doc;
+    };
+    size_t bytes = inPlace(std::pmr::get_default_resource()).serialize().size();
+    report(name + " build (temporaries)", bytes, timeIt([&] { viaTemporaries(); }));
+    report(name + " build (in place)", bytes,
+           timeIt([&] { inPlace(std::pmr::get_default_resource()); }));
+    report(name + " build (in place, monotonic)", bytes, timeIt([&] {
+               std::pmr::monotonic_buffer_resource arena;
+               inPlace(&arena);
+           }));
+}
+
+/**
+ * 只改动两处时 diff() / applyPatch() 的耗时：普通的文档需要比较整棵树，
+ * dedup() 后拷贝得到的文档与原文档共享结构，只比较被修改的路径
+ */
+void benchPatch(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    Json from = Json::parse(doc, errMsg);
+    Json to = Json::parse(doc, errMsg);
+    to[123]["name"] = Json("renamed");
+    to[4567]["nested"]["y"] = Json(1);
+    Json patch = diff(from, to);
+    report(name + " diff()", doc.size(), timeIt([&] { diff(from, to); }));
+    report(name + " applyPatch()", doc.size(),
+           timeIt([&] { applyPatch(from, patch, errMsg); }));
+
+    from.dedup();
+    Json next = from;
+    next[123]["name"] = Json("renamed");
+    next[4567]["nested"]["y"] = Json(1);
+    report(name + " diff() (deduped)", doc.size(), timeIt([&] { diff(from, next); }));
+}
+
+/**
+ * serializeParallel() 在不同线程数下与 serialize() 的对比
+ */
+void benchParallel(const std::string& name, const std::string& doc) {
+    std::string errMsg;
+    Json json = Json::parse(doc, errMsg);
+    size_t bytes = json.serialize().size();
+    report(name + " serialize", bytes, timeIt([&] { json.serialize(); }));
+    for (unsigned threads : {1u, 2u, 4u, 8u}) {
+        ParallelOptions popts;
+        popts.threads = threads;
+        report(name + " parallel x" + std::to_string(threads), bytes,
+               timeIt([&] { serializeParallel(json, WriterOptions(), popts); }));
+    }
+    std::cout << "  (hardware_concurrency = " << std::thread::hardware_concurrency()
+              << ")" << std::endl;
+}
+
+int main() {
+    std::string corpus = makeCorpus(20000);
+    benchValidate("synthetic", corpus);
+
+    std::string pass1;
+    if (loadFile("../Data/pass1.json", pass1)) {
+        benchValidate("pass1.json", pass1);
+    }
+
+    benchUtf8("ascii strings",
+              makeStrings(20000, "The quick brown fox jumps over the lazy "
+                                 "dog, again and again and again."));
+    benchUtf8("utf8 strings",
+              makeStrings(20000, "\xE4\xBD\xA0\xE5\xA5\xBD, "
+                                 "\xE4\xB8\x96\xE7\x95\x8C! "
+                                 "caf\xC3\xA9 \xF0\x9F\x98\x80 na\xC3\xAFve"));
+
+    benchBind("synthetic", corpus);
+
+    benchMsgPack("synthetic", corpus);
+    benchSnapshot("synthetic", corpus);
+    benchPath("synthetic", corpus);
+    benchStream("ndjson logs", makeLogLines(20000));
+    benchPacked("1M numbers", 1000000);
+    benchLazy("200k numbers", 200000);
+    benchColumns("synthetic", corpus);
+    benchContext("small record", makeCorpus(3));
+    benchShared("synthetic", corpus);
+    benchCache("small record", makeCorpus(3));
+    benchCache("synthetic", corpus);
+    benchPmr("synthetic", corpus);
+    benchStats("synthetic", corpus);
+    benchMemory("synthetic", corpus);
+    benchDedup("synthetic", corpus);
+    benchDedup("repeated records", makeRepeated(makeCorpus(20), 500));
+    benchPatch("synthetic", corpus);
+    benchBuild("synthetic", 20000);
+    benchVisit("synthetic", corpus);
+    benchRelease("synthetic x5", makeCorpus(100000));
+    if (!pass1.empty()) {
+        benchMsgPack("pass1.json", pass1);
+    }
+
+    benchSerialize("synthetic", corpus);
+    benchParallel("synthetic x5", makeCorpus(100000));
+    benchSerialize("long strings",
+                   makeStrings(20000, "The quick brown fox jumps over the "
+                                      "lazy dog, again and again and again."));
+    benchSerialize("escaped strings",
+                   makeStrings(20000, "line one\\nline \\\"two\\\"\\t"
+                                      "tab\\u0001 and some more text"));
+}
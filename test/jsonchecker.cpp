@@ -27,31 +27,46 @@ std::string getJsonStr(const std::string& filename) {
     return jsonStr;
 }
 
-void failJson(const std::string& filename) {
+/**
+ * parse() 和 validate() 检查同一个文件：两者都要符合预期，并且结果和错误信息一致
+ * 返回发现的问题数
+ */
+int checkJson(const std::string& filename, bool expectPass) {
     std::string jsonStr = getJsonStr(filename);
-    std::string errMsg;
-    Json json_ = Json::parse(jsonStr, errMsg);
-    if(errMsg != "") {
-        std::cerr << "ERROR! Expect fail, but passed!" << std::endl;
-        std::cerr << "File: " << filename << std::endl;
-        std::cerr << jsonStr << std::endl;
-        std::cerr << std::endl;
-    }
-}
+    std::string parseErr;
+    Json::parse(jsonStr, parseErr);
+    std::string validateErr;
+    bool valid = Json::validate(jsonStr, validateErr);
+    bool parsed = parseErr.empty();
 
-void passJson(const std::string& filename) {
-    std::string jsonStr = getJsonStr(filename);
-    std::string errMsg;
-    Json json_ = Json::parse(jsonStr, errMsg);
-    if(errMsg != "") {
-        std::cerr << "ERROR! Expect pass, but failed!" << std::endl;
+    int errors = 0;
+    auto report = [&](const char* what) {
+        ++errors;
+        std::cerr << "ERROR! " << what << std::endl;
         std::cerr << "File: " << filename << std::endl;
         std::cerr << jsonStr << std::endl;
+        std::cerr << "parse():    " << (parsed ? "passed" : parseErr) << std::endl;
+        std::cerr << "validate(): " << (valid ? "passed" : validateErr) << std::endl;
         std::cerr << std::endl;
+    };
+    if (parsed != expectPass) {
+        report(expectPass ? "parse() expect pass, but failed!" : "parse() expect fail, but passed!");
+    }
+    if (valid != expectPass) {
+        report(expectPass ? "validate() expect pass, but failed!"
+                          : "validate() expect fail, but passed!");
     }
+    if (parsed != valid || parseErr != validateErr) {
+        report("parse() and validate() disagree!");
+    }
+    return errors;
 }
 
-int main() {
+/**
+ * 用法：jsonchecker [数据目录]，默认为 ../Data；有问题时返回 1
+ */
+int main(int argc, char* argv[]) {
+    std::string dir = argc > 1 ? argv[1] : "../Data";
     struct stat stat;
     
     if(lstat(".", &stat) < 0) {
@@ -59,23 +74,24 @@ int main() {
         return 0;
     }
 
-    DIR* dp = opendir("../Data");
+    DIR* dp = opendir(dir.c_str());
     if(!dp) {
         perror("Can't open data.");
-        return 0;
+        return 1;
     }
 
+    int errors = 0;
     dirent* dirp;
     while((dirp = readdir(dp)) != nullptr) {
-        std::string filename = "../Data";
+        std::string filename = dir + "/";
         switch (dirp->d_name[0])
         {
             case 'f': {
-                failJson(filename + dirp->d_name);
+                errors += checkJson(filename + dirp->d_name, false);
                 break;
             }
             case 'p': {
-                passJson(filename + dirp->d_name);
+                errors += checkJson(filename + dirp->d_name, true);
                 break;
             }
             default: {
@@ -84,4 +100,5 @@ int main() {
         }
     }
     closedir(dp);
+    return errors == 0 ? 0 : 1;
 }
\ No newline at end of file
@@ -1,10 +1,45 @@
 
 #include <gtest/gtest.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <memory_resource>
+#include <new>
+#include <numeric>
 #include <string>
+#include <thread>
 #include "json.h"
+#include "json_bind.h"
+#include "json_cache.h"
+#include "json_columns.h"
+#include "json_context.h"
+#include "json_parallel.h"
+#include "json_patch.h"
+#include "json_path.h"
+#include "json_shared.h"
+#include "json_snapshot.h"
+#include "json_stream.h"
+#include "json_walk.h"
 
 using namespace zzjson;
 
+/**
+ * 统计堆分配的次数
+ */
+static std::atomic<size_t> gAllocations{0};
+
+// 不内联，避免 GCC 把 malloc() / free() 与 new / delete 误判为不匹配
+__attribute__((noinline)) void* operator new(size_t size) {
+  ++gAllocations;
+  if (void* ptr = malloc(size ? size : 1)) return ptr;
+  throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* ptr) noexcept { free(ptr); }
+__attribute__((noinline)) void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+
 Json parseOk(const std::string& strJson) {
   std::string errMsg;
   Json json = Json::parse(strJson, errMsg);
@@ -384,13 +419,2017 @@ TEST(RoundTrip, JsonString) {
 }
 
 TEST(RoundTrip, JsonArray) {
-  testRoundtrip("[  ]");
-  testRoundtrip("[ null, false, true, 123, \"abc\", [ 1, 2, 3 ] ]");
+  testRoundtrip("[]");
+  testRoundtrip("[null,false,true,123,\"abc\",[1,2,3]]");
 }
 
 TEST(RoundTrip, JsonObject) {
-  testRoundtrip("{  }");
+  testRoundtrip("{}");
   //  testRoundtrip(
   //     R"({ "o": { "3": 3, "2": 2, "1": 1 }, "a": [ 1, 2, 3 ], "s": "abc", "n": null, "f": false, "t": true, "i": 123
   //     })");
 }
+
+#define testValidate(strJson)                                 \
+  do {                                                        \
+    std::string parseErr, validateErr;                        \
+    Json::parse(strJson, parseErr);                           \
+    bool ok = Json::validate(strJson, validateErr);           \
+    EXPECT_EQ(ok, parseErr.empty());                          \
+    EXPECT_EQ(validateErr, parseErr);                         \
+  } while (0)
+
+TEST(Validate, Pass) {
+  testValidate("null");
+  testValidate(" true ");
+  testValidate("false");
+  testValidate("-1.5e-10");
+  testValidate("1e-10000");
+  testValidate("1.7976931348623157e+308");
+  testValidate("\"\\uD834\\uDD1E \\\" \\\\ \\/ \\b \\f \\n \\r \\t\"");
+  testValidate("[ null , false , true , 123 , \"abc\", [ 1, 2, 3 ] ]");
+  testValidate("{ \"a\" : [ 1, { \"b\" : {} } ], \"c\" : \"d\" }");
+}
+
+TEST(Validate, Error) {
+  const char* errors[] = {
+      "", " ", "nul", "?", "+0", ".123", "1.", "inf", "NAN", "[1,]",
+      "[\"a\", nul]", "null x", "0123", "0x0", "1e309", "-1e309",
+      "1.7976931348623159e+308", "100000000000000000000e289", "\"", "\"abc",
+      "\"\\v\"", "\"\\x12\"", "\"\x01\"", "\"\\u\"", "\"\\u012\"",
+      "\"\\u00G/\"", "\"\\uD800\"", "\"\\uD800\\\\\\", "\"\\uD800\\uE000\"",
+      "[1", "[1}", "[[]", "{:1,", "{1:1,", "{\"a\":1,", "{\"a\"}",
+      "{\"a\",\"b\"}", "{\"a\":1", "{\"a\":1]", "{\"a\":{}"};
+  for (auto strJson : errors) {
+    testValidate(strJson);
+  }
+}
+
+TEST(Validate, Bounded) {
+  // 只校验前 len 个字节，不依赖结尾的 '\0'
+  std::string errMsg;
+  const char buf[] = {'[', '1', ',', '2', ']', 'x'};
+  EXPECT_TRUE(Json::validate(buf, 5, errMsg));
+  EXPECT_FALSE(Json::validate(buf, 4, errMsg));
+  EXPECT_EQ(errMsg, "MISS COMMA OR SQUARE BRACKET: ");
+  EXPECT_FALSE(Json::validate(buf, 6, errMsg));
+  EXPECT_EQ(errMsg, "ROOT NOT SINGULAR: x");
+  const char str[] = {'"', 'a', 'b'};
+  EXPECT_FALSE(Json::validate(str, 3, errMsg));
+  EXPECT_EQ(errMsg, "MISS QUOTATION MARK: \"ab");
+}
+
+#define testUtf8(expect, strJson)                              \
+  do {                                                         \
+    ParseOptions opts;                                         \
+    opts.validateUtf8 = true;                                  \
+    std::string parseErr, validateErr;                         \
+    Json::parse(strJson, parseErr, opts);                      \
+    Json::validate(strJson, validateErr, opts);                \
+    EXPECT_EQ(parseErr.substr(0, parseErr.find(':')), expect); \
+    EXPECT_EQ(validateErr, parseErr);                          \
+  } while (0)
+
+TEST(Utf8, Valid) {
+  testUtf8("", "\"\xC2\xA2\"");
+  testUtf8("", "\"\xE2\x82\xAC\"");
+  testUtf8("", "\"\xF0\x9D\x84\x9E\"");
+  testUtf8("", "\"\xF4\x8F\xBF\xBF\"");
+  testUtf8("", "\"\\uD834\\uDD1E\"");
+  // 超过一个 SIMD 块的长字符串，非 ASCII 和转义出现在块边界附近
+  testUtf8("", "[\"0123456789abcdefghijklmnopqrstu\xC2\xA2vwxyz\\n0123456789\"]");
+  Json json = parseOk("\"0123456789abcdefghijklmnopqrstuvwxyz\\t\xE2\x82\xAC\"");
+  EXPECT_EQ(json.toString(), "0123456789abcdefghijklmnopqrstuvwxyz\t\xE2\x82\xAC");
+}
+
+TEST(Utf8, Invalid) {
+  testUtf8("INVALID UTF8", "\"\x80\"");
+  testUtf8("INVALID UTF8", "\"\xC0\x80\"");
+  testUtf8("INVALID UTF8", "\"\xC1\xBF\"");
+  testUtf8("INVALID UTF8", "\"\xE0\x80\x80\"");
+  testUtf8("INVALID UTF8", "\"\xED\xA0\x80\"");
+  testUtf8("INVALID UTF8", "\"\xF0\x80\x80\x80\"");
+  testUtf8("INVALID UTF8", "\"\xF4\x90\x80\x80\"");
+  testUtf8("INVALID UTF8", "\"\xF5\x80\x80\x80\"");
+  testUtf8("INVALID UTF8", "\"\xE2\x82\"");
+  testUtf8("INVALID UTF8", "{\"0123456789abcdefghijklmnopqrstuvwxyz\xFF\":1}");
+  testUtf8("INVALID UNICODE SURROGATE", "\"\\uDC00\"");
+  // 默认不校验，原始字节保持不变
+  Json json = parseOk("\"\xC0\x80\"");
+  EXPECT_EQ(json.toString(), "\xC0\x80");
+}
+
+TEST(Serialize, Escape) {
+  std::string s = "0123456789abcdefghijklmnopqrstuvwxyz\"\\/\b\f\n\r\t";
+  s.push_back('\0');
+  s += "\x01\x1F 0123456789abcdefghijklmnopqrstuvwxyz\xE2\x82\xAC";
+  Json json(s);
+  EXPECT_EQ(json.serialize(),
+            "\"0123456789abcdefghijklmnopqrstuvwxyz\\\"\\\\/\\b\\f\\n\\r\\t"
+            "\\u0000\\u0001\\u001F 0123456789abcdefghijklmnopqrstuvwxyz"
+            "\xE2\x82\xAC\"");
+  EXPECT_EQ(parseOk(json.serialize()), json);
+}
+
+TEST(Serialize, EscapeKey) {
+  std::unordered_map<std::string, Json> obj;
+  obj.insert({"say \"hi\"\n", Json(1)});
+  Json json(obj);
+  std::string out = json.serialize();
+  EXPECT_EQ(out, "{\"say \\\"hi\\\"\\n\":1}");
+  EXPECT_EQ(parseOk(out), json);
+}
+
+TEST(Serialize, Pretty) {
+  Json json = parseOk("{\"b\":[1,[],{}],\"a\":{\"c\":null}}");
+  WriterOptions opts;
+  opts.pretty = true;
+  opts.indent = 2;
+  opts.sortKeys = true;
+  EXPECT_EQ(json.serialize(opts),
+            "{\n"
+            "  \"a\": {\n"
+            "    \"c\": null\n"
+            "  },\n"
+            "  \"b\": [\n"
+            "    1,\n"
+            "    [],\n"
+            "    {}\n"
+            "  ]\n"
+            "}");
+  EXPECT_EQ(parseOk(json.serialize(opts)), json);
+  opts.pretty = false;
+  EXPECT_EQ(json.serialize(opts), "{\"a\":{\"c\":null},\"b\":[1,[],{}]}");
+}
+
+TEST(Serialize, AsciiOnly) {
+  WriterOptions opts;
+  opts.asciiOnly = true;
+  Json json("a\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E\xFFz");
+  EXPECT_EQ(json.serialize(opts), "\"a\\u00A2\\u20AC\\uD834\\uDD1E\\uFFFDz\"");
+  EXPECT_EQ(parseOk("\"\\u00A2\\u20AC\\uD834\\uDD1E\"").toString(),
+            "\xC2\xA2\xE2\x82\xAC\xF0\x9D\x84\x9E");
+}
+
+namespace bindtest {
+
+struct Point {
+  double x = 0;
+  double y = 0;
+};
+ZZJSON_BIND(Point, x, y)
+
+struct Person {
+  std::string name;
+  int age = 0;
+  long long id = 0;
+  bool active = false;
+  std::vector<double> scores;
+  std::optional<std::string> nick;
+  Point pos;
+  std::vector<Point> path;
+  Json extra;
+};
+ZZJSON_BIND(Person, name, age, id, active, scores, nick, pos, path, extra)
+
+struct Counters {
+  std::vector<bool> flags;
+  uint64_t total = 0;
+  uint8_t small = 0;
+};
+ZZJSON_BIND(Counters, flags, total, small)
+
+}  // namespace bindtest
+
+TEST(Bind, FromJson) {
+  using namespace bindtest;
+  EXPECT_TRUE(bind_detail::Bound<Person>::table.perfect);
+  Person p;
+  std::string errMsg;
+  EXPECT_TRUE(fromJson(
+      " { \"name\" : \"Tom \\\"T\\\"\", \"age\": 30, \"id\": 9007199254740993,"
+      " \"unknown\": { \"a\": [ 1, \"x\" ] }, \"active\": true,"
+      " \"scores\": [ 1.5, -2 ], \"nick\": null, \"pos\": { \"x\": 1, \"y\": 2 },"
+      " \"path\": [ { \"y\": 3 }, {} ], \"extra\": [ null, { \"k\": \"v\" } ] } ",
+      p, errMsg));
+  EXPECT_EQ(errMsg, "");
+  EXPECT_EQ(p.name, "Tom \"T\"");
+  EXPECT_EQ(p.age, 30);
+  EXPECT_EQ(p.id, 9007199254740993LL);
+  EXPECT_TRUE(p.active);
+  EXPECT_EQ(p.scores, std::vector<double>({1.5, -2}));
+  EXPECT_FALSE(p.nick);
+  EXPECT_EQ(p.pos.x, 1);
+  EXPECT_EQ(p.pos.y, 2);
+  EXPECT_EQ(p.path.size(), 2);
+  EXPECT_EQ(p.path[0].y, 3);
+  EXPECT_EQ(p.extra, parseOk("[null,{\"k\":\"v\"}]"));
+
+  // 序列化之后再解析回来
+  p.nick = "tommy";
+  Person q;
+  EXPECT_TRUE(fromJson(toJson(p), q, errMsg));
+  EXPECT_EQ(toJson(q), toJson(p));
+  EXPECT_EQ(parseOk(toJson(p)), parseOk(toJson(q)));
+  WriterOptions pretty;
+  pretty.pretty = true;
+  EXPECT_EQ(parseOk(toJson(p, pretty)), parseOk(toJson(p)));
+  EXPECT_EQ(toJson(Point{1, 2.5}), "{\"x\":1,\"y\":2.5}");
+}
+
+TEST(Bind, Error) {
+  using namespace bindtest;
+  Person p;
+  std::string errMsg;
+  EXPECT_FALSE(fromJson("{\"age\":\"30\"}", p, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "TYPE MISMATCH");
+  EXPECT_FALSE(fromJson("{\"age\":1.5}", p, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "TYPE MISMATCH");
+  EXPECT_FALSE(fromJson("{\"age\":3000000000}", p, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "NUMBER TOO BIG");
+  EXPECT_FALSE(fromJson("{\"pos\":[1,2]}", p, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "TYPE MISMATCH");
+  EXPECT_FALSE(fromJson("{\"name\":\"a\" \"age\":1}", p, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "MISS COMMA OR CURLY BRACKET");
+  EXPECT_FALSE(fromJson("{\"unknown\":[1,}", p, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "INVALID VALUE");
+  EXPECT_FALSE(fromJson("{} x", p, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "ROOT NOT SINGULAR");
+}
+
+TEST(Bind, UnsignedAndBoolVector) {
+  using namespace bindtest;
+  Counters c;
+  std::string errMsg;
+  ASSERT_TRUE(fromJson("{\"flags\":[true,false,true],\"total\":18446744073709551615,"
+                       "\"small\":255}", c, errMsg)) << errMsg;
+  EXPECT_EQ(c.flags, std::vector<bool>({true, false, true}));
+  EXPECT_EQ(c.total, 18446744073709551615ULL);
+  EXPECT_EQ(c.small, 255);
+  EXPECT_EQ(toJson(c), "{\"flags\":[true,false,true],\"total\":18446744073709551615,"
+                       "\"small\":255}");
+  ASSERT_TRUE(fromJson("{\"total\":9223372036854775808,\"small\":-0}", c, errMsg));
+  EXPECT_EQ(c.total, 9223372036854775808ULL);
+  EXPECT_EQ(c.small, 0);
+  ASSERT_TRUE(fromJson("{\"total\":1e3}", c, errMsg));
+  EXPECT_EQ(c.total, 1000u);
+
+  for (const char* bad : {"{\"total\":18446744073709551616}", "{\"total\":-1}",
+                          "{\"small\":256}", "{\"total\":1e20}"}) {
+    EXPECT_FALSE(fromJson(bad, c, errMsg)) << bad;
+    EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "NUMBER TOO BIG") << bad;
+  }
+  EXPECT_FALSE(fromJson("{\"total\":1.5}", c, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "TYPE MISMATCH");
+}
+
+TEST(MsgPack, RoundTrip) {
+  const char* docs[] = {
+      "null", "true", "false", "0", "-0", "1", "127", "128", "255", "256",
+      "65535", "65536", "4294967296", "-1", "-32", "-33", "-128", "-129",
+      "-32768", "-32769", "-2147483649", "1.5", "0.1", "-1e300",
+      "1.7976931348623157e+308", "\"\"", "\"0123456789012345678901234567890\"",
+      "[]", "{}", "[null,false,true,123,\"abc\",[1,2,3]]",
+      "{\"a\":{\"b\":[1,{\"c\":\"d\"}]},\"e\":-1.25}"};
+  for (auto doc : docs) {
+    Json json = parseOk(doc);
+    std::string errMsg;
+    Json decoded = Json::fromMsgPack(json.toMsgPack(), errMsg);
+    EXPECT_EQ(errMsg, "");
+    EXPECT_EQ(decoded, json) << doc;
+    if (json.isNumber()) {
+      EXPECT_EQ(std::signbit(decoded.toDouble()), std::signbit(json.toDouble()));
+    }
+  }
+  // 超过 16 位长度的容器和字符串
+  Json::_array arr(70000, Json(1));
+  std::string errMsg;
+  EXPECT_EQ(Json::fromMsgPack(Json(arr).toMsgPack(), errMsg), Json(arr));
+  std::string big(70000, 'x');
+  EXPECT_EQ(Json::fromMsgPack(Json(big).toMsgPack(), errMsg), Json(big));
+}
+
+TEST(MsgPack, Encoding) {
+  EXPECT_EQ(Json(nullptr).toMsgPack(), "\xc0");
+  EXPECT_EQ(Json(true).toMsgPack(), "\xc3");
+  EXPECT_EQ(Json(5).toMsgPack(), "\x05");
+  EXPECT_EQ(Json(-1).toMsgPack(), "\xff");
+  EXPECT_EQ(Json(300).toMsgPack(), std::string("\xcd\x01\x2c", 3));
+  EXPECT_EQ(Json(1.5).toMsgPack(), std::string("\xca\x3f\xc0\x00\x00", 5));
+  EXPECT_EQ(Json("ab").toMsgPack(), "\xa2" "ab");
+  EXPECT_EQ(parseOk("[1,2]").toMsgPack(), "\x92\x01\x02");
+  EXPECT_EQ(parseOk("{\"a\":1}").toMsgPack(), "\x81\xa1\x61\x01");
+}
+
+TEST(MsgPack, Error) {
+  std::string errMsg;
+  Json::fromMsgPack("", errMsg);
+  EXPECT_EQ(errMsg, "MSGPACK TRUNCATED: offset 0");
+  Json::fromMsgPack("\x92\x01", errMsg);
+  EXPECT_EQ(errMsg, "MSGPACK TRUNCATED: offset 2");
+  Json::fromMsgPack("\xa3" "ab", errMsg);
+  EXPECT_EQ(errMsg, "MSGPACK TRUNCATED: offset 1");
+  Json::fromMsgPack("\x81\x01\x01", errMsg);
+  EXPECT_EQ(errMsg, "MSGPACK KEY NOT STRING: offset 1");
+  Json::fromMsgPack("\xc4\x00", errMsg);
+  EXPECT_EQ(errMsg, "INVALID MSGPACK TYPE: offset 0");
+  Json::fromMsgPack("\xc0\xc0", errMsg);
+  EXPECT_EQ(errMsg, "ROOT NOT SINGULAR: offset 1");
+  // 长度前缀远大于实际数据时不会按前缀 reserve
+  Json::fromMsgPack(std::string("\xdd\xff\xff\xff\xff\x01", 6), errMsg);
+  EXPECT_EQ(errMsg, "MSGPACK TRUNCATED: offset 6");
+  // 深层嵌套报错而不是耗尽调用栈
+  std::string deep(1000000, '\x91');
+  deep += '\xc0';
+  Json::fromMsgPack(deep, errMsg);
+  EXPECT_EQ(errMsg, "MSGPACK TOO DEEP: offset 1001");
+  deep.clear();
+  for (int i = 0; i != 1500; ++i) deep += "\x81\xa1k";
+  deep += '\xc0';
+  errMsg.clear();
+  Json::fromMsgPack(deep, errMsg);
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "MSGPACK TOO DEEP");
+  std::string ok(1000, '\x91');
+  ok += '\xc0';
+  errMsg.clear();
+  Json okJson = Json::fromMsgPack(ok, errMsg);
+  EXPECT_EQ(errMsg, "");
+  EXPECT_EQ(okJson.toMsgPack(), ok);
+}
+
+TEST(Snapshot, RoundTrip) {
+  const char* docs[] = {
+      "null", "true", "false", "0", "-0", "-1", "2147483647", "2147483648",
+      "-2147483649", "1.5", "1e300", "\"\"", "\"abc\\u0000def\"", "[]", "{}",
+      "[null,false,true,123,\"abc\",[1,2,3]]",
+      "{\"a\":{\"b\":[1,{\"c\":\"d\"}]},\"e\":-1.25,\"\":[{}],\"f\":\"g\"}"};
+  for (auto doc : docs) {
+    Json json = parseOk(doc);
+    std::string errMsg;
+    auto snap = Snapshot::fromBuffer(Snapshot::write(json), errMsg, true);
+    ASSERT_TRUE(snap) << errMsg;
+    EXPECT_EQ(snap->root().toJson(), json) << doc;
+  }
+}
+
+TEST(Snapshot, Query) {
+  Json json = parseOk(
+      "{\"name\":\"zz\",\"n\":1.25,\"list\":[1,\"two\",{\"k\":true}],"
+      "\"nested\":{\"a\":{\"b\":null}}}");
+  std::string path = testing::TempDir() + "zzjson_snapshot_test.bin";
+  std::string errMsg;
+  ASSERT_TRUE(Snapshot::save(json, path, errMsg)) << errMsg;
+  auto snap = Snapshot::open(path, errMsg);
+  ASSERT_TRUE(snap) << errMsg;
+  SnapshotValue root = snap->root();
+  EXPECT_TRUE(root.isObject());
+  EXPECT_EQ(root.size(), 4);
+  EXPECT_EQ(root["name"].toString(), "zz");
+  EXPECT_EQ(root["n"].toDouble(), 1.25);
+  EXPECT_EQ(root["list"].size(), 3);
+  EXPECT_EQ(root["list"][1].toString(), "two");
+  EXPECT_TRUE(root["list"][2]["k"].toBool());
+  EXPECT_TRUE(root["nested"]["a"]["b"].isNull());
+  EXPECT_FALSE(root.find("missing"));
+  EXPECT_FALSE(root["list"].find("k"));
+  EXPECT_THROW(root["missing"], JsonExcept);
+  EXPECT_THROW(root["list"][3], JsonExcept);
+  EXPECT_THROW(root["name"].toDouble(), JsonExcept);
+  EXPECT_EQ(root.toJson(), json);
+
+  // 移动之后视图依然有效
+  Snapshot moved = std::move(*snap);
+  EXPECT_EQ(moved.root()["name"].toString(), "zz");
+  unlink(path.c_str());
+}
+
+TEST(Snapshot, Invalid) {
+  std::string errMsg;
+  EXPECT_FALSE(Snapshot::fromBuffer("not a snapshot at all!!!!", errMsg));
+  EXPECT_EQ(errMsg, "INVALID SNAPSHOT: bad header");
+  std::string data = Snapshot::write(parseOk("[\"abc\",[1,2]]"));
+  data[40] = 100;  // 破坏第二个元素的类型
+  EXPECT_FALSE(Snapshot::fromBuffer(data, errMsg, true));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "INVALID SNAPSHOT");
+
+  // 数组的唯一元素指回自己：检查时报错而不是无限递归
+  std::string cyclic = Snapshot::write(parseOk("[0]"));
+  ASSERT_EQ(cyclic.size(), 40u);
+  const uint32_t ref[2] = {6, 24};   // {kArray, 根数组的偏移量}
+  memcpy(&cyclic[32], ref, sizeof(ref));
+  EXPECT_FALSE(Snapshot::fromBuffer(cyclic, errMsg, true));
+  EXPECT_EQ(errMsg, "INVALID SNAPSHOT: offset 24");
+
+  // 两个元素引用同一个子数组 (可以指数级展开的 DAG) 同样拒绝
+  std::string shared = Snapshot::write(parseOk("[[1],[2]]"));
+  memcpy(&shared[40], &shared[32], 8);
+  EXPECT_FALSE(Snapshot::fromBuffer(shared, errMsg, true));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "INVALID SNAPSHOT");
+
+  std::string deep(1001, '[');
+  deep += std::string(1001, ']');
+  EXPECT_FALSE(Snapshot::fromBuffer(Snapshot::write(parseOk(deep)), errMsg, true));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "SNAPSHOT TOO DEEP");
+  deep = deep.substr(1, 2000);
+  auto ok = Snapshot::fromBuffer(Snapshot::write(parseOk(deep)), errMsg, true);
+  ASSERT_TRUE(ok) << errMsg;
+  EXPECT_EQ(ok->root().toJson(), parseOk(deep));
+
+  EXPECT_FALSE(Snapshot::open("/nonexistent/zzjson.bin", errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "OPEN SNAPSHOT FAILED");
+}
+
+TEST(Path, Pointer) {
+  // RFC 6901 第 5 节的示例
+  Json doc = parseOk(
+      "{\"foo\":[\"bar\",\"baz\"],\"\":0,\"a/b\":1,\"c%d\":2,\"e^f\":3,"
+      "\"g|h\":4,\"i\\\\j\":5,\"k\\\"l\":6,\" \":7,\"m~n\":8}");
+  std::string errMsg;
+  auto get = [&](const char* text) {
+    auto ptr = JsonPointer::compile(text, errMsg);
+    EXPECT_TRUE(ptr) << text;
+    return ptr ? ptr->find(doc) : nullptr;
+  };
+  EXPECT_EQ(get(""), &doc);
+  EXPECT_EQ(*get("/foo"), parseOk("[\"bar\",\"baz\"]"));
+  EXPECT_EQ(get("/foo/0")->toString(), "bar");
+  EXPECT_EQ(get("/")->toDouble(), 0);
+  EXPECT_EQ(get("/a~1b")->toDouble(), 1);
+  EXPECT_EQ(get("/c%d")->toDouble(), 2);
+  EXPECT_EQ(get("/e^f")->toDouble(), 3);
+  EXPECT_EQ(get("/g|h")->toDouble(), 4);
+  EXPECT_EQ(get("/i\\j")->toDouble(), 5);
+  EXPECT_EQ(get("/k\"l")->toDouble(), 6);
+  EXPECT_EQ(get("/ ")->toDouble(), 7);
+  EXPECT_EQ(get("/m~0n")->toDouble(), 8);
+
+  EXPECT_EQ(get("/foo/2"), nullptr);
+  EXPECT_EQ(get("/foo/-"), nullptr);
+  EXPECT_EQ(get("/foo/01"), nullptr);
+  EXPECT_EQ(get("/foo/0/x"), nullptr);
+  EXPECT_EQ(get("/missing"), nullptr);
+
+  EXPECT_FALSE(JsonPointer::compile("foo", errMsg));
+  EXPECT_EQ(errMsg, "INVALID POINTER: foo");
+  EXPECT_FALSE(JsonPointer::compile("/a~2b", errMsg));
+  EXPECT_EQ(errMsg, "INVALID POINTER ESCAPE: ~2b");
+
+  // 通过指针修改
+  auto ptr = JsonPointer::compile("/foo/1", errMsg);
+  *ptr->find(doc) = Json("qux");
+  EXPECT_EQ(doc["foo"][1].toString(), "qux");
+
+  // 快照上使用预先计算的哈希
+  auto snap = Snapshot::fromBuffer(Snapshot::write(doc), errMsg);
+  ASSERT_TRUE(snap);
+  auto val = JsonPointer::compile("/m~0n", errMsg)->find(snap->root());
+  ASSERT_TRUE(val);
+  EXPECT_EQ(val->toDouble(), 8);
+  EXPECT_EQ(ptr->find(snap->root())->toString(), "qux");
+  EXPECT_FALSE(JsonPointer::compile("/foo/5", errMsg)->find(snap->root()));
+}
+
+TEST(Path, JsonPath) {
+  Json doc = parseOk(
+      "{\"store\":{\"book\":["
+      "{\"title\":\"A\",\"price\":8},"
+      "{\"title\":\"B\",\"price\":12},"
+      "{\"title\":\"C\",\"price\":9,\"isbn\":\"x\"},"
+      "{\"title\":\"D\",\"price\":22}],"
+      "\"bicycle\":{\"price\":19}}}");
+  std::string errMsg;
+  auto titles = [&](const char* text) {
+    auto path = JsonPath::compile(text, errMsg);
+    EXPECT_TRUE(path) << text << " " << errMsg;
+    std::string res;
+    if (path) {
+      for (const Json* val : path->select(doc)) res += val->toString();
+    }
+    return res;
+  };
+  EXPECT_EQ(titles("$.store.book[*].title"), "ABCD");
+  EXPECT_EQ(titles("$['store'][\"book\"][0].title"), "A");
+  EXPECT_EQ(titles("$.store.book[-1].title"), "D");
+  EXPECT_EQ(titles("$.store.book[1:3].title"), "BC");
+  EXPECT_EQ(titles("$.store.book[:2].title"), "AB");
+  EXPECT_EQ(titles("$.store.book[-2:].title"), "CD");
+  EXPECT_EQ(titles("$.store.book[::2].title"), "AC");
+  EXPECT_EQ(titles("$.store.book[::-1].title"), "DCBA");
+  EXPECT_EQ(titles("$.store.book[5].title"), "");
+  EXPECT_EQ(titles("$..book[2].title"), "C");
+  EXPECT_EQ(titles("$..title"), "ABCD");
+
+  auto prices = JsonPath::compile("$..price", errMsg);
+  ASSERT_TRUE(prices);
+  double sum = 0;
+  for (const Json* val : prices->select(doc)) sum += val->toDouble();
+  EXPECT_EQ(sum, 8 + 12 + 9 + 22 + 19);
+  EXPECT_EQ(JsonPath::compile("$..isbn", errMsg)->first(doc)->toString(), "x");
+  EXPECT_EQ(JsonPath::compile("$.nothing", errMsg)->first(doc), nullptr);
+  EXPECT_EQ(JsonPath::compile("$", errMsg)->first(doc), &doc);
+  EXPECT_EQ(JsonPath::compile("$.store.*", errMsg)->select(doc).size(), 2);
+
+  EXPECT_FALSE(JsonPath::compile("store", errMsg));
+  EXPECT_EQ(errMsg, "INVALID PATH: store");
+  EXPECT_FALSE(JsonPath::compile("$.store[", errMsg));
+  EXPECT_EQ(errMsg, "INVALID PATH: ");
+  EXPECT_FALSE(JsonPath::compile("$.book[::0]", errMsg));
+  EXPECT_FALSE(JsonPath::compile("$.book['x]", errMsg));
+  EXPECT_FALSE(JsonPath::compile("$.", errMsg));
+}
+
+TEST(Stream, Extract) {
+  std::string errMsg;
+  StreamExtractor ex;
+  auto addPath = [&](const char* text) {
+    auto path = JsonPath::compile(text, errMsg);
+    auto id = ex.add(*path, errMsg);
+    EXPECT_TRUE(id) << text << " " << errMsg;
+    return id ? *id : 0;
+  };
+  size_t user = addPath("$.request.user.id");
+  size_t latency = addPath("$.latency_ms");
+  size_t tags = addPath("$.tags[*]");
+  size_t second = ex.add(*JsonPointer::compile("/tags/1", errMsg));
+  size_t request = ex.add(*JsonPointer::compile("/request", errMsg));
+  EXPECT_EQ(ex.size(), 5);
+
+  std::string doc =
+      "{\"skip\":{\"request\":{\"user\":{\"id\":0}}},"
+      "\"request\":{\"path\":\"/\",\"user\":{\"id\":42,\"name\":\"zz\"}},"
+      "\"tags\":[\"a\",\"b\",[1,{}]],\"latency_ms\":12.5}";
+  std::vector<std::pair<size_t, Json>> matches;
+  ASSERT_TRUE(ex.extract(doc, [&](size_t path, Json& val) {
+    matches.push_back({path, std::move(val)});
+  }, errMsg));
+  std::stable_sort(matches.begin(), matches.end(),
+            [](auto& a, auto& b) { return a.first < b.first; });
+  ASSERT_EQ(matches.size(), 7);
+  EXPECT_EQ(matches[0].first, user);
+  EXPECT_EQ(matches[0].second.toDouble(), 42);
+  EXPECT_EQ(matches[1].first, latency);
+  EXPECT_EQ(matches[1].second.toDouble(), 12.5);
+  EXPECT_EQ(matches[2].first, tags);
+  EXPECT_EQ(matches[4].first, tags);
+  EXPECT_EQ(matches[4].second, parseOk("[1,{}]"));
+  EXPECT_EQ(matches[5].first, second);
+  EXPECT_EQ(matches[5].second.toString(), "b");
+  EXPECT_EQ(matches[6].first, request);
+  EXPECT_EQ(matches[6].second["user"]["name"].toString(), "zz");
+
+  // slots 只保留第一个匹配
+  StreamExtractor::Slots slots;
+  ASSERT_TRUE(ex.extract(doc, slots, errMsg));
+  ASSERT_EQ(slots.size(), 5);
+  EXPECT_EQ(slots[tags]->toString(), "a");
+  EXPECT_EQ(slots[user]->toDouble(), 42);
+  ASSERT_TRUE(ex.extract("{\"latency_ms\":1}", slots, errMsg));
+  EXPECT_FALSE(slots[user]);
+  EXPECT_EQ(slots[latency]->toDouble(), 1);
+
+  // 未匹配的部分仍然要检查语法
+  EXPECT_FALSE(ex.extract("{\"other\":[1,2,}", slots, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "INVALID VALUE");
+  EXPECT_FALSE(ex.extract("{\"latency_ms\":1} x", slots, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "ROOT NOT SINGULAR");
+
+  EXPECT_FALSE(ex.add(*JsonPath::compile("$..id", errMsg), errMsg));
+  EXPECT_EQ(errMsg, "UNSUPPORTED PATH: recursive descent");
+  EXPECT_FALSE(ex.add(*JsonPath::compile("$.tags[-1]", errMsg), errMsg));
+  EXPECT_EQ(errMsg, "UNSUPPORTED PATH: negative index");
+}
+
+TEST(Stream, Lines) {
+  std::string errMsg;
+  StreamExtractor ex;
+  ex.add(*JsonPointer::compile("/id", errMsg));
+  ex.add(*JsonPath::compile("$.items[1:]", errMsg), errMsg);
+  std::string lines =
+      "{\"id\":1,\"items\":[1,2,3]}\n"
+      "\n"
+      "{\"items\":[],\"id\":\"two\"}\r\n"
+      "{\"id\":3}\n";
+  StreamExtractor::Slots slots;
+  std::vector<std::string> ids;
+  size_t items = 0;
+  ASSERT_TRUE(ex.extractLines(lines, slots, [&](size_t record) {
+    EXPECT_EQ(record, ids.size());
+    ids.push_back(slots[0]->serialize());
+    if (slots[1]) ++items;
+  }, errMsg));
+  EXPECT_EQ(ids, (std::vector<std::string>{"1", "\"two\"", "3"}));
+  EXPECT_EQ(items, 1);
+
+  size_t records = 0;
+  EXPECT_FALSE(ex.extractLines("{\"id\":1}\n{\"id\" 2}\n{\"id\":3}\n", slots,
+                               [&](size_t) { ++records; }, errMsg));
+  EXPECT_EQ(records, 1);
+  EXPECT_EQ(errMsg, "MISS COLON: 2} (record 1)");
+}
+
+Json parsePacked(const std::string& strJson) {
+  std::string errMsg;
+  ParseOptions opts;
+  opts.packArrays = true;
+  Json json = Json::parse(strJson, errMsg, opts);
+  EXPECT_EQ(errMsg, "");
+  return json;
+}
+
+TEST(Packed, Numbers) {
+  const Json json = parsePacked("[1, 2.5 ,-3e2]");
+  ASSERT_TRUE(json.isPacked());
+  EXPECT_TRUE(json.isArray());
+  EXPECT_EQ(json.size(), 3);
+  auto numbers = json.numbers();
+  EXPECT_EQ(std::vector<double>(numbers.begin(), numbers.end()),
+            (std::vector<double>{1, 2.5, -300}));
+  EXPECT_TRUE(json.bools().empty());
+  EXPECT_EQ(json[1].toDouble(), 2.5);
+  EXPECT_EQ(json.toArray().size(), 3);
+  EXPECT_EQ(json.serialize(), "[1,2.5,-300]");
+  EXPECT_EQ(json, parseOk("[1,2.5,-300]"));
+  EXPECT_EQ(parseOk("[1,2.5,-300]"), json);
+
+  Json copy = json;
+  EXPECT_TRUE(copy.isPacked());
+  EXPECT_EQ(copy, json);
+
+  // 非 const 的访问会转换回普通的数组
+  copy[0] = Json("x");
+  EXPECT_FALSE(copy.isPacked());
+  EXPECT_EQ(copy.serialize(), "[\"x\",2.5,-300]");
+  EXPECT_NE(copy, json);
+
+  Json nested = parsePacked("{\"a\":[[1,2],[3]],\"b\":[]}");
+  EXPECT_FALSE(nested["a"].isPacked());
+  EXPECT_TRUE(nested["a"][0].isPacked());
+  EXPECT_FALSE(nested["b"].isPacked());
+  EXPECT_EQ(nested["a"][1].numbers()[0], 3);
+
+  Json built = Json::packNumbers({0.5, 1});
+  EXPECT_EQ(built, parseOk("[0.5,1]"));
+}
+
+TEST(Packed, BoolsAndMixed) {
+  Json json = parsePacked("[true,false , true]");
+  ASSERT_TRUE(json.isPacked());
+  auto bools = json.bools();
+  EXPECT_EQ(std::vector<uint8_t>(bools.begin(), bools.end()),
+            (std::vector<uint8_t>{1, 0, 1}));
+  EXPECT_TRUE(json.numbers().empty());
+  EXPECT_FALSE(json[1].toBool());
+  EXPECT_EQ(json.serialize(), "[true,false,true]");
+  EXPECT_EQ(json, Json::packBools({1, 0, 1}));
+  EXPECT_NE(json, parsePacked("[1,0,1]"));
+
+  // 类型混合的数组在遇到其他类型时转换为普通数组
+  for (const char* text :
+       {"[1,2,\"x\",3]", "[true,false,1]", "[1,true]", "[null,1,2]"}) {
+    Json mixed = parsePacked(text);
+    EXPECT_FALSE(mixed.isPacked()) << text;
+    EXPECT_EQ(mixed, parseOk(text)) << text;
+  }
+
+  // 错误的类型和位置与普通的解析相同
+  ParseOptions opts;
+  opts.packArrays = true;
+  for (const char* text : {"[1,]", "[1 2]", "[true,fals]", "[true x]", "[1,2"}) {
+    std::string packedErr, plainErr;
+    Json::parse(text, packedErr, opts);
+    Json::parse(text, plainErr);
+    EXPECT_EQ(packedErr, plainErr) << text;
+    EXPECT_NE(packedErr, "") << text;
+  }
+}
+
+TEST(Packed, EncodeWithoutBoxing) {
+  ParseOptions opts;
+  opts.packArrays = true;
+  std::string errMsg;
+  const char* text = "{\"n\":[1,2.5,-3,1e300],\"b\":[true,false]}";
+  const Json packed = Json::parse(text, errMsg, opts);
+  const Json plain = parseOk(text);
+  size_t before = packed.memoryUsage().packed;
+
+  EXPECT_EQ(packed.toMsgPack(), plain.toMsgPack());
+  EXPECT_EQ(Snapshot::write(packed), Snapshot::write(plain));
+  auto frozen = Snapshot::freeze(packed, errMsg);
+  ASSERT_TRUE(frozen) << errMsg;
+  EXPECT_EQ(frozen->root().toJson(), plain);
+  // 编码不会生成 boxed 副本
+  EXPECT_EQ(packed.memoryUsage().packed, before);
+}
+
+TEST(Packed, CopyAndCompareWithoutBoxing) {
+  for (const char* text : {"[1,2.5,-3]", "{\"n\":[1,2.5,-3],\"b\":[true,false]}"}) {
+    const Json packed = parsePacked(text);
+    size_t before = packed.memoryUsage().packed;
+    Json copy(packed);
+    EXPECT_TRUE(copy == packed);
+    EXPECT_TRUE(packed == copy);
+    EXPECT_EQ(packed, parseOk(text));
+    EXPECT_EQ(packed.memoryUsage().packed, before);
+    EXPECT_LE(copy.memoryUsage().packed, before);
+  }
+
+  // 游标在读取元素时才生成 boxed 副本
+  const Json packed = parsePacked("[1,2]");
+  size_t before = packed.memoryUsage().packed;
+  JsonCursor cur(packed);
+  ASSERT_TRUE(cur.next());
+  EXPECT_EQ(cur.kind(), WalkKind::kEnter);
+  EXPECT_EQ(packed.memoryUsage().packed, before);
+  ASSERT_TRUE(cur.next());
+  EXPECT_EQ(cur.value().toDouble(), 1);
+  EXPECT_GT(packed.memoryUsage().packed, before);
+}
+
+TEST(Packed, ConcurrentBoxing) {
+  const Json json = parsePacked("[1,2,3,4,5,6,7,8]");
+  std::vector<const Json*> seen(8);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i != seen.size(); ++i) {
+    threads.emplace_back([&, i] { seen[i] = &json[0]; });
+  }
+  for (auto& t : threads) t.join();
+  // 所有线程看到的是同一份 boxed 副本
+  for (const Json* p : seen) EXPECT_EQ(p, seen[0]);
+  EXPECT_EQ(seen[0]->toDouble(), 1);
+  EXPECT_TRUE(json.isPacked());
+}
+
+TEST(Columns, Read) {
+  std::string text =
+      "[{\"id\":1,\"name\":\"a\",\"score\":1.5,\"ok\":true,\"extra\":[1,{}]},"
+      "{\"name\":\"b\\n\",\"id\":2.5,\"score\":\"bad\",\"ok\":null},"
+      "{\"id\":-9007199254740993,\"id\":7,\"score\":-2},"
+      "42,"
+      "{}]";
+  ColumnReader reader({{"id", ColumnType::kInt64},
+                       {"name", ColumnType::kString},
+                       {"score", ColumnType::kDouble},
+                       {"ok", ColumnType::kBool}});
+  std::string errMsg;
+  ColumnTable fromText, fromDom;
+  ASSERT_TRUE(reader.parse(text, fromText, errMsg)) << errMsg;
+  ASSERT_TRUE(reader.read(parseOk(text), fromDom, errMsg)) << errMsg;
+
+  for (ColumnTable* table : {&fromText, &fromDom}) {
+    ASSERT_EQ(table->rows, 5);
+    const Column* id = table->find("id");
+    const Column* name = table->find("name");
+    const Column* score = table->find("score");
+    const Column* ok = table->find("ok");
+    ASSERT_TRUE(id && name && score && ok);
+    EXPECT_EQ(table->find("missing"), nullptr);
+
+    EXPECT_TRUE(id->valid(0));
+    EXPECT_EQ(id->ints[0], 1);
+    EXPECT_FALSE(id->valid(1));  // 不是整数
+    EXPECT_TRUE(id->valid(2));
+    EXPECT_FALSE(id->valid(3));  // 不是对象
+    EXPECT_FALSE(id->valid(4));
+    EXPECT_EQ(id->nullCount, 3);
+
+    EXPECT_EQ(name->stringAt(0), "a");
+    EXPECT_EQ(name->stringAt(1), "b\n");
+    EXPECT_EQ(name->stringAt(2), "");
+    EXPECT_FALSE(name->valid(2));
+    EXPECT_EQ(name->bytes, "ab\n");
+    EXPECT_EQ(name->offsets.size(), 6);
+
+    EXPECT_EQ(score->doubles[0], 1.5);
+    EXPECT_FALSE(score->valid(1));
+    EXPECT_EQ(score->doubles[2], -2);
+
+    EXPECT_TRUE(ok->valid(0));
+    EXPECT_TRUE(ok->bools[0]);
+    EXPECT_FALSE(ok->valid(1));
+    EXPECT_EQ(ok->nullCount, 4);
+  }
+  // 重复的 key 取第一个；超出 double 精度的整数只有从文本中提取时是精确的
+  EXPECT_EQ(fromText.find("id")->ints[2], -9007199254740993LL);
+  EXPECT_EQ(fromDom.find("id")->ints[2], -9007199254740992LL);
+
+  EXPECT_FALSE(reader.parse("{\"id\":1}", fromText, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "TYPE MISMATCH");
+  EXPECT_FALSE(reader.parse("[{\"id\":1},{\"skip\":[1,}]", fromText, errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "INVALID VALUE");
+  EXPECT_FALSE(reader.read(parseOk("{}"), fromDom, errMsg));
+  EXPECT_EQ(errMsg, "Error! Not a array!");
+}
+
+TEST(Parallel, SameAsSerialize) {
+  std::string text = "{\"meta\":{\"name\":\"caf\\u00e9\",\"tags\":[]},\"data\":[";
+  for (int i = 0; i != 300; ++i) {
+    text += (i ? "," : "") + std::string("{\"id\":") + std::to_string(i) +
+            ",\"v\":[" + std::to_string(i * 0.5) + ",null,\"s\"],\"o\":{}}";
+  }
+  text += "],\"map\":{";
+  for (int i = 0; i != 100; ++i) {
+    text += (i ? "," : "") + std::string("\"k") + std::to_string(i) + "\":[" +
+            std::to_string(i) + "]";
+  }
+  text += "},\"packed\":[1,2,3]}";
+  ParseOptions popts;
+  popts.packArrays = true;
+  std::string errMsg;
+  Json json = Json::parse(text, errMsg, popts);
+  ASSERT_EQ(errMsg, "");
+
+  WriterOptions pretty, sorted, ascii;
+  pretty.pretty = true;
+  pretty.indent = 2;
+  sorted.sortKeys = true;
+  sorted.pretty = true;
+  ascii.asciiOnly = true;
+  for (const WriterOptions& opts : {WriterOptions(), pretty, sorted, ascii}) {
+    std::string expect = json.serialize(opts);
+    for (unsigned threads : {1u, 2u, 3u, 8u}) {
+      for (size_t minSplit : {size_t(1), size_t(16), size_t(1024)}) {
+        ParallelOptions par;
+        par.threads = threads;
+        par.minSplit = minSplit;
+        EXPECT_EQ(serializeParallel(json, opts, par), expect)
+            << threads << " threads, minSplit " << minSplit;
+      }
+    }
+  }
+  // 标量和空容器
+  for (const char* str : {"1", "\"s\"", "[]", "{}", "[[]]"}) {
+    Json val = parseOk(str);
+    EXPECT_EQ(serializeParallel(val, pretty, {4, 1}), val.serialize(pretty));
+  }
+}
+
+TEST(Parallel, Write) {
+  Json::_array arr;
+  for (int i = 0; i != 5000; ++i) arr.push_back(Json::_obj{{"i", i}});
+  Json json(std::move(arr));
+  std::string expect = json.serialize();
+
+  FILE* file = tmpfile();
+  ASSERT_NE(file, nullptr);
+  std::string errMsg;
+  ASSERT_TRUE(writeParallel(fileno(file), json, errMsg, {}, {4, 16})) << errMsg;
+  rewind(file);
+  std::string content(expect.size() + 1, '\0');
+  content.resize(fread(&content[0], 1, content.size(), file));
+  fclose(file);
+  EXPECT_EQ(content, expect);
+
+  EXPECT_FALSE(writeParallel(-1, json, errMsg, {}, {4, 16}));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "WRITE FAILED");
+}
+
+TEST(ParseContext, Reuse) {
+  auto record = [](int i) {
+    return "{\"id\":" + std::to_string(i) + ",\"name\":\"a rather long user name " +
+           std::to_string(i % 10) + "\",\"tags\":[\"x\",\"y\\n\",\"z\"],"
+           "\"nested\":{\"ratio\":1.5e-3,\"empty\":{},\"ok\":true,\"none\":null}}";
+  };
+  std::vector<std::string> docs;
+  for (int i = 0; i != 8; ++i) docs.push_back(record(i));
+
+  ParseContext ctx;
+  std::string errMsg;
+  ASSERT_TRUE(ctx.parse(docs[0], errMsg)) << errMsg;
+  EXPECT_EQ(ctx.root(), parseOk(docs[0]));
+  // 预热之后，结构相同的文档不再分配内存
+  size_t before = gAllocations;
+  for (auto& doc : docs) ctx.parse(doc, errMsg);
+  EXPECT_EQ(gAllocations - before, 0u);
+  EXPECT_EQ(ctx.root(), parseOk(docs.back()));
+
+  // 结构变化时结果仍然正确
+  for (const char* str :
+       {"[1,2,3]", "[1,\"a\"]", "[]", "{\"a\":{\"b\":[]}}", "{\"a\":1,\"a\":2}",
+        "\"s\"", "[{\"k\":1},{\"k\":[true]},{\"j\":{}}]", "null", "{}",
+        "{\"name\":[false],\"id\":\"7\"}"}) {
+    ASSERT_TRUE(ctx.parse(str, errMsg)) << str << errMsg;
+    EXPECT_EQ(ctx.root(), parseOk(str)) << str;
+  }
+  EXPECT_FALSE(ctx.parse("{\"a\":[1,}", errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "INVALID VALUE");
+  EXPECT_FALSE(ctx.parse("[1] 2", errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "ROOT NOT SINGULAR");
+  ASSERT_TRUE(ctx.parse(docs[1], errMsg));
+  EXPECT_EQ(ctx.root(), parseOk(docs[1]));
+
+  ctx.clear();
+  EXPECT_TRUE(ctx.root().isNull());
+}
+
+TEST(ParseContext, PackedArrays) {
+  ParseOptions opts;
+  opts.packArrays = true;
+  ParseContext ctx(opts);
+  std::string errMsg;
+  for (const char* str : {"[1,2,3]", "[4,5]", "[true,false]", "[1,true]", "[true,1]",
+                          "[6,7,8,9]", "{\"v\":[1.5,2]}", "{\"v\":[true]}"}) {
+    ASSERT_TRUE(ctx.parse(str, errMsg)) << str << errMsg;
+    Json expect = Json::parse(str, errMsg, opts);
+    EXPECT_EQ(ctx.root(), expect) << str;
+    EXPECT_EQ(ctx.root().serialize(), expect.serialize()) << str;
+  }
+  ASSERT_TRUE(ctx.parse("[1,2,3]", errMsg));
+  const Json& root = ctx.root();
+  EXPECT_TRUE(root.isPacked());
+  EXPECT_EQ(root[2].toDouble(), 3);  // 生成 boxed 副本
+  size_t before = gAllocations;
+  ASSERT_TRUE(ctx.parse("[4,5,6]", errMsg));
+  EXPECT_EQ(gAllocations - before, 0u);
+  EXPECT_EQ(root[2].toDouble(), 6);  // 旧的 boxed 副本已丢弃
+}
+
+/**
+ * 统计分配次数和未归还字节数的 memory_resource
+ */
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  size_t allocations = 0;
+  size_t outstanding = 0;
+
+ private:
+  void* do_allocate(size_t bytes, size_t align) override {
+    ++allocations;
+    outstanding += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, align);
+  }
+  void do_deallocate(void* ptr, size_t bytes, size_t align) override {
+    outstanding -= bytes;
+    std::pmr::new_delete_resource()->deallocate(ptr, bytes, align);
+  }
+  bool do_is_equal(const memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+TEST(Pmr, Counting) {
+  std::string text =
+      "{\"id\":1,\"tags\":[\"a\",\"b\",true],\"nested\":{\"x\":null,\"list\":[1,2]}}";
+  CountingResource mr;
+  std::string errMsg;
+  {
+    size_t before = gAllocations;
+    Json json = Json::parse(text, errMsg, ParseOptions(), &mr);
+    EXPECT_EQ(gAllocations - before, 0u);  // 短的字符串和 key 不分配内存
+    EXPECT_GT(mr.allocations, 0u);
+    EXPECT_EQ(json.get_allocator().resource(), &mr);
+    EXPECT_EQ(json["nested"]["list"][1].get_allocator().resource(), &mr);
+    EXPECT_EQ(json, parseOk(text));
+
+    // 拷贝构造默认使用默认的 resource，也可以指定
+    size_t allocations = mr.allocations;
+    Json copy(json);
+    EXPECT_EQ(mr.allocations, allocations);
+    EXPECT_EQ(copy["tags"][0].get_allocator().resource(),
+              std::pmr::get_default_resource());
+    Json inMr(copy, &mr);
+    EXPECT_GT(mr.allocations, allocations);
+    EXPECT_EQ(inMr["tags"][0].get_allocator().resource(), &mr);
+    EXPECT_EQ(inMr, json);
+
+    // 拷贝赋值保留左边的 resource；容器中的元素使用容器的 resource
+    Json target(&mr);
+    target = copy;
+    EXPECT_EQ(target["nested"].get_allocator().resource(), &mr);
+    Json::_array arr(&mr);
+    arr.push_back(copy);
+    arr.emplace_back(2.5);
+    EXPECT_EQ(arr[0]["nested"]["x"].get_allocator().resource(), &mr);
+    EXPECT_EQ(arr[1].get_allocator().resource(), &mr);
+
+    std::pmr::string out = json.serialize(WriterOptions(), &mr);
+    EXPECT_EQ(std::string_view(out), json.serialize());
+    EXPECT_EQ(out.get_allocator().resource(), &mr);
+  }
+  EXPECT_EQ(mr.outstanding, 0u);
+
+  // 紧凑数组及其 boxed 副本
+  ParseOptions opts;
+  opts.packArrays = true;
+  {
+    const Json packed = Json::parse("[1,2,3]", errMsg, opts, &mr);
+    ASSERT_TRUE(packed.isPacked());
+    size_t allocations = mr.allocations;
+    size_t before = gAllocations;
+    EXPECT_EQ(packed[2].toDouble(), 3);
+    EXPECT_EQ(gAllocations - before, 0u);
+    EXPECT_GT(mr.allocations, allocations);
+  }
+  EXPECT_EQ(mr.outstanding, 0u);
+
+  {
+    ParseContext ctx(opts, &mr);
+    ASSERT_TRUE(ctx.parse(text, errMsg));
+    EXPECT_EQ(ctx.root()["tags"].get_allocator().resource(), &mr);
+  }
+  EXPECT_EQ(mr.outstanding, 0u);
+}
+
+TEST(Pmr, Monotonic) {
+  std::string text = "[";
+  for (int i = 0; i != 50; ++i) {
+    text += (i ? "," : "") + std::string("{\"id\":") + std::to_string(i) +
+            ",\"name\":\"n" + std::to_string(i) + "\",\"v\":[1.5,false,null]}";
+  }
+  text += "]";
+  Json expect = parseOk(text);
+
+  CountingResource upstream;
+  std::pmr::monotonic_buffer_resource arena(1 << 16, &upstream);
+  std::string errMsg;
+  size_t before = gAllocations;
+  {
+    Json json = Json::parse(text, errMsg, ParseOptions(), &arena);
+    Json copy(json, &arena);
+    copy[3]["v"][0] = Json(2.5, &arena);
+    std::pmr::string out = copy.serialize(WriterOptions(), &arena);
+    EXPECT_EQ(gAllocations - before, 0u);  // 全部来自 arena
+    EXPECT_EQ(json, expect);
+    EXPECT_NE(copy, expect);
+    EXPECT_EQ(Json::parse(std::string(out), errMsg), copy);
+  }
+  EXPECT_GT(upstream.allocations, 0u);
+  arena.release();
+  EXPECT_EQ(upstream.outstanding, 0u);
+}
+
+TEST(Pmr, MonotonicLongStrings) {
+  // 字符串、key 和延迟转换的数字都超出 SSO
+  std::string text = "[";
+  for (int i = 0; i != 20; ++i) {
+    text += (i ? "," : "") + std::string("{\"identifier_of_the_record\":") +
+            "3.14159265358979323846" + std::to_string(i) +
+            ",\"a rather long member name\":\"a value that does not fit in SSO " +
+            std::to_string(i) + "\",\"escaped \\u00e9 key of some length\":\"line\\nbreak" +
+            std::string(40, 'x') + "\"}";
+  }
+  text += "]";
+  ParseOptions opts;
+  opts.lazyNumbers = true;
+  Json expect = parseOk(text);
+
+  CountingResource upstream;
+  std::pmr::monotonic_buffer_resource arena(1 << 16, &upstream);
+  std::string errMsg;
+  size_t before = gAllocations;
+  {
+    Json json = Json::parse(text, errMsg, opts, &arena);
+    Json copy(json, &arena);
+    copy[3]["a rather long member name"] = Json("another value longer than SSO", &arena);
+    copy[4].emplace("a new member with a long key", "and a long value as well");
+    copy[5].erase("a rather long member name");
+    std::string_view name = json[7]["a rather long member name"].toString();
+    std::pmr::string out = copy.serialize(WriterOptions(), &arena);
+
+    ParseContext ctx(opts, &arena);
+    ASSERT_TRUE(ctx.parse(text, errMsg)) << errMsg;
+    ASSERT_TRUE(ctx.parse(text, errMsg)) << errMsg;
+    EXPECT_EQ(gAllocations - before, 0u);  // 全部来自 arena
+
+    EXPECT_EQ(name, "a value that does not fit in SSO 7");
+    EXPECT_EQ(json, expect);
+    EXPECT_EQ(ctx.root(), expect);
+    EXPECT_EQ(json[0].toObj().begin()->first.get_allocator().resource(), &arena);
+    EXPECT_EQ(json[0]["identifier_of_the_record"].numberText(), "3.141592653589793238460");
+    EXPECT_EQ(Json::parse(std::string(out), errMsg), copy);
+    EXPECT_FALSE(copy[5].toObj().count(Json::_string("a rather long member name")));
+  }
+  arena.release();
+  EXPECT_EQ(upstream.outstanding, 0u);
+}
+
+#ifndef ZZJSON_DISABLE_STATS
+TEST(Stats, Parse) {
+  std::string text =
+      "{\"id\":1,\"tags\":[\"a\",\"b\\n\",true],\"nested\":{\"x\":null,\"li\\u0073t\":[1,2]}}";
+  CountingResource mr;
+  ParseStats stats;
+  size_t calls = 0;
+  stats.onFinish = [&](const ParseStats& s) {
+    ++calls;
+    EXPECT_EQ(&s, &stats);
+  };
+  ParseOptions opts;
+  opts.stats = &stats;
+  std::string errMsg;
+  Json json = Json::parse(text, errMsg, opts, &mr);
+  EXPECT_EQ(calls, 1u);
+  EXPECT_TRUE(stats.ok);
+  EXPECT_EQ(stats.bytes, text.size());
+  EXPECT_EQ(stats.nulls, 1u);
+  EXPECT_EQ(stats.bools, 1u);
+  EXPECT_EQ(stats.numbers, 3u);
+  EXPECT_EQ(stats.strings, 2u);
+  EXPECT_EQ(stats.arrays, 2u);
+  EXPECT_EQ(stats.objects, 2u);
+  EXPECT_EQ(stats.keys, 5u);
+  EXPECT_EQ(stats.values(), 11u);
+  EXPECT_EQ(stats.maxDepth, 3u);
+  EXPECT_EQ(stats.escapedStrings, 2u);
+  EXPECT_EQ(stats.bytesCopied, 2u + 4 + 1 + 2 + 6 + 1 + 4);
+  // 字符串都很短，所有的分配都经过 mr
+  EXPECT_EQ(stats.allocations, mr.allocations);
+
+  // 失败时同样回调，计数在下一次解析前清零
+  EXPECT_TRUE(Json::parse("[1,[2,", errMsg, opts).isNull());
+  EXPECT_EQ(calls, 2u);
+  EXPECT_FALSE(stats.ok);
+  EXPECT_EQ(stats.numbers, 2u);
+  EXPECT_EQ(stats.strings, 0u);
+
+  opts.packArrays = true;
+  Json::parse("[[1,2,3],[true,false]]", errMsg, opts);
+  EXPECT_EQ(stats.numbers, 3u);
+  EXPECT_EQ(stats.bools, 2u);
+  EXPECT_EQ(stats.arrays, 3u);
+  EXPECT_EQ(stats.maxDepth, 2u);
+
+  // 原地解析：预热之后没有分配
+  opts.packArrays = false;
+  ParseContext ctx(opts);
+  ASSERT_TRUE(ctx.parse(text, errMsg));
+  EXPECT_GT(stats.allocations, 0u);
+  ASSERT_TRUE(ctx.parse(text, errMsg));
+  EXPECT_EQ(stats.allocations, 0u);
+  EXPECT_EQ(stats.values(), 11u);
+  EXPECT_EQ(stats.keys, 5u);
+  EXPECT_EQ(stats.maxDepth, 3u);
+  EXPECT_EQ(calls, 5u);
+}
+
+TEST(Stats, Serialize) {
+  Json json = parseOk("{\"a\":[1,2,{\"b\":\"x\\ty\"}],\"c\\\"\":null}");
+  SerializeStats stats;
+  size_t calls = 0;
+  stats.onFinish = [&](const SerializeStats&) { ++calls; };
+  WriterOptions opts;
+  opts.stats = &stats;
+  std::string out = json.serialize(opts);
+  EXPECT_EQ(calls, 1u);
+  EXPECT_EQ(stats.bytes, out.size());
+  EXPECT_EQ(stats.values, 7u);
+  EXPECT_EQ(stats.maxDepth, 3u);
+  EXPECT_EQ(stats.escapedStrings, 2u);
+
+  ParseOptions popts;
+  popts.packArrays = true;
+  std::string errMsg;
+  Json packed = Json::parse("[[1,2,3]]", errMsg, popts);
+  packed.serialize(opts);
+  EXPECT_EQ(stats.values, 5u);
+  EXPECT_EQ(stats.maxDepth, 2u);
+
+  ParallelOptions par;
+  par.threads = 4;
+  par.minSplit = 2;
+  EXPECT_EQ(serializeParallel(json, opts, par), out);
+  EXPECT_EQ(stats.bytes, out.size());
+  EXPECT_EQ(calls, 3u);
+}
+#endif
+
+TEST(Memory, UsageAndCompact) {
+  std::string text = "[";
+  for (int i = 0; i != 100; ++i) {
+    text += (i ? "," : "") + std::string("{\"id\":") + std::to_string(i) +
+            ",\"description of the record\":\"a string that does not fit in SSO\\n\","
+            "\"values\":[1,2,3,4,5],\"flags\":[true,false]}";
+  }
+  text += "]";
+  Json json = parseOk(text);
+  size_t node = Json().memoryUsage().total();   // 一个 null 只有节点本身
+  MemoryUsage before = json.memoryUsage();
+  EXPECT_EQ(before.nodes, (1 + 100 * 12) * node);
+  EXPECT_GE(before.arrays, (100 + 100 * 7) * sizeof(Json));
+  EXPECT_GT(before.strings, 0u);
+  EXPECT_GT(before.objects, 100 * 4 * sizeof(Json::_obj::value_type));
+  EXPECT_GT(before.slack, 0u);
+  EXPECT_EQ(before.total(), before.nodes + before.strings + before.arrays +
+                                before.objects + before.packed);
+
+  json.compact();
+  MemoryUsage after = json.memoryUsage();
+  EXPECT_EQ(json, parseOk(text));
+  EXPECT_EQ(after.slack, 0u);
+  EXPECT_EQ(after.arrays, (100 + 100 * 7) * sizeof(Json));
+  EXPECT_LE(after.objects, before.objects);
+  EXPECT_LT(after.total(), before.total());
+  EXPECT_EQ(json[5]["values"][2].toDouble(), 3);
+
+  // 紧凑数组的 boxed 副本计入 packed，compact() 时丢弃
+  ParseOptions opts;
+  opts.packArrays = true;
+  std::string errMsg;
+  const Json packed = Json::parse("[1,2,3,4,5,6,7,8,9]", errMsg, opts);
+  size_t bare = packed.memoryUsage().packed;
+  EXPECT_EQ(packed[0].toDouble(), 1);
+  EXPECT_GT(packed.memoryUsage().packed, bare);
+  const_cast<Json&>(packed).compact();
+  EXPECT_LT(packed.memoryUsage().packed, bare);     // 存储的容量也被收紧
+  EXPECT_EQ(packed.memoryUsage().slack, 0u);
+}
+
+TEST(Snapshot, Freeze) {
+  std::string text = "[";
+  for (int i = 0; i != 100; ++i) {
+    text += (i ? "," : "") + std::string("{\"id\":") + std::to_string(i) +
+            ",\"status\":\"active and verified\",\"name\":\"user " +
+            std::to_string(i) + "\",\"tags\":[\"x\",\"y\"]}";
+  }
+  text += "]";
+  Json json = parseOk(text);
+  json.compact();
+  std::string errMsg;
+  auto frozen = Snapshot::freeze(json, errMsg);
+  ASSERT_TRUE(frozen) << errMsg;
+  EXPECT_EQ(frozen->root().toJson(), json);
+  EXPECT_EQ(frozen->root()[42]["name"].toString(), "user 42");
+  EXPECT_EQ(frozen->root()[99]["status"].toString(), "active and verified");
+  // 重复的 key 和字符串只写入一次
+  EXPECT_LT(frozen->byteSize(), json.memoryUsage().total() / 2);
+  EXPECT_EQ(frozen->root()[0]["status"].toString().data(),
+            frozen->root()[1]["status"].toString().data());
+}
+
+TEST(Hash, Structural) {
+  std::string errMsg;
+  Json a = parseOk("{\"x\":1,\"y\":[true,null,\"s\"],\"z\":{\"k\":-0.0}}");
+  Json b = parseOk("{\"z\":{\"k\":0},\"y\":[true,null,\"s\"],\"x\":1.0}");
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.hash(), b.hash());
+  EXPECT_NE(a.hash(), parseOk("{\"x\":1,\"y\":[null,true,\"s\"],\"z\":{\"k\":0}}").hash());
+  EXPECT_NE(parseOk("{\"a\":1,\"b\":2}").hash(), parseOk("{\"a\":2,\"b\":1}").hash());
+  EXPECT_NE(parseOk("[]").hash(), parseOk("{}").hash());
+  EXPECT_NE(parseOk("\"1\"").hash(), parseOk("1").hash());
+  EXPECT_NE(parseOk("[[1],2]").hash(), parseOk("[1,[2]]").hash());
+
+  ParseOptions opts;
+  opts.packArrays = true;
+  EXPECT_EQ(Json::parse("[1,2,3]", errMsg, opts).hash(), parseOk("[1,2,3]").hash());
+  EXPECT_EQ(Json::parse("[true,false]", errMsg, opts).hash(),
+            parseOk("[true,false]").hash());
+}
+
+TEST(Hash, Dedup) {
+  std::string policy =
+      "{\"effect\":\"allow\",\"actions\":[\"read\",\"write\",\"list\"],"
+      "\"description\":\"the default policy for every tenant in the system\","
+      "\"limits\":{\"rate\":100,\"burst\":[1,2,3,4,5,6,7,8]}}";
+  std::string text = "[";
+  for (int i = 0; i != 200; ++i) {
+    text += (i ? "," : "") + std::string("{\"id\":") + std::to_string(i) +
+            ",\"policy\":" + policy + "}";
+  }
+  text += "]";
+  Json expect = parseOk(text);
+  Json json = parseOk(text);
+  size_t before = json.memoryUsage().total();
+  json.dedup();
+  EXPECT_LT(json.memoryUsage().total() * 4, before);
+  EXPECT_EQ(json, expect);
+  EXPECT_EQ(json.hash(), expect.hash());
+  EXPECT_EQ(json.serialize(), expect.serialize());
+  EXPECT_FALSE(json.isShared());
+  EXPECT_FALSE(json[0].isShared());     // id 不同
+  EXPECT_TRUE(json[0]["policy"].isShared());
+  EXPECT_EQ(&json[0]["policy"].toObj(), &json[199]["policy"].toObj());
+  EXPECT_EQ(json[3]["policy"]["limits"]["burst"][7].toDouble(), 8);
+  // 再次 dedup 不改变结果
+  json.dedup();
+  EXPECT_EQ(json, expect);
+
+  // 拷贝只复制引用
+  Json copy = json;
+  EXPECT_EQ(&copy[5]["policy"].toObj(), &json[5]["policy"].toObj());
+
+  // 写时复制：只影响被修改的那一处
+  json[7]["policy"]["limits"]["rate"] = Json(5);
+  EXPECT_EQ(json[7]["policy"]["limits"]["rate"].toDouble(), 5);
+  EXPECT_EQ(json[8]["policy"]["limits"]["rate"].toDouble(), 100);
+  EXPECT_EQ(copy[7]["policy"]["limits"]["rate"].toDouble(), 100);
+  EXPECT_FALSE(json[7]["policy"].isShared());
+  EXPECT_NE(json, expect);
+  EXPECT_EQ(copy, expect);
+
+  // 被覆盖的节点不影响其他共享者
+  json[9]["policy"] = Json(nullptr);
+  EXPECT_TRUE(json[10]["policy"].isObject());
+
+  // 原地重新解析覆盖共享的节点
+  ParseContext ctx;
+  std::string errMsg;
+  ASSERT_TRUE(ctx.parse(text, errMsg));
+  ctx.root().dedup();
+  ASSERT_TRUE(ctx.parse(text, errMsg));
+  EXPECT_EQ(ctx.root(), expect);
+  EXPECT_FALSE(ctx.root()[0]["policy"].isShared());
+}
+
+TEST(Hash, DedupEquality) {
+  // 两份分别 dedup() 的文档：重复的块在两边是不同的共享节点
+  std::string block = "{\"tags\":[\"a long tag outside SSO\",\"b\"],\"n\":{\"x\":[1,2,3]}}";
+  std::string text = "[";
+  for (int i = 0; i != 200; ++i) text += (i ? "," : "") + block;
+  text += "]";
+  Json a = parseOk(text), b = parseOk(text);
+  a.dedup();
+  b.dedup();
+  EXPECT_TRUE(a[0].isShared());
+  EXPECT_TRUE(b[0].isShared());
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(b, a);
+
+  // 只有最后一块不同
+  std::string changed = text.substr(0, text.size() - block.size() - 1) +
+                        "{\"tags\":[\"a long tag outside SSO\",\"b\"],\"n\":{\"x\":[1,2,4]}}]";
+  Json c = parseOk(changed);
+  c.dedup();
+  EXPECT_NE(a, c);
+  EXPECT_NE(c, a);
+}
+
+TEST(Hash, DeepDedup) {
+  // 哈希和 dedup() 不递归：两个相同的深层子树，递归时这样的深度会耗尽调用栈
+  auto build = [] {
+    Json doc;
+    for (int n = 0; n != 2; ++n) {
+      Json* cur = &doc.emplace_back(Json::_array());
+      for (int i = 0; i != 300000; ++i) cur = &cur->emplace_back(Json::_array());
+      cur->emplace_back("a long string that is not in the SSO buffer");
+    }
+    return doc;
+  };
+  Json a = build(), b = build();
+  EXPECT_EQ(a.hash(), b.hash());
+  EXPECT_EQ(a[0].hash(), a[1].hash());
+  a.dedup();
+  EXPECT_TRUE(a[1].isShared());
+  EXPECT_TRUE(a[0].isShared());
+  EXPECT_EQ(a.hash(), b.hash());
+  EXPECT_EQ(a, b);
+
+  // 共享的节点之间比较，哈希从缓存中读取
+  b.dedup();
+  EXPECT_EQ(a, b);
+  EXPECT_EQ(a.hash(), b.hash());
+  b[1].emplace_back(1);
+  EXPECT_NE(a, b);
+  EXPECT_NE(a.hash(), b.hash());
+}
+
+TEST(Patch, Diff) {
+  std::string errMsg;
+  Json from = parseOk(
+      "{\"a\":1,\"b\":{\"c\":[1,2,3,4,5],\"d\":\"x\"},\"e/f\":true,\"g~\":null,"
+      "\"h\":[{\"id\":1},{\"id\":2},{\"id\":3}]}");
+  Json to = parseOk(
+      "{\"a\":1,\"b\":{\"c\":[1,9,3,4,5,6],\"d\":\"x\"},\"e/f\":false,\"n\":[],"
+      "\"h\":[{\"id\":0},{\"id\":1},{\"id\":3},{\"id\":4}]}");
+  EXPECT_EQ(diff(from, from), parseOk("[]"));
+
+  Json patch = diff(from, to);
+  // c: 1 处替换 + 1 处追加；e/f、g~、n 各 1；h: 插入 0、删除 2、追加 4
+  EXPECT_EQ(patch.size(), 8u);
+  Json doc = from;
+  ASSERT_TRUE(applyPatch(doc, patch, errMsg)) << errMsg;
+  EXPECT_EQ(doc, to);
+  std::string text = patch.serialize();
+  EXPECT_NE(text.find("\"/e~1f\""), std::string::npos);
+  EXPECT_NE(text.find("\"/g~0\""), std::string::npos);
+  EXPECT_EQ(text.find("\"/h/0/id\""), std::string::npos);
+
+  // 类型不同时整体替换
+  EXPECT_EQ(diff(parseOk("[1]"), parseOk("{\"a\":1}")),
+            parseOk("[{\"op\":\"replace\",\"path\":\"\",\"value\":{\"a\":1}}]"));
+
+  // 紧凑数组
+  ParseOptions opts;
+  opts.packArrays = true;
+  Json packed = Json::parse("[1,2,3,4]", errMsg, opts);
+  EXPECT_EQ(diff(packed, parseOk("[1,2,3,4]")).size(), 0u);
+  patch = diff(packed, parseOk("[1,2,4]"));
+  EXPECT_EQ(patch, parseOk("[{\"op\":\"remove\",\"path\":\"/2\"}]"));
+  ASSERT_TRUE(applyPatch(packed, patch, errMsg)) << errMsg;
+  EXPECT_EQ(packed, parseOk("[1,2,4]"));
+
+  // 共享结构的文档：只有修改过的路径被比较
+  std::string text2 = "[";
+  for (int i = 0; i != 100; ++i) {
+    text2 += (i ? "," : "") + std::string("{\"id\":") + std::to_string(i) +
+             ",\"tags\":[\"a\",\"b\",\"c\"]}";
+  }
+  text2 += "]";
+  Json base = parseOk(text2);
+  base.dedup();
+  Json next = base;
+  next[42]["tags"][1] = Json("z");
+  patch = diff(base, next);
+  EXPECT_EQ(patch, parseOk("[{\"op\":\"replace\",\"path\":\"/42/tags/1\",\"value\":\"z\"}]"));
+}
+
+TEST(Patch, Apply) {
+  std::string errMsg;
+  // RFC 6902 附录 A 中的例子
+  Json doc = parseOk("{\"foo\":[\"bar\",\"baz\"],\"baz\":\"qux\"}");
+  ASSERT_TRUE(applyPatch(doc, parseOk(
+      "[{\"op\":\"add\",\"path\":\"/foo/1\",\"value\":\"qux\"},"
+      "{\"op\":\"add\",\"path\":\"/foo/-\",\"value\":[\"abc\",\"def\"]},"
+      "{\"op\":\"remove\",\"path\":\"/baz\"},"
+      "{\"op\":\"add\",\"path\":\"/child\",\"value\":{\"grandchild\":{}}},"
+      "{\"op\":\"replace\",\"path\":\"/foo/0\",\"value\":\"boo\"},"
+      "{\"op\":\"test\",\"path\":\"/foo/3/1\",\"value\":\"def\"},"
+      "{\"op\":\"copy\",\"from\":\"/foo/3\",\"path\":\"/child/grandchild/x\"},"
+      "{\"op\":\"move\",\"from\":\"/foo/1\",\"path\":\"/child/y\"}]"), errMsg)) << errMsg;
+  EXPECT_EQ(doc, parseOk(
+      "{\"foo\":[\"boo\",\"baz\",[\"abc\",\"def\"]],"
+      "\"child\":{\"grandchild\":{\"x\":[\"abc\",\"def\"]},\"y\":\"qux\"}}"));
+
+  // 替换根节点
+  ASSERT_TRUE(applyPatch(doc, parseOk("[{\"op\":\"replace\",\"path\":\"\",\"value\":3}]"),
+                         errMsg));
+  EXPECT_EQ(doc, Json(3));
+
+  // 失败
+  auto failed = [&](const char* patch) {
+    Json doc = parseOk("{\"a\":{\"b\":[1,2]}}");
+    errMsg.clear();
+    EXPECT_FALSE(applyPatch(doc, parseOk(patch), errMsg)) << patch;
+    EXPECT_FALSE(errMsg.empty());
+    return errMsg;
+  };
+  EXPECT_EQ(failed("[{\"op\":\"test\",\"path\":\"/a/b/0\",\"value\":2}]"),
+            "PATCH TEST FAILED: /a/b/0");
+  EXPECT_EQ(failed("[{\"op\":\"remove\",\"path\":\"/a/c\"}]"),
+            "PATCH PATH NOT FOUND: /a/c");
+  failed("[{\"op\":\"add\",\"path\":\"/a/b/3\",\"value\":1}]");
+  failed("[{\"op\":\"add\",\"path\":\"/a/b/01\",\"value\":1}]");
+  failed("[{\"op\":\"replace\",\"path\":\"/x\",\"value\":1}]");
+  failed("[{\"op\":\"move\",\"from\":\"/a\",\"path\":\"/a/b/0\"}]");
+  failed("[{\"op\":\"add\",\"path\":\"/a\"}]");
+  failed("[{\"op\":\"frob\",\"path\":\"/a\"}]");
+  failed("[{\"op\":\"add\",\"path\":\"a\",\"value\":1}]");
+  failed("{}");
+
+  // 修改共享的子树时写时复制
+  Json base = parseOk("[{\"k\":[1,2]},{\"k\":[1,2]}]");
+  base.dedup();
+  Json copy = base;
+  ASSERT_TRUE(applyPatch(copy, parseOk("[{\"op\":\"add\",\"path\":\"/0/k/-\",\"value\":3}]"),
+                         errMsg));
+  EXPECT_EQ(copy, parseOk("[{\"k\":[1,2,3]},{\"k\":[1,2]}]"));
+  EXPECT_EQ(base, parseOk("[{\"k\":[1,2]},{\"k\":[1,2]}]"));
+}
+
+TEST(Patch, MergePatch) {
+  // RFC 7386 附录 A
+  auto merged = [](const char* target, const char* patch) {
+    Json doc = parseOk(target);
+    mergePatch(doc, parseOk(patch));
+    return doc;
+  };
+  EXPECT_EQ(merged("{\"a\":\"b\"}", "{\"a\":\"c\"}"), parseOk("{\"a\":\"c\"}"));
+  EXPECT_EQ(merged("{\"a\":\"b\"}", "{\"b\":\"c\"}"), parseOk("{\"a\":\"b\",\"b\":\"c\"}"));
+  EXPECT_EQ(merged("{\"a\":\"b\"}", "{\"a\":null}"), parseOk("{}"));
+  EXPECT_EQ(merged("{\"a\":\"b\",\"b\":\"c\"}", "{\"a\":null}"), parseOk("{\"b\":\"c\"}"));
+  EXPECT_EQ(merged("{\"a\":[\"b\"]}", "{\"a\":\"c\"}"), parseOk("{\"a\":\"c\"}"));
+  EXPECT_EQ(merged("{\"a\":\"c\"}", "{\"a\":[\"b\"]}"), parseOk("{\"a\":[\"b\"]}"));
+  EXPECT_EQ(merged("{\"a\":{\"b\":\"c\"}}", "{\"a\":{\"b\":\"d\",\"c\":null}}"),
+            parseOk("{\"a\":{\"b\":\"d\"}}"));
+  EXPECT_EQ(merged("{\"a\":[{\"b\":\"c\"}]}", "{\"a\":[1]}"), parseOk("{\"a\":[1]}"));
+  EXPECT_EQ(merged("[\"a\",\"b\"]", "[\"c\",\"d\"]"), parseOk("[\"c\",\"d\"]"));
+  EXPECT_EQ(merged("{\"a\":\"b\"}", "[\"c\"]"), parseOk("[\"c\"]"));
+  EXPECT_EQ(merged("{\"a\":\"foo\"}", "null"), parseOk("null"));
+  EXPECT_EQ(merged("{\"a\":\"foo\"}", "\"bar\""), parseOk("\"bar\""));
+  EXPECT_EQ(merged("{\"e\":null}", "{\"a\":1}"), parseOk("{\"e\":null,\"a\":1}"));
+  EXPECT_EQ(merged("[1,2]", "{\"a\":\"b\",\"c\":null}"), parseOk("{\"a\":\"b\"}"));
+  EXPECT_EQ(merged("{}", "{\"a\":{\"bb\":{\"ccc\":null}}}"), parseOk("{\"a\":{\"bb\":{}}}"));
+}
+
+TEST(Build, InPlace) {
+  Json doc;
+  doc["name"] = Json("zz");
+  doc.emplace("items", Json::_array()).first.reserve(3);
+  for (int i = 0; i != 3; ++i) {
+    Json& item = doc["items"].emplace_back();
+    item.emplace("id", i);
+    item.emplace("tags").first.push_back(Json("t"));
+  }
+  doc["items"].insert(0, Json(true));
+  doc.emplace("empty", Json::_obj());
+  EXPECT_EQ(doc, parseOk("{\"name\":\"zz\",\"empty\":{},\"items\":[true,"
+                         "{\"id\":0,\"tags\":[\"t\"]},{\"id\":1,\"tags\":[\"t\"]},"
+                         "{\"id\":2,\"tags\":[\"t\"]}]}"));
+
+  // emplace() 不覆盖已有的成员
+  auto res = doc.emplace("name", "other");
+  EXPECT_FALSE(res.second);
+  EXPECT_EQ(res.first.toString(), "zz");
+
+  EXPECT_EQ(doc["items"].erase(0), 1u);
+  EXPECT_EQ(doc["items"].erase(9), 0u);
+  EXPECT_EQ(doc.erase("empty"), 1u);
+  EXPECT_EQ(doc.erase("missing"), 0u);
+  doc["items"][2].clear();
+  EXPECT_EQ(doc, parseOk("{\"name\":\"zz\",\"items\":[{\"id\":0,\"tags\":[\"t\"]},"
+                         "{\"id\":1,\"tags\":[\"t\"]},{}]}"));
+
+  // operator[] 插入 null
+  Json& added = doc["added"];
+  EXPECT_TRUE(added.isNull());
+  EXPECT_EQ(doc.size(), 3u);
+  EXPECT_EQ(static_cast<const Json&>(doc)["added"], Json());
+
+  EXPECT_THROW(doc["name"].push_back(Json(1)), JsonExcept);
+  EXPECT_THROW(doc["items"]["x"], JsonExcept);
+  EXPECT_THROW(doc["items"].insert(9, Json(1)), JsonExcept);
+
+  // 只有 emplace_back() / emplace() / operator[](key) 会在 null 上创建容器
+  Json null;
+  EXPECT_THROW(null[5], JsonExcept);
+  EXPECT_THROW(null[0], JsonExcept);
+  EXPECT_THROW(null.mutableArray(), JsonExcept);
+  EXPECT_THROW(null.insert(0, Json(1)), JsonExcept);
+  EXPECT_TRUE(null.isNull());
+  EXPECT_THROW(doc["items"][3], JsonExcept);
+  Json list;
+  list.push_back(Json(1));
+  EXPECT_EQ(list, parseOk("[1]"));
+  EXPECT_THROW(list[1], JsonExcept);
+
+  // 紧凑数组和共享的子树先转换 / 拷贝
+  std::string errMsg;
+  ParseOptions opts;
+  opts.packArrays = true;
+  Json packed = Json::parse("[1,2]", errMsg, opts);
+  packed.push_back(Json(3));
+  EXPECT_FALSE(packed.isPacked());
+  EXPECT_EQ(packed, parseOk("[1,2,3]"));
+  Json shared = parseOk("[{\"k\":[1,2]},{\"k\":[1,2]}]");
+  shared.dedup();
+  shared[1]["k"].emplace_back(3);
+  EXPECT_EQ(shared, parseOk("[{\"k\":[1,2]},{\"k\":[1,2,3]}]"));
+
+  // 元素直接构造在本节点的 resource 中，不使用默认的 resource
+  CountingResource mr;
+  {
+    Json root(Json::_obj(), &mr);
+    root.reserve(4);
+    size_t before = gAllocations;
+    Json& list = root.emplace("list", Json::_array()).first;
+    list.reserve(100);
+    for (int i = 0; i != 100; ++i) list.emplace_back(i);
+    root.emplace("flag", false);
+    EXPECT_EQ(gAllocations, before);
+    EXPECT_EQ(list[99].get_allocator().resource(), &mr);
+    EXPECT_EQ(list.size(), 100u);
+  }
+  EXPECT_EQ(mr.outstanding, 0u);
+}
+
+TEST(Visit, TypedAccess) {
+  Json json = parseOk("{\"b\":true,\"n\":2.5,\"s\":\"str\",\"a\":[1,null],\"o\":{},\"z\":null}");
+  EXPECT_EQ(*json["b"].get_if<bool>(), true);
+  EXPECT_EQ(*json["n"].get_if<double>(), 2.5);
+  EXPECT_EQ(*json["s"].get_if<Json::_string>(), "str");
+  EXPECT_EQ(json["a"].get_if<Json::_array>()->size(), 2u);
+  EXPECT_TRUE(json["o"].get_if<Json::_obj>()->empty());
+  EXPECT_TRUE(json["z"].get_if<std::nullptr_t>());
+  EXPECT_FALSE(json["n"].get_if<bool>());
+  EXPECT_FALSE(json["s"].get_if<double>());
+  EXPECT_FALSE(json["a"].get_if<Json::_obj>());
+  EXPECT_FALSE(json["z"].get_if<Json::_string>());
+
+  EXPECT_EQ(json["n"].value_or(0), 2);
+  EXPECT_EQ(json["n"].value_or(0.0), 2.5);
+  EXPECT_EQ(json["s"].value_or(7), 7);
+  EXPECT_TRUE(json["b"].value_or(false));
+  EXPECT_TRUE(json["n"].value_or(true));
+  EXPECT_EQ(json["s"].value_or("none"), "str");
+  EXPECT_EQ(json["z"].value_or("none"), "none");
+  EXPECT_EQ(json["z"].value_or(std::string("none")), "none");
+
+  // 只分派一次：统计各类型的值
+  std::string kinds;
+  std::function<void(const Json&)> walk = [&](const Json& val) {
+    val.visit(Overloaded{
+        [&](std::nullptr_t) { kinds += 'z'; },
+        [&](bool) { kinds += 'b'; },
+        [&](double) { kinds += 'n'; },
+        [&](std::string_view) { kinds += 's'; },
+        [&](const Json::_array& arr) {
+          kinds += 'a';
+          for (auto& v : arr) walk(v);
+        },
+        [&](const Json::_obj& obj) {
+          kinds += 'o';
+          for (auto& p : obj) walk(p.second);
+        },
+        [&](Span<const double>) { kinds += 'p'; },
+        [&](Span<const uint8_t>) { kinds += 'p'; },
+    });
+  };
+  walk(json);
+  std::sort(kinds.begin(), kinds.end());
+  EXPECT_EQ(kinds, "abnnooszz");
+  EXPECT_EQ(json["s"].visit([](const auto& val) {
+    return std::is_same_v<std::decay_t<decltype(val)>, Json::_string>;
+  }), true);
+
+  // 紧凑数组和共享的子树
+  std::string errMsg;
+  ParseOptions opts;
+  opts.packArrays = true;
+  Json packed = Json::parse("{\"n\":[1,2],\"b\":[true,false,true]}", errMsg, opts);
+  size_t before = packed.memoryUsage().packed;
+  EXPECT_FALSE(packed["n"].get_if<Json::_array>());
+  auto count = Overloaded{
+      [](Span<const double> nums) { return std::accumulate(nums.begin(), nums.end(), 0.0); },
+      [](Span<const uint8_t> bools) { return std::accumulate(bools.begin(), bools.end(), 0.0); },
+      [](const auto&) { return -1.0; },
+  };
+  EXPECT_EQ(packed["n"].visit(count), 3);
+  EXPECT_EQ(packed["b"].visit(count), 2);
+  EXPECT_EQ(packed.visit(count), -1);
+  EXPECT_EQ(packed.memoryUsage().packed, before);
+  EXPECT_EQ(packed, parseOk("{\"n\":[1,2],\"b\":[true,false,true]}"));
+  EXPECT_EQ(parseOk("{\"n\":[1,2],\"b\":[true,false,true]}"), packed);
+  EXPECT_NE(packed, parseOk("{\"n\":[1,3],\"b\":[true,false,true]}"));
+  EXPECT_NE(parseOk("{\"n\":[1,2],\"b\":[true,false,1]}"), packed);
+  EXPECT_EQ(packed.memoryUsage().packed, before);
+  Json shared = parseOk("[[\"a\",\"b\"],[\"a\",\"b\"]]");
+  shared.dedup();
+  ASSERT_TRUE(shared[1].isShared());
+  EXPECT_EQ(shared[1].get_if<Json::_array>(), shared[0].get_if<Json::_array>());
+  EXPECT_EQ(shared[1][0].value_or(""), "a");
+}
+
+TEST(Walk, Cursor) {
+  Json json = parseOk("{\"a\":[1,{\"b~/\":true}],\"c\":null}");
+  std::vector<std::string> events;
+  JsonCursor cur(json);
+  while (cur.next()) {
+    const char* kind = cur.kind() == WalkKind::kEnter   ? "enter "
+                       : cur.kind() == WalkKind::kLeave ? "leave "
+                                                        : "value ";
+    events.push_back(kind + cur.path() + " " + std::to_string(cur.depth()));
+  }
+  std::sort(events.begin(), events.end());
+  EXPECT_EQ(events, (std::vector<std::string>{
+                        "enter  0", "enter /a 1", "enter /a/1 2", "leave  0",
+                        "leave /a 1", "leave /a/1 2", "value /a/0 2",
+                        "value /a/1/b~0~1 3", "value /c 1"}));
+
+  // 先序：容器在子节点之前；后序：之后
+  Json arr = parseOk("[[1,2],3]");
+  std::string pre, post;
+  for (auto& cur : preOrder(arr)) pre += cur.path() + ";";
+  for (auto& cur : postOrder(arr)) post += cur.path() + ";";
+  EXPECT_EQ(pre, ";/0;/0/0;/0/1;/1;");
+  EXPECT_EQ(post, "/0/0;/0/1;/0;/1;;");
+
+  // skip() 不进入容器
+  JsonCursor skipping(arr);
+  size_t values = 0;
+  while (skipping.next()) {
+    if (skipping.kind() == WalkKind::kEnter && skipping.depth() == 1) skipping.skip();
+    if (skipping.kind() == WalkKind::kValue) ++values;
+  }
+  EXPECT_EQ(values, 1u);
+
+  // 后序遍历中原地修改：数字加倍，空的数组替换为 null
+  Json doc = parseOk("{\"x\":[1,2,[]],\"y\":{\"z\":3}}");
+  for (auto& cur : mutablePostOrder(doc)) {
+    Json& val = cur.value();
+    if (val.isNumber()) val = Json(val.toDouble() * 2);
+    if (val.isArray() && val.size() == 0) val = Json(nullptr);
+  }
+  EXPECT_EQ(doc, parseOk("{\"x\":[2,4,null],\"y\":{\"z\":6}}"));
+}
+
+TEST(Walk, DeepCopyAndCompare) {
+  // 拷贝和比较不递归
+  Json deep;
+  Json* cur = &deep;
+  for (int i = 0; i != 5000; ++i) cur = &cur->emplace_back(Json::_obj())["k"];
+  *cur = Json("leaf");
+  Json copy = deep;
+  EXPECT_EQ(copy, deep);
+  size_t depth = 0;
+  for (auto& c : preOrder(copy)) depth = std::max(depth, c.depth());
+  EXPECT_EQ(depth, 10000u);
+  *cur = Json("changed");
+  EXPECT_NE(copy, deep);
+
+  // 比较：对象与成员的顺序无关，大小或 key 不同时不等
+  EXPECT_EQ(parseOk("{\"a\":1,\"b\":[1,{\"c\":2}]}"), parseOk("{\"b\":[1,{\"c\":2}],\"a\":1}"));
+  EXPECT_NE(parseOk("{\"a\":1}"), parseOk("{\"a\":1,\"b\":2}"));
+  EXPECT_NE(parseOk("{\"a\":1,\"b\":2}"), parseOk("{\"a\":1}"));
+  EXPECT_NE(parseOk("{\"a\":1}"), parseOk("{\"b\":1}"));
+  EXPECT_NE(parseOk("[1,[2]]"), parseOk("[1,[2,3]]"));
+  EXPECT_NE(parseOk("[1,[2]]"), parseOk("[1,{\"0\":2}]"));
+}
+
+TEST(Walk, DeepSerialize) {
+  // 序列化、memoryUsage()、compact()、toMsgPack() 和快照的写入不递归
+  const int depth = 300000;
+  Json deep;
+  Json* cur = &deep;
+  for (int i = 0; i != depth; ++i) {
+    cur->emplace("b", 1);
+    cur = &cur->emplace("a", Json::_obj()).first;
+  }
+  cur->emplace("x", parseOk("[1,2]"));
+  std::string expected;
+  for (int i = 0; i != depth; ++i) expected += "{\"a\":";
+  expected += "{\"x\":[1,2]}";
+  for (int i = 0; i != depth; ++i) expected += ",\"b\":1}";
+  WriterOptions sorted;
+  sorted.sortKeys = true;
+  EXPECT_EQ(deep.serialize(sorted), expected);
+  EXPECT_EQ(deep.serialize().size(), expected.size());
+
+  MemoryUsage before = deep.memoryUsage();
+  EXPECT_GE(before.nodes, 3u * depth * sizeof(void*));
+  deep.compact();
+  EXPECT_EQ(deep.memoryUsage().slack, 0u);
+  EXPECT_EQ(deep.toMsgPack().size(), 6u * depth + 6);
+
+  // 快照可以写入，检查时拒绝过深的嵌套
+  std::string errMsg;
+  EXPECT_FALSE(Snapshot::fromBuffer(Snapshot::write(deep), errMsg, true));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "SNAPSHOT TOO DEEP");
+
+  // pretty 的缩进与之前相同
+  WriterOptions pretty;
+  pretty.pretty = true;
+  pretty.sortKeys = true;
+  EXPECT_EQ(parseOk("{\"b\":[1,{\"c\":[]}],\"a\":{}}").serialize(pretty),
+            "{\n    \"a\": {},\n    \"b\": [\n        1,\n        {\n"
+            "            \"c\": []\n        }\n    ]\n}");
+}
+
+TEST(Release, DeepAndAsync) {
+  // 析构不递归：递归释放时这样的深度会耗尽调用栈
+  {
+    Json deep;
+    Json* cur = &deep;
+    for (int i = 0; i != 300000; ++i) cur = &cur->emplace_back(Json::_array());
+    Json other;
+    cur = &other;
+    for (int i = 0; i != 300000; ++i) cur = &cur->emplace("k", Json::_obj()).first;
+    other = Json(1);   // 移动赋值释放原有的值
+  }
+
+  // 后台释放
+  Json big = parseOk("[{\"a\":[1,2,{\"b\":\"a long string that is not in the SSO buffer\"}]}]");
+  Json::releaseAsync(std::move(big));
+  big = Json(3);
+  EXPECT_EQ(big, Json(3));
+
+  // 其他 resource 中的文档直接释放
+  CountingResource mr;
+  std::string errMsg;
+  Json inMr = Json::parse("{\"a\":[1,{\"b\":[true]}]}", errMsg, ParseOptions(), &mr);
+  EXPECT_GT(mr.outstanding, 0u);
+  Json::releaseAsync(std::move(inMr));
+  EXPECT_EQ(mr.outstanding, 0u);
+}
+
+// 在后台释放的线程启动之前构造，main 返回后才析构
+static SharedJson gStaticShared;
+static ParseCache gStaticCache(4);
+static SharedJson::Document gStaticDoc;
+
+TEST(Release, AfterReaperStopped) {
+  // 子进程中 exit()：gStaticShared 的文档在后台线程停止之后释放，直接在调用者中释放
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  EXPECT_EXIT(
+      {
+        std::string errMsg;
+        gStaticShared.reload("{\"a\":[1,2,{\"b\":\"a long string that is not in the SSO buffer\"}]}",
+                             errMsg);
+        gStaticShared.reload("{\"a\":[3]}", errMsg);
+        std::exit(0);
+      },
+      testing::ExitedWithCode(0), "");
+}
+
+TEST(Release, SharedDocumentsOutliveMain) {
+  // SharedJson、ParseCache 和单独持有的文档都在 exit() 之后释放最后一个引用
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  EXPECT_EXIT(
+      {
+        std::string errMsg;
+        gStaticShared.reload("{\"v\":1}", errMsg);
+        gStaticDoc = gStaticCache.parse("{\"cached\":[1,2,3]}", errMsg);
+        for (int i = 0; i != 8; ++i) gStaticCache.parse("[" + std::to_string(i) + "]", errMsg);
+        gStaticShared.reload("{\"v\":2}", errMsg);
+        std::exit(gStaticDoc && gStaticCache.stats().evictions >= 5 ? 0 : 1);
+      },
+      testing::ExitedWithCode(0), "");
+}
+
+TEST(Lazy, Numbers) {
+  ParseOptions opts;
+  opts.lazyNumbers = true;
+  std::string errMsg;
+  // 原文原样输出：不丢失尾随的 0、指数形式和超出 double 精度的位数
+  const char* text = "{\"a\":[1.10,-0,1E+2,12345678901234567890123,0.1000000000000000055511151231257827]}";
+  Json lazy = Json::parse(text, errMsg, opts);
+  ASSERT_EQ(errMsg, "");
+  EXPECT_EQ(lazy.serialize(), text);
+  EXPECT_EQ(lazy["a"][0].numberText(), "1.10");
+  EXPECT_EQ(parseOk(text)["a"][0].numberText(), "");
+
+  // 按数值比较、哈希和读取
+  Json eager = parseOk(text);
+  EXPECT_EQ(lazy, eager);
+  EXPECT_EQ(lazy.hash(), eager.hash());
+  EXPECT_TRUE(lazy["a"][2].isNumber());
+  EXPECT_EQ(lazy["a"][2].toDouble(), 100);
+  EXPECT_EQ(*lazy["a"][0].get_if<double>(), 1.1);
+  EXPECT_EQ(lazy["a"][3].value_or(0.0), 12345678901234567890123.0);
+
+  // 拷贝保留原文，赋值后为普通的数字
+  Json copy = lazy;
+  EXPECT_EQ(copy.serialize(), text);
+  copy.mutableObj()["a"][0] = Json(2.5);
+  EXPECT_EQ(copy["a"][0].numberText(), "");
+  EXPECT_EQ(copy["a"].serialize(), "[2.5,-0,1E+2,12345678901234567890123,0.1000000000000000055511151231257827]");
+
+  // 报错与立即转换时相同
+  for (const char* bad : {"1e309", "-1e309", "[1,01]", "1.", "-", "1e"}) {
+    std::string lazyErr, eagerErr;
+    Json::parse(bad, lazyErr, opts);
+    Json::parse(bad, eagerErr);
+    EXPECT_EQ(lazyErr, eagerErr) << bad;
+  }
+
+  // 原地解析复用原文的缓冲区
+  ParseContext ctx(opts);
+  ASSERT_TRUE(ctx.parse("[1.50,2]", errMsg)) << errMsg;
+  EXPECT_EQ(ctx.root().serialize(), "[1.50,2]");
+  ASSERT_TRUE(ctx.parse("[3.0e0,4]", errMsg)) << errMsg;
+  EXPECT_EQ(ctx.root()[0].toDouble(), 3);
+  EXPECT_EQ(ctx.root().serialize(), "[3.0e0,4]");
+
+  // 多个线程同时第一次读取
+  Json nums = Json::parse("[0.5,0.25,0.125]", errMsg, opts);
+  std::vector<std::thread> threads;
+  std::atomic<int> wrong{0};
+  for (int t = 0; t != 4; ++t) {
+    threads.emplace_back([&] {
+      const Json& view = nums;
+      if (view[1].toDouble() != 0.25) ++wrong;
+    });
+  }
+  for (auto& th : threads) th.join();
+  EXPECT_EQ(wrong, 0);
+}
+
+TEST(Shared, Reload) {
+  std::string errMsg;
+  SharedJson store(parseOk("{\"v\":1}"));
+  SharedJson::Reader reader(store);
+  EXPECT_EQ(reader.get()["v"].toDouble(), 1);
+  EXPECT_EQ(store.version(), 0u);
+
+  // 读者持有的快照在更新后仍然有效
+  SharedJson::Document old = store.load();
+  ASSERT_TRUE(store.reload("{\"v\":2}", errMsg)) << errMsg;
+  EXPECT_EQ((*old)["v"].toDouble(), 1);
+  EXPECT_EQ(reader.get()["v"].toDouble(), 2);
+  EXPECT_EQ(store.version(), 1u);
+
+  // 解析失败时保持当前的文档
+  EXPECT_FALSE(store.reload("{\"v\":", errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "EXPECT VALUE");
+  EXPECT_EQ(store.version(), 1u);
+  EXPECT_EQ(reader.get()["v"].toDouble(), 2);
+
+  store.update([](Json& doc) { doc["w"] = Json(3); });
+  EXPECT_EQ(reader.get(), parseOk("{\"v\":2,\"w\":3}"));
+  EXPECT_EQ((*old)["v"].toDouble(), 1);
+
+  EXPECT_EQ(store.reloadAsync("[4]").get(), "");
+  EXPECT_EQ(reader.get()[0].toDouble(), 4);
+  std::string asyncErr = store.reloadAsync("[4").get();
+  EXPECT_EQ(asyncErr.substr(0, asyncErr.find(':')), "MISS COMMA OR SQUARE BRACKET");
+  EXPECT_EQ(store.version(), 3u);
+}
+
+/**
+ * 多个读者与写者同时运行 (用 -DZZJSON_TSAN=ON 构建时由 ThreadSanitizer 检查)：
+ * 每个快照内部一致 (id 与 items 的长度相同)，读者看到的版本不会倒退
+ */
+TEST(Shared, Stress) {
+  auto makeDoc = [](int id) {
+    std::string text = "{\"id\":" + std::to_string(id) + ",\"items\":[";
+    for (int i = 0; i != id % 16; ++i) text += (i ? ",\"" : "\"") + std::to_string(i) + "\"";
+    return text + "]}";
+  };
+  std::string errMsg;
+  SharedJson store(parseOk(makeDoc(0)));
+  std::atomic<bool> stop{false};
+  std::atomic<int> errors{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t != 8; ++t) {
+    threads.emplace_back([&] {
+      SharedJson::Reader reader(store);
+      int last = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        const Json& doc = reader.get();
+        int id = static_cast<int>(doc["id"].toDouble());
+        if (id < last || doc["items"].size() != static_cast<size_t>(id % 16)) ++errors;
+        last = id;
+      }
+    });
+  }
+  std::thread updater([&] {
+    for (int i = 0; i != 200; ++i) {
+      store.update([](Json& doc) {
+        int id = static_cast<int>(doc["id"].toDouble()) + 1;
+        doc["id"] = Json(id);
+        doc["items"] = Json(Json::_array());
+        for (int k = 0; k != id % 16; ++k) doc["items"].push_back(Json(std::to_string(k)));
+      });
+    }
+  });
+  for (int i = 201; i != 400; ++i) {
+    std::string err;
+    // 与 updater 交错：只有 id 更大时才发布，保持单调
+    store.update([&](Json& doc) {
+      if (doc["id"].toDouble() < i) doc = Json::parse(makeDoc(i), err);
+    });
+  }
+  updater.join();
+  stop = true;
+  for (auto& th : threads) th.join();
+  EXPECT_EQ(errors, 0);
+  EXPECT_EQ(store.version(), 399u);
+  EXPECT_GE((*store.load())["id"].toDouble(), 399);
+}
+
+TEST(Cache, Parse) {
+  ParseCache cache(4, ParseOptions(), 2);
+  std::string errMsg;
+  auto first = cache.parse("{\"beat\":1}", errMsg);
+  ASSERT_TRUE(first) << errMsg;
+  auto second = cache.parse("{\"beat\":1}", errMsg);
+  EXPECT_EQ(first.get(), second.get());   // 命中时返回同一个文档
+  EXPECT_EQ(*second, parseOk("{\"beat\":1}"));
+  EXPECT_NE(cache.parse("{\"beat\":2}", errMsg).get(), first.get());
+
+  CacheStats stats = cache.stats();
+  EXPECT_EQ(stats.hits, 1u);
+  EXPECT_EQ(stats.misses, 2u);
+  EXPECT_EQ(stats.entries, 2u);
+
+  // 解析失败不缓存
+  EXPECT_FALSE(cache.parse("{\"beat\":", errMsg));
+  EXPECT_EQ(errMsg.substr(0, errMsg.find(':')), "EXPECT VALUE");
+  EXPECT_FALSE(cache.parse("{\"beat\":", errMsg));
+  EXPECT_EQ(cache.stats().misses, 4u);
+  EXPECT_EQ(cache.stats().entries, 2u);
+
+  // 超出容量时淘汰最久未使用的，持有的文档仍然有效
+  for (int i = 0; i != 20; ++i) cache.parse("[" + std::to_string(i) + "]", errMsg);
+  stats = cache.stats();
+  EXPECT_LE(stats.entries, 4u);
+  EXPECT_EQ(stats.evictions, 22u - stats.entries);
+  EXPECT_EQ((*first)["beat"].toDouble(), 1);
+  EXPECT_NE(cache.parse("{\"beat\":1}", errMsg).get(), first.get());
+
+  cache.clear();
+  EXPECT_EQ(cache.stats().entries, 0u);
+  EXPECT_EQ(HashBytes("abcdefghij", 10), HashBytes("abcdefghij", 10));
+  EXPECT_NE(HashBytes("abcdefghij", 10), HashBytes("abcdefghik", 10));
+  EXPECT_NE(HashBytes("[1]", 3), HashBytes("[1]", 4));
+}
+
+TEST(Cache, Concurrent) {
+  ParseCache cache(8);
+  std::vector<std::string> docs;
+  for (int i = 0; i != 12; ++i) docs.push_back("{\"id\":" + std::to_string(i) + ",\"a\":[1,2]}");
+  std::atomic<int> wrong{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t != 4; ++t) {
+    threads.emplace_back([&, t] {
+      std::string errMsg;
+      for (int i = 0; i != 2000; ++i) {
+        int k = (i * 7 + t) % 12;
+        auto doc = cache.parse(docs[k], errMsg);
+        if (!doc || (*doc)["id"].toDouble() != k) ++wrong;
+      }
+    });
+  }
+  for (auto& th : threads) th.join();
+  EXPECT_EQ(wrong, 0);
+  CacheStats stats = cache.stats();
+  EXPECT_EQ(stats.hits + stats.misses, 8000u);
+  EXPECT_LE(stats.entries, 8u);
+}